@@ -12,6 +12,7 @@ import hashlib
 import json
 import os
 import re
+import struct
 import sys
 from collections import namedtuple, OrderedDict
 
@@ -38,6 +39,11 @@ DEFAULT_TYPES = {"int" : TypeDescription(4, "int32_t"),
                  "string" : TypeDescription(1, "char*"),
                  }
 
+# struct format of the C++ types which can be stored in a default value image
+STRUCT_FORMATS = {"int8_t" : "b", "uint8_t" : "B", "int16_t" : "h", "uint16_t" : "H",
+                  "int32_t" : "i", "uint32_t" : "I", "int64_t" : "q", "uint64_t" : "Q",
+                  "float" : "f", "double" : "d", "bool" : "?"}
+
 def fbs_to_json_type(fbs):
     """
     Convert known fbs types to JSON types.
@@ -62,11 +68,109 @@ def next_line_indent(file, indent=4):
     file.write('\n' + ' ' * indent)
 
 NEXTLINE = '\n    '
+MAX_INLINE_SIZE = 256 # static-only tables up to this size store their data inline
+ATOMIC_ALIGNMENT = 8 # size of the largest member with atomic accessors
+ATOMIC_STORAGE_DOC = "Throws std::runtime_error if the storage is not allocated or is shared by freeze(); " \
+                     "modify the object before sharing it between threads."
+
+def align(offset, alignment):
+    return (offset + alignment - 1) // alignment * alignment
+
+def next_power_of_two(value):
+    result = 1
+    while result < value:
+        result *= 2
+    return result
+
+def _mix_hash(value):
+    """murmur3 finalizer, see zerobuf::getJSONNameSlot()"""
+    value ^= value >> 16
+    value = (value * 0x85ebca6b) & 0xffffffff
+    value ^= value >> 13
+    value = (value * 0xc2b2ae35) & 0xffffffff
+    return value ^ (value >> 16)
+
+def _hash_name(name):
+    """FNV-1a, see zerobuf::getJSONNameSlot()"""
+    value = 2166136261
+    for char in bytearray(name.encode('utf-8')):
+        value = ((value ^ char) * 16777619) & 0xffffffff
+    return value
+
+
+class PerfectHash():
+    """
+    Collision-free hash table of a set of names, computed at generation time
+    and evaluated at runtime by zerobuf::getJSONNameSlot().
+
+    The names are distributed to buckets by their hash. Each bucket has a
+    displacement seed, searched for largest buckets first, which places all
+    names of the bucket into free slots.
+    """
+    def __init__(self, names):
+        self.names = names
+        self.num_seeds = next_power_of_two(max(1, len(names) // 2))
+        self.num_slots = next_power_of_two(max(1, 2 * len(names)))
+        while not self._build():
+            self.num_slots *= 2
+
+    def _build(self):
+        buckets = [[] for i in range(self.num_seeds)]
+        for name in self.names:
+            hash = _hash_name(name)
+            buckets[_mix_hash(hash) & (self.num_seeds - 1)].append((name, hash))
+
+        self.seeds = [0] * self.num_seeds
+        self.slots = {}
+        used = set()
+        order = sorted(range(self.num_seeds), key=lambda i: -len(buckets[i]))
+        for index in order:
+            if not buckets[index]:
+                break
+            for seed in range(1, 65536):
+                displace = (seed * 0x9e3779b9) & 0xffffffff
+                slots = [_mix_hash(hash ^ displace) & (self.num_slots - 1)
+                         for name, hash in buckets[index]]
+                if len(set(slots)) == len(slots) and used.isdisjoint(slots):
+                    used.update(slots)
+                    self.seeds[index] = seed
+                    for (name, hash), slot in zip(buckets[index], slots):
+                        self.slots[name] = slot
+                    break
+            else:
+                return False
+        return True
+
+    def seeds_declaration(self):
+        return "static const uint16_t seeds[] = {{ {0} }};".format(
+            ", ".join(str(seed) for seed in self.seeds))
+
+    def switch(self, name, size, cases, indent=NEXTLINE):
+        """
+        Dispatch on the given name to the code of the matching case, given as
+        a dict of names to lists of statements.
+        """
+        code = "switch( ::zerobuf::getJSONNameSlot( {0}, {1}, seeds, {2}, {3} ))".\
+               format(name, size, self.num_seeds, self.num_slots) + indent + "{"
+        for key in sorted(self.names, key=lambda key: self.slots[key]):
+            length = len(key.encode('utf-8'))
+            code += indent + "case {0}:".format(self.slots[key])
+            code += indent + "    if( {0} == {1} && ::memcmp( {2}, \"{3}\", {1} ) == 0 )".\
+                    format(size, length, name, key)
+            if len(cases[key]) == 1:
+                code += indent + "        " + cases[key][0]
+            else:
+                code += indent + "    {"
+                for statement in cases[key]:
+                    code += indent + "        " + statement
+                code += indent + "    }"
+            code += indent + "    break;"
+        return code + indent + "default:" + indent + "    break;" + indent + "}"
 
 def create_FBS_parser():
     from pyparsing import (oneOf, Group, ZeroOrMore, Word, alphanums, Keyword,
                            Suppress, Optional, OneOrMore, Literal, nums, Or,
-                           alphas, cppStyleComment)
+                           alphas, cppStyleComment, delimitedList)
 
     fbsBaseType = oneOf(list(DEFAULT_TYPES.keys()))
 
@@ -84,7 +188,11 @@ def create_FBS_parser():
                     fbsBaseType + Suppress( '{' ) + OneOrMore( fbsEnumValue ) +
                     Suppress( '}' ))
 
-    # value:[type] = defaultValue; entries in table
+    # (attribute, ...) of tables and table entries
+    fbsMetadata = Group( Literal( '(' ) + delimitedList( Word( alphas )) +
+                        Suppress( ')' ))
+
+    # value:[type] = defaultValue (attributes); entries in table
     # TODO: support more default values other than numbers and booleans
     fbsType = ( fbsBaseType ^ Word( alphanums ))
     fbsTableArray = ( ( Literal( '[' ) + fbsType + Literal( ']' )) ^
@@ -93,11 +201,12 @@ def create_FBS_parser():
     fbsTableValue = ((fbsType ^ fbsTableArray) +
                      ZeroOrMore(Suppress('=') + Or([Word("true"), Word("false"), Word(nums+"-. ,")])))
     fbsTableEntry = Group( Word( alphanums+"_" ) + Suppress( ':' ) + fbsTableValue +
-                          Suppress( ';' ))
+                          Optional( fbsMetadata ) + Suppress( ';' ))
     fbsTableSpec = ZeroOrMore( fbsTableEntry )
 
-    # table Foo { entries }
+    # table Foo (attributes) { entries }
     fbsTable = Group( Keyword( "table" ) + Word( alphas, alphanums ) +
+                    Optional( fbsMetadata ) +
                     Suppress( '{' ) + fbsTableSpec + Suppress( '}' ))
 
     # root_type foo;
@@ -201,7 +310,7 @@ class Function():
         has_final = re.compile(r" final$").match(self.function)
         
         impl_function = re.sub(r" final$", "", self.function) # remove ' final' keyword
-        impl_function = re.sub(r" = [0-9\.f]+ ", " ", impl_function) # remove default params
+        impl_function = re.sub(r" = [0-9A-Za-z_:\.]+ ", " ", impl_function) # remove default params
 
         next_line(file)
         
@@ -251,6 +360,12 @@ class ClassMember(object):
         """Derived classes may implement this function to declare typedefs"""
         return
 
+    def get_alignment(self):
+        """Natural alignment of the (element) type in the static section"""
+        if self.value_type.is_zerobuf_type:
+            return 8
+        return max(1, min(self.value_type.size, 8))
+
     def write_accessors_declaration(self, file):
         self.write_typedefs(file)
         for function in self.accessor_functions():
@@ -377,18 +492,15 @@ class FixedSizeMember(ClassMember):
         return "{0} _{1};".format(self.value_type.type, self.name)
 
     def from_json(self):
+        """Parse the member from the JSON value 'field'"""
         if self.value_type.is_zerobuf_type:
-            return 'if( ::zerobuf::hasJSONField( json, "{0}" ))'\
-                   '{1}    ::zerobuf::fromJSON( ::zerobuf::getJSONField( json, "{0}" ), _{2} );'.\
-                format(self.json_name, NEXTLINE, self.name)
+            return '::zerobuf::fromJSON( field, _{0} );'.format(self.name)
         # convert enums to their name as a string
         if self.value_type.is_enum_type:
-            return 'if( ::zerobuf::hasJSONField( json, "{2}" ))'\
-                   '{3}    set{0}( {1}( string_to_{1}( ::zerobuf::fromJSON< std::string >( ::zerobuf::getJSONField( json, "{2}" )))));'.\
-                format(self.cxxName, self.value_type.type, self.json_name, NEXTLINE)
-        return 'if( ::zerobuf::hasJSONField( json, "{3}" ))'\
-               '{4}    set{0}( {1}( ::zerobuf::fromJSON< {2} >( ::zerobuf::getJSONField( json, "{3}" ))));'.\
-                format(self.cxxName, self.value_type.type, self.value_type.get_data_type(), self.json_name, NEXTLINE)
+            return 'set{0}( ::zerobuf::enumFromJSON< {1} >( field ));'.\
+                format(self.cxxName, self.value_type.type)
+        return 'set{0}( {1}( ::zerobuf::fromJSON< {2} >( field )));'.\
+                format(self.cxxName, self.value_type.type, self.value_type.get_data_type())
 
     def to_json(self):
         if self.value_type.is_zerobuf_type:
@@ -547,34 +659,29 @@ class FixedSizeArray(ClassMember):
         return "{0} _{1};".format(self.cxxName, self.name)
 
     def from_json(self):
-        fromJSON = 'if( ::zerobuf::hasJSONField( json, "{0}" ))'.format(self.json_name)
-        fromJSON += NEXTLINE + '{'
-        fromJSON += NEXTLINE + '    const Json::Value& field = ::zerobuf::getJSONField( json, "{0}" );'.format(self.json_name)
-
+        """Parse the member from the JSON value 'field'"""
+        fromJSON = []
         if self.value_type.is_zerobuf_type:
             for i in range(0, self.nElems):
-                fromJSON += NEXTLINE + '    ::zerobuf::fromJSON( ::zerobuf::getJSONField( field, {1} ), _{0}[{1}] );'.\
-                    format(self.name, i)
+                fromJSON.append('::zerobuf::fromJSON( ::zerobuf::getJSONField( field, {1} ), _{0}[{1}] );'.
+                                format(self.name, i))
         else:
-            fromJSON += NEXTLINE + '    {0}* array = ({0}*)get{1}();'.\
-                format(self.value_type.get_data_type(), self.cxxName)
+            fromJSON.append('{0}* array = ({0}*)get{1}();'.
+                            format(self.value_type.get_data_type(), self.cxxName))
 
             if self.value_type.is_byte_type:
-                fromJSON += NEXTLINE + '    const std::string& decoded = ::zerobuf::fromJSONBinary( field );'
-                fromJSON += NEXTLINE + '    ::memcpy( array, decoded.data(), std::min( decoded.length(), size_t( {0}ull )));'.format(self.nElems)
+                fromJSON.append('const std::string& decoded = ::zerobuf::fromJSONBinary( field );')
+                fromJSON.append('::memcpy( array, decoded.data(), std::min( decoded.length(), size_t( {0}ull )));'.format(self.nElems))
             elif self.value_type.is_enum_type:
                 for i in range(0, self.nElems):
                     # convert strings back to enum/int values
-                    fromJSON += NEXTLINE + '    array[{0}] = {1}( string_to_{2}('\
-                        '::zerobuf::fromJSON< std::string >( ::zerobuf::getJSONField( field, {0} ))));'.\
-                        format(i, self.value_type.get_data_type(), self.value_type.type)
+                    fromJSON.append('array[{0}] = {1}( ::zerobuf::enumFromJSON< {2} >( ::zerobuf::getJSONField( field, {0} )));'.
+                                    format(i, self.value_type.get_data_type(), self.value_type.type))
             else:
                 for i in range(0, self.nElems):
-                    fromJSON += NEXTLINE + '    array[{0}] = ::zerobuf::fromJSON< {1} >( ::zerobuf::getJSONField( field, {0} ));'.\
-                        format(i, self.value_type.get_data_type())
-
-        fromJSON += NEXTLINE + '}'
-        return fromJSON
+                    fromJSON.append('array[{0}] = ::zerobuf::fromJSON< {1} >( ::zerobuf::getJSONField( field, {0} ));'.
+                                    format(i, self.value_type.get_data_type()))
+        return NEXTLINE.join(fromJSON)
 
     def to_json(self):
         toJSON = '{'
@@ -634,9 +741,8 @@ class DynamicZeroBufMember(ClassMember):
         return "{0} _{1};".format(self.value_type.type, self.name)
 
     def from_json(self):
-        return 'if( ::zerobuf::hasJSONField( json, "{0}" ))'\
-               '{1}    ::zerobuf::fromJSON( ::zerobuf::getJSONField( json, "{0}" ), _{2} );'.\
-            format(self.json_name, NEXTLINE, self.name)
+        """Parse the member from the JSON value 'field'"""
+        return '::zerobuf::fromJSON( field, _{0} );'.format(self.name)
 
     def to_json(self):
         return '::zerobuf::toJSON( static_cast< const ::zerobuf::Zerobuf& >( _{0} ), ::zerobuf::getJSONField( json, "{1}" ));'.\
@@ -728,17 +834,34 @@ class DynamicMember(ClassMember):
                         "return std::string( ptr, ptr + getAllocator().template getItem< uint64_t >( {0} ));".\
                         format(self.allocator_offset + 8))
 
+    def string_view_getter(self):
+        return Function("::zerobuf::StringView",
+                        "get{0}View() const".format(self.cxxName),
+                        "return ::zerobuf::StringView( _{0}.data(), _{0}.size( ));".format(self.name),
+                        DoxygenDoc(["Get a view on the {0} string without copying it.".format(self.cxxName),
+                                    "The view is invalidated by any modification of {0}.".format(self.cxxName)],
+                                   [], "a view on the characters of {0}, not null-terminated.".format(self.cxxName)))
+
+    def array_view_getter(self):
+        view_type = "::zerobuf::ArrayView< {0} >".format(self.value_type.type)
+        return Function(view_type,
+                        "get{0}View() const".format(self.cxxName),
+                        "return {0}( _{1}.data(), _{1}.size( ));".format(view_type, self.name),
+                        DoxygenDoc(["Get a view on the {0} dynamic array without copying it.".format(self.cxxName),
+                                    "The view is invalidated by any modification of {0}.".format(self.cxxName)],
+                                   [], "a view on the elements of {0}.".format(self.cxxName)))
+
     def string_setter(self, qproperty=False):
-        current_value = "get{0}String()".format(self.cxxName)
+        current_value = "get{0}View()".format(self.cxxName)
         return Function("void",
-                        "set{0}( const std::string& value )".format(self.cxxName),
+                        "set{0}( ::zerobuf::StringView value )".format(self.cxxName),
                         (self.check_value_changed(current_value) if qproperty else "") +
-                        "_copyZerobufArray( value.c_str(), value.length(), {0} );".\
+                        "_copyZerobufArray( value.data(), value.size(), {0} );".\
                         format(self.dynamic_type_index) + NEXTLINE +
                         "notifyChanged();" + self.emit_value_changed(qproperty),
-                        DoxygenDoc(["Set the value of the {0} dynamic object from a std::string.".format(self.cxxName),
+                        DoxygenDoc(["Set the value of the {0} dynamic object from a string view.".format(self.cxxName),
                                     "notifyChanged() is internally called after the data has been copied."],
-                                   ["value a std::string with the data to be set"]))
+                                   ["value a std::string, character literal or string view with the data to be set"]))
 
     def getters(self):
         if self.value_type.is_zerobuf_type: # Dynamic array of (static) Zerobufs
@@ -749,12 +872,14 @@ class DynamicMember(ClassMember):
         if self.value_type.is_string:
             return [self.ref_getter(self.classname),
                     self.const_ref_getter(self.classname),
-                    self.string_getter()]
+                    self.string_getter(),
+                    self.string_view_getter()]
 
         # Dynamic array of PODs
         return [self.ref_getter(self.classname),
                 self.const_ref_getter(self.classname),
-                self.vector_pod_getter()]
+                self.vector_pod_getter(),
+                self.array_view_getter()]
 
     def const_getters(self):
         if self.value_type.is_zerobuf_type: # Dynamic array of (static) Zerobufs
@@ -763,11 +888,13 @@ class DynamicMember(ClassMember):
 
         if self.value_type.is_string:
             return [self.const_ref_getter(self.classname),
-                    self.string_getter()]
+                    self.string_getter(),
+                    self.string_view_getter()]
 
         # Dynamic array of PODs
         return [self.const_ref_getter(self.classname),
-                self.vector_pod_getter()]
+                self.vector_pod_getter(),
+                self.array_view_getter()]
 
     def setters(self, qproperty=False):
         if self.value_type.is_zerobuf_type: # Dynamic array of (static) Zerobufs
@@ -791,6 +918,7 @@ class DynamicMember(ClassMember):
                     self.const_ref_getter(self.classname),
                     self.c_pointer_setter(),
                     self.string_getter(),
+                    self.string_view_getter(),
                     self.string_setter()]
 
         # Dynamic array of PODs
@@ -798,6 +926,7 @@ class DynamicMember(ClassMember):
                 self.const_ref_getter(self.classname),
                 self.c_pointer_setter(),
                 self.vector_pod_getter(),
+                self.array_view_getter(),
                 self.vector_pod_setter()]
 
     def get_byte_size(self):
@@ -830,17 +959,12 @@ class DynamicMember(ClassMember):
                    format(self.value_type.type, self.cxxName))
 
     def from_json(self):
+        """Parse the member from the JSON value 'field'"""
         if self.value_type.is_string:
-            return 'if( ::zerobuf::hasJSONField( json, "{1}" ))'\
-                   '{2}    set{0}( ::zerobuf::fromJSON< std::string >( ::zerobuf::getJSONField( json, "{1}" )));'\
-                   .format(self.cxxName, self.json_name, NEXTLINE)
+            return 'set{0}( ::zerobuf::fromJSON< std::string >( field ));'.format(self.cxxName)
         if self.value_type.is_byte_type:
-            return 'if( ::zerobuf::hasJSONField( json, "{0}" ))'\
-                   '{1}    _{2}.fromJSONBinary( ::zerobuf::getJSONField( json, "{0}" ));'\
-                   .format(self.json_name, NEXTLINE, self.name)
-        return 'if( ::zerobuf::hasJSONField( json, "{0}" ))'\
-               '{1}    _{2}.fromJSON( ::zerobuf::getJSONField( json, "{0}" ));'\
-               .format(self.json_name, NEXTLINE, self.name)
+            return '_{0}.fromJSONBinary( field );'.format(self.name)
+        return '_{0}.fromJSON( field );'.format(self.name)
 
     def to_json(self):
         if self.value_type.is_string:
@@ -861,6 +985,7 @@ class FbsEnum():
         # json schema uses string representation of enum values
         # to be more user-friendly
         self.to_string = self.to_string()
+        self.from_chars = self.from_chars()
         self.from_string = self.from_string()
         self.ostream = self.ostream()
 
@@ -884,13 +1009,20 @@ class FbsEnum():
                         '{0}default: throw std::runtime_error( "{2}" );{0}}}'
                         .format(NEXTLINE, NEXTLINE.join(strs), 'Unknown value for enum {0}'.format(self.name)), split=True)
 
+    def from_chars(self):
+        """Lookup of the enum names in a perfect hash table"""
+        names = [enumValue[0] for enumValue in self.values]
+        cases = dict((name, ['return {0}::{1};'.format(self.name, name)])
+                     for name in names)
+        table = PerfectHash(names)
+        return Function(self.name, 'string_to_{0}( const char* val, const size_t size )'.format(self.name),
+                        table.seeds_declaration() + NEXTLINE +
+                        table.switch('val', 'size', cases) + NEXTLINE +
+                        'throw std::runtime_error( "Cannot convert string to enum {0}" );'.format(self.name), split=True)
+
     def from_string(self):
-        strs = []
-        for enumValue in self.values:
-            strs.append('if( val == "{1}" ) return {0}::{1};'.format(self.name, enumValue[0]))
         return Function(self.name, 'string_to_{0}( const std::string& val )'.format(self.name),
-                        '{0}{1}throw std::runtime_error( "{2}" );'
-                        .format(NEXTLINE.join(strs), NEXTLINE, 'Cannot convert string to enum {0}'.format(self.name)), split=True)
+                        'return string_to_{0}( val.data(), val.size( ));'.format(self.name), split=True)
 
     def enum_to_string(self, namespaces):
         """ Specialization for zerobuf::to_string() used in Vector.h """
@@ -904,6 +1036,12 @@ class FbsEnum():
                         'string_to_enum( const std::string& val )',
                         'return {0}::string_to_{1}( val );'.format(namespaces, self.name), split=True)
 
+    def chars_to_enum(self, namespaces):
+        """ Specialization for zerobuf::string_to_enum() used by enumFromJSON() """
+        return Function('template<> {0}::{1}'.format(namespaces, self.name),
+                        'string_to_enum( const char* val, size_t size )',
+                        'return {0}::string_to_{1}( val, size );'.format(namespaces, self.name), split=True)
+
     def ostream(self):
         return Function('std::ostream&',
                         'operator << ( std::ostream& os, const {0}& val )'.format(self.name),
@@ -919,12 +1057,14 @@ class FbsEnum():
         header.write("\n};\n")
 
         self.to_string.write_declaration(file)
+        self.from_chars.write_declaration(file)
         self.from_string.write_declaration(file)
         self.ostream.write_declaration(file)
         header.write('\n\n')
 
     def write_implementation(self, file):
         self.to_string.write_implementation(file)
+        self.from_chars.write_implementation(file)
         self.from_string.write_implementation(file)
         self.ostream.write_implementation(file)
 
@@ -932,11 +1072,13 @@ class FbsEnum():
         """ Declarations for zerobuf::to_string() and zerobuf::string_to_enum() """
         self.enum_to_string(namespaces).write_declaration(file)
         self.string_to_enum(namespaces).write_declaration(file)
+        self.chars_to_enum(namespaces).write_declaration(file)
 
     def write_string_conversion_implementation(self, file, namespaces):
         """ Definitions for zerobuf::to_string() and zerobuf::string_to_enum() """
         self.enum_to_string(namespaces).write_implementation(file)
         self.string_to_enum(namespaces).write_implementation(file)
+        self.chars_to_enum(namespaces).write_implementation(file)
 
 
 def _add_base64_string(property):
@@ -1028,9 +1170,14 @@ class JsonSchemaProperties():
 class FbsTable():
     """An fbs Table (class) which can be written to a C++ implementation."""
 
-    def __init__(self, name, attributes, namespace, fbsFile):
+    def __init__(self, name, attributes, namespace, fbsFile, metadata=[],
+                 member_metadata={}):
         self.name = name
         self.attributes = attributes
+        self.compact = "compact" in metadata
+        self.key_names = [member for member, attributes in member_metadata.items()
+                          if "key" in attributes]
+        self.key = None # static member used by the key access functions
         self.namespace = namespace
         self.offset = 0
         self.dynamic_members = []
@@ -1038,8 +1185,21 @@ class FbsTable():
         self.all_members = []
         self.initializers = []
         self.default_value_setters = []
+        self.default_values = [] # (member, value, setter)
+        self.default_images = None # little and big endian static section
+        self.default_setters = [] # for defaults not in the default images
+        self.nested_resets = [] # dynamic nested members with default values
+        self.builder_resets = [] # nested members with defaults not in their image
+        self.builder_defaults = [] # initial builder range of each dynamic member
+        self.version_offsets = []
+        self.compact_dynamics = [] # nested table of each dynamic member or None
         self.md5 = hashlib.md5()
         self.generate_qobject = fbsFile.generate_qobject
+        self.atomic = fbsFile.atomic
+        self.alignment = fbsFile.alignment
+        if self.atomic: # atomic accessors on vector elements and nested tables
+            self.alignment = max(self.alignment, ATOMIC_ALIGNMENT)
+        self.aligned = self.atomic or self.alignment > 0
 
         self.json_schema = OrderedDict()
         self.json_schema['$schema'] = 'http://json-schema.org/schema#'
@@ -1050,14 +1210,33 @@ class FbsTable():
         self.json_schema['additionalProperties'] = False
 
         self.parse_members(fbsFile)
+        self.set_key()
         self.compute_offsets()
         self.compute_md5()
+        self.compute_default_images(fbsFile)
+        self.compute_builder_defaults(fbsFile)
         self.fill_initializer_list()
 
     def has_data(self):
         # return true if the table has data
         return self.offset != 0
 
+    def has_inline_storage(self):
+        """Small static-only tables keep their data inside the object"""
+        return self.has_data() and len(self.dynamic_members) == 0 and \
+               self.offset <= MAX_INLINE_SIZE
+
+    def get_inline_storage_base(self):
+        if self.alignment > 0:
+            return "::zerobuf::InlineStorage< {0}, {1} >".format(self.offset, self.alignment)
+        return "::zerobuf::InlineStorage< {0} >".format(self.offset)
+
+    def get_inline_storage_args(self):
+        """Inline storage as leading arguments of the Zerobuf ctor"""
+        if self.has_inline_storage():
+            return "_inlineData, sizeof( _inlineData ), "
+        return ""
+
     def is_dynamic(self, attrib, fbsFile):
         #  field is a sub-struct and field size is dynamic (==0)
         if attrib[1] in fbsFile.table_names and fbsFile.types[attrib[1]].size == 0:
@@ -1085,6 +1264,7 @@ class FbsTable():
             value_type = ValueType(cxxtype, cxxtype_size, is_zerobuf_type, is_enum_type, is_byte_type)
 
             if self.is_dynamic(attrib, fbsFile):
+                self.compact_dynamics.append(cxxtype if is_zerobuf_type else None)
                 if len(attrib) == 2 and is_zerobuf_type:
                     member = DynamicZeroBufMember(name, value_type, dynamic_type_index)
                     json_schema.dynamic_zerobuf(name, cxxtype)
@@ -1101,6 +1281,7 @@ class FbsTable():
                         default_values = attrib[2]
                         setter = "set{0}({1}( {2} ));".format(member.cxxName, cxxtype, default_values)
                         self.default_value_setters.append(setter)
+                        self.default_values.append((member, default_values, setter))
                 else:
                     elem_count = int(attrib[4])
                     member = FixedSizeArray(name, value_type, elem_count, self.name)
@@ -1110,16 +1291,246 @@ class FbsTable():
             self.all_members.append(member)
             self.json_schema['properties'] = json_schema.properties
 
+    def set_key(self):
+        if len(self.key_names) == 0:
+            return
+        if len(self.key_names) > 1:
+            sys.exit("Table {0} has more than one key".format(self.name))
+        if len(self.dynamic_members) > 0:
+            sys.exit("Key of table {0} with dynamic members".format(self.name))
+        for member in self.static_members:
+            if member.name == self.key_names[0]:
+                if not isinstance(member, FixedSizeMember) or \
+                   member.value_type.is_zerobuf_type:
+                    sys.exit("Key {0}.{1} is not a scalar".format(self.name, member.name))
+                self.key = member
+
     def compute_offsets(self):
         self.offset = 4 # 4b version header in host endianness
         for member in self.dynamic_members:
             member.allocator_offset = self.offset
             self.offset += member.get_byte_size()
         for member in self.static_members:
+            if self.aligned: # natural alignment of static members
+                self.offset = align(self.offset, member.get_alignment())
             member.allocator_offset = self.offset
             self.offset += member.get_byte_size()
         if self.offset == 4: # OPT: table has no data
             self.offset = 0
+        elif self.aligned: # keep alignment in arrays of this table
+            self.offset = align(self.offset, 8)
+
+    def compute_default_images(self, fbsFile):
+        """Precompute the static section with all default values in both byte
+           orders, used for construction and resetToDefaults()"""
+        if not self.has_data():
+            return
+
+        self.default_images = [bytearray(self.offset), bytearray(self.offset)]
+        self.version_offsets = [0]
+        for member in self.static_members:
+            if not member.value_type.is_zerobuf_type:
+                continue
+            nested = fbsFile.get_table(member.value_type.type)
+            count = member.nElems if isinstance(member, FixedSizeArray) else 1
+            for i in range(count):
+                offset = member.allocator_offset + i * nested.offset
+                for image, nested_image in zip(self.default_images, nested.default_images):
+                    image[offset:offset + nested.offset] = nested_image
+                self.version_offsets += [offset + v for v in nested.version_offsets]
+
+        for member, value, setter in self.default_values:
+            if not self.pack_default_value(member, value, fbsFile):
+                self.default_setters.append(setter)
+        self.compute_nested_defaults(fbsFile)
+
+    def compute_builder_defaults(self, fbsFile):
+        """Builders start with empty dynamic members and nested members
+           initialized from their default image"""
+        for member in self.dynamic_members:
+            nested = None
+            if isinstance(member, DynamicZeroBufMember):
+                nested = fbsFile.get_table(member.value_type.type)
+            if nested and nested.has_data():
+                self.builder_defaults.append("{{ _defaults{0}, {1} }}".format(nested.name, nested.offset))
+            else:
+                self.builder_defaults.append("{ nullptr, 0 }")
+
+    def compute_nested_defaults(self, fbsFile):
+        """Nested members use embedded allocators and leave their defaults to
+           the parent: prepend their setters on the nested member objects,
+           which are mutable also in Qt mode"""
+        value_setters = []
+        setters = []
+        for member in self.dynamic_members:
+            if not isinstance(member, DynamicZeroBufMember):
+                continue
+            nested = fbsFile.get_table(member.value_type.type)
+            value_setters += ["_{0}.{1}".format(member.name, setter)
+                              for setter in nested.default_value_setters]
+            if len(nested.default_value_setters) > 0:
+                self.nested_resets.append("_{0}.resetToDefaults();".format(member.name))
+            if len(nested.default_setters) > 0 or len(nested.nested_resets) > 0:
+                self.builder_resets.append(member)
+        for member in self.static_members:
+            if not member.value_type.is_zerobuf_type:
+                continue
+            nested = fbsFile.get_table(member.value_type.type)
+            if isinstance(member, FixedSizeArray):
+                prefixes = ["_{0}[{1}].".format(member.name, i)
+                            for i in range(member.nElems)]
+            else:
+                prefixes = ["_{0}.".format(member.name)]
+            for prefix in prefixes:
+                value_setters += [prefix + setter for setter in nested.default_value_setters]
+                setters += [prefix + setter for setter in nested.default_setters]
+        self.default_value_setters = value_setters + self.default_value_setters
+        self.default_setters = setters + self.default_setters
+
+    def pack_default_value(self, member, value, fbsFile):
+        """Write a default value into the default images, return False if the
+           value can't be stored statically"""
+        fields = [(member.allocator_offset, member, value)]
+        if member.value_type.is_zerobuf_type: # nested default, ctor arguments
+            nested = fbsFile.get_table(member.value_type.type)
+            args = value.split(',')
+            if len(args) != len(nested.all_members):
+                return False
+            fields = [(member.allocator_offset + field.allocator_offset, field, arg)
+                      for field, arg in zip(nested.all_members, args)]
+
+        packed = []
+        for offset, field, arg in fields:
+            if not isinstance(field, FixedSizeMember) or field.value_type.is_zerobuf_type:
+                return False
+            cxxtype = field.value_type.type
+            fmt = "i" if field.value_type.is_enum_type else STRUCT_FORMATS.get(cxxtype)
+            if fmt is None:
+                return False
+            arg = arg.strip()
+            try:
+                if arg in ["true", "false"]:
+                    number = 1 if arg == "true" else 0
+                elif any(c in arg for c in ".eE"):
+                    number = float(arg)
+                else:
+                    number = int(arg)
+                if fmt in "fd":
+                    number = float(number)
+                elif fmt == "?":
+                    number = bool(number)
+                else:
+                    number = int(number) # C++ truncates towards zero
+                packed.append((offset, struct.pack("<" + fmt, number),
+                               struct.pack(">" + fmt, number)))
+            except (ValueError, struct.error):
+                return False
+
+        for offset, little, big in packed:
+            self.default_images[0][offset:offset + len(little)] = little
+            self.default_images[1][offset:offset + len(big)] = big
+        return True
+
+    def write_default_images(self, file):
+        if not self.has_data():
+            return
+
+        def format_image(image, shifts):
+            values = []
+            i = 0
+            while i < len(image):
+                if i in self.version_offsets:
+                    values += ["uint8_t( ZEROBUF_VERSION_ABI >> {0} )".format(shift)
+                               for shift in shifts]
+                    i += 4
+                else:
+                    values.append("0x{0:02x}".format(image[i]))
+                    i += 1
+            lines = [", ".join(values[j:j + 8]) for j in range(0, len(values), 8)]
+            return "    " + ",\n    ".join(lines)
+
+        name = "_defaults" + self.name
+        file.write("namespace\n{\n")
+        file.write("// static section with default values of {0}\n".format(self.name))
+        file.write("#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__\n")
+        file.write("constexpr uint8_t {0}[] = {{\n{1}\n}};\n".
+                   format(name, format_image(self.default_images[1], [24, 16, 8, 0])))
+        file.write("#else\n")
+        file.write("constexpr uint8_t {0}[] = {{\n{1}\n}};\n".
+                   format(name, format_image(self.default_images[0], [0, 8, 16, 24])))
+        file.write("#endif\n}\n")
+
+    def write_compact_layout(self, file):
+        """Layout of the standard binary for the compact wire format"""
+        name = "_compactLayout" + self.name
+        versions = sorted(self.version_offsets[1:])
+        file.write("// layout of {0} for the compact wire format\n".format(self.name))
+        if len(versions) > 0:
+            file.write("const size_t _compactVersions{0}[] = {{ {1} }};\n".
+                       format(self.name, ", ".join(str(v) for v in versions)))
+        if any(self.compact_dynamics):
+            dynamics = ["&_compactLayout" + table if table else "nullptr"
+                        for table in self.compact_dynamics]
+            file.write("const ::zerobuf::CompactLayout* const _compactDynamics{0}[] = {{\n    {1}\n}};\n".
+                       format(self.name, ",\n    ".join(dynamics)))
+        file.write("const ::zerobuf::CompactLayout {0} = {{\n    {1}, {2}, {3},\n    {4}, {5},\n    {6}\n}};\n".
+                   format(name, self.offset, len(self.dynamic_members),
+                          max(self.alignment, 1),
+                          "_compactVersions" + self.name if versions else "nullptr",
+                          len(versions),
+                          "_compactDynamics" + self.name if any(self.compact_dynamics) else "nullptr"))
+
+    def compact_format_functions(self):
+        """Explicit conversion to and from the compact wire format"""
+        if not self.compact:
+            return []
+
+        layout = "_compactLayout" + self.name
+        return [
+            Function("std::vector< uint8_t >", "toCompactBinary() const",
+                     "return ::zerobuf::toCompactBinary( *this, {0} );".format(layout),
+                     DoxygenDoc(["Convert to the compact wire format, see zerobuf/compact.h."],
+                                ret="the compact binary.")),
+            Function("bool", "fromCompactBinary( const void* data, const size_t size )",
+                     "return ::zerobuf::fromCompactBinary( *this, {0}, data, size );".format(layout),
+                     DoxygenDoc(["Set the content from a binary in the compact wire format.",
+                                 "@throw std::runtime_error on a version mismatch or an invalid binary"],
+                                ["data the compact binary",
+                                 "size the size of the compact binary"],
+                                "the result of fromBinary() on the converted binary.")),
+            Function("const ::zerobuf::CompactLayout&", "ZEROBUF_COMPACT_LAYOUT()",
+                     "return {0};".format(layout),
+                     DoxygenDoc(["The layout for the conversion to the compact wire format."]),
+                     static=True)]
+
+    def reset_function(self):
+        # nested dynamic zerobufs keep their allocation and are reset in place
+        nested = [member for member in self.dynamic_members
+                  if isinstance(member, DynamicZeroBufMember)]
+        body = ""
+        if len(nested) > 0:
+            body += "uint8_t* data = getAllocator().getData();"
+            for member in nested:
+                body += NEXTLINE + "uint64_t {0}Header[2];".format(member.name)
+                body += NEXTLINE + "::memcpy( {0}Header, data + {1}, 16 );".\
+                    format(member.name, member.allocator_offset)
+            body += NEXTLINE + "::memcpy( data, _defaults{0}, {1} );".format(self.name, self.offset)
+            for member in nested:
+                body += NEXTLINE + "::memcpy( data + {1}, {0}Header, 16 );".\
+                    format(member.name, member.allocator_offset)
+            body += NEXTLINE + "getAllocator().notifyReset();"
+            for member in nested:
+                body += NEXTLINE + "_{0}.resetToDefaults();".format(member.name)
+        else:
+            body += "::memcpy( getAllocator().getData(), _defaults{0}, {1} );".format(self.name, self.offset)
+            body += NEXTLINE + "getAllocator().notifyReset();"
+        for setter in self.default_setters:
+            body += NEXTLINE + setter
+        body += NEXTLINE + "notifyChanged();"
+        return Function("void", "resetToDefaults()", body,
+                        DoxygenDoc(["Reset all members to their default value.",
+                                    "Dynamic members are cleared; their memory is reclaimed by compact() " +
+                                    "or the compaction policy."]))
 
     def compute_md5(self):
         for namespace in self.namespace:
@@ -1129,6 +1540,16 @@ class FbsTable():
             self.md5.update(member.get_unique_identifier())
         for member in self.static_members:
             self.md5.update(member.get_unique_identifier())
+        if self.aligned:
+            self.md5.update(b"aligned")
+        if self.alignment > 0:
+            self.md5.update("align{0}".format(self.alignment).encode('utf-8'))
+
+    def get_alignment_arg(self):
+        """Alignment of dynamic allocations as additional allocator argument"""
+        if self.alignment > 0:
+            return ", {0}".format(self.alignment)
+        return ""
 
     def get_virtual_destructor(self):
         return Function(None, "~" + self.name + "()", "{}", virtual=True)
@@ -1147,11 +1568,17 @@ class FbsTable():
 
     def special_member_functions(self):
         functions = []
-        allocator_init = ": {0}( ::zerobuf::AllocatorPtr( new ::zerobuf::NonMovingAllocator( {1}, {2} )))\n". \
-                                       format(self.name, self.offset, len(self.dynamic_members))
+        # initialize own storage from the default image, views use the default value setters
+        allocator_init = ": ::zerobuf::Zerobuf( {4}_defaults{0}, {1}, {2}{3} )\n". \
+                                       format(self.name, self.offset, len(self.dynamic_members), self.get_alignment_arg(),
+                                              self.get_inline_storage_args()) + \
+                                       self.get_initializer_list()
         # default ctor
+        setters = self.nested_resets + self.default_setters
         functions.append(Function(None, "{0}()".format(self.name),
-                                  allocator_init + "{}"))
+                                  allocator_init + "{" +
+                                  "".join([NEXTLINE + setter for setter in setters]) +
+                                  ("\n}" if len(setters) > 0 else "}")))
         # member initialization ctor
         memberArgs = []
         setters = []
@@ -1165,10 +1592,13 @@ class FbsTable():
                                   "{" + NEXTLINE +
                                   NEXTLINE.join(setters) +
                                   "\n}"))
-        # copy ctor
+        # copy ctor, the inline storage is not copied
+        copy_init = allocator_init
+        if self.has_inline_storage():
+            copy_init = ": {0}(),{1}".format(self.get_inline_storage_base(), allocator_init[1:])
         functions.append(Function(None,
                                   "{0}( const {0}& rhs )".format(self.name),
-                                  allocator_init +
+                                  copy_init +
                                   "{\n" +
                                   "    *this = rhs;\n" +
                                   "}"))
@@ -1176,8 +1606,10 @@ class FbsTable():
         functions.append(Function(None,
                                   "{0}( {0}&& rhs ){1}".format(self.name,\
                                   " throw()" if os.name == "nt" else " noexcept"),
-                                  ": ::zerobuf::Zerobuf( std::move( rhs ))\n" +
-                                  self.get_move_initializer()))
+                                  ": ::zerobuf::Zerobuf( std::move( rhs ){0})\n".format(
+                                      ", _inlineData, sizeof( _inlineData )" if self.has_inline_storage() else "") +
+                                  self.get_initializer_list() +
+                                  "{\n" + self.get_move_rebinds("rhs.") + "}"))
         # copy-from-baseclass ctor
         functions.append(Function(None,
                                   "{0}( const ::zerobuf::Zerobuf& rhs )".format(self.name),
@@ -1185,18 +1617,19 @@ class FbsTable():
                                   "{\n" +
                                   "    ::zerobuf::Zerobuf::operator = ( rhs );\n" +
                                   "}"))
-        # Zerobuf object owns allocator!
+        # Zerobuf object owns allocator! Embedded ones are initialized by the parent
         functions.append(Function(None,
                                   "{0}( ::zerobuf::AllocatorPtr allocator )".format(self.name),
                                   ": ::zerobuf::Zerobuf( std::move( allocator ))\n" +
                                   self.get_initializer_list() +
-                                  "{" + (NEXTLINE + "if( !getAllocator().isMutable( ))\n        return;\n" +
+                                  "{" + (NEXTLINE + "if( hasEmbeddedAllocator() || !getAllocator().isMutable( ))\n        return;\n" +
                                   NEXTLINE if len(self.default_value_setters) > 0 else "") +
                                   NEXTLINE.join(self.default_value_setters) +
                                   "\n}",
                                   explicit = True))
 
         functions.append(self.get_virtual_destructor())
+        functions.append(self.reset_function())
 
         # copy ctor and copy assignment operator
         functions.append(Function(self.name+"&",
@@ -1210,6 +1643,83 @@ class FbsTable():
                                   "    return *this;"))
         return functions
 
+    def builder_constructor(self):
+        """Private ctor of the builder, taking the data of all dynamic members"""
+        allocator_init = ": ::zerobuf::Zerobuf( _defaults{0}, dynamics, {1}, {2}{3} )\n". \
+                                       format(self.name, self.offset, len(self.dynamic_members), self.get_alignment_arg()) + \
+                                       self.get_initializer_list()
+        setters = ["if( dynamics[{0}].data == _defaults{1} )".format(member.dynamic_type_index, member.value_type.type) +
+                   NEXTLINE + "    _{0}.resetToDefaults();".format(member.name)
+                   for member in self.builder_resets] + self.default_setters
+        return Function(None, "{0}( const ::zerobuf::DynamicRange* dynamics )".format(self.name),
+                        allocator_init + "{" +
+                        "".join([NEXTLINE + setter for setter in setters]) +
+                        ("\n}" if len(setters) > 0 else "}"),
+                        explicit=True)
+
+    def builder_functions(self):
+        builder = self.name + "::Builder"
+        functions = [Function(None, "Builder()",
+                              ": _dynamics{{ {0} }}\n{{}}".format(", ".join(self.builder_defaults)))]
+        for member in self.dynamic_members:
+            index = member.dynamic_type_index
+            if isinstance(member, DynamicZeroBufMember):
+                functions.append(Function(builder + "&",
+                                          "set{0}( const {1}& value )".format(member.cxxName, member.value_type.type),
+                                          "_sources[{0}] = value.toBinary();".format(index) + NEXTLINE +
+                                          "_dynamics[{0}] = {{ _sources[{0}].ptr.get(), _sources[{0}].size }};".format(index) + NEXTLINE +
+                                          "return *this;"))
+                continue
+
+            elem_size = "sizeof( {0} )".format(member.value_type.type)
+            if member.value_type.is_zerobuf_type:
+                elem_size = "{0}::ZEROBUF_STATIC_SIZE()".format(member.value_type.type)
+            else:
+                container = "::zerobuf::StringView" if member.value_type.is_string else member.vector_type()
+                functions.append(Function(builder + "&",
+                                          "set{0}( {1} const * values, size_t size )".format(member.cxxName, member.value_type.type),
+                                          "_dynamics[{0}] = {{ values, size * {1} }};".format(index, elem_size) + NEXTLINE +
+                                          "return *this;"))
+                name = "value" if member.value_type.is_string else "values"
+                argument = container if member.value_type.is_string else "const {0}&".format(container)
+                functions.append(Function(builder + "&",
+                                          "set{0}( {1} {2} )".format(member.cxxName, argument, name),
+                                          "return set{0}( {1}.data(), {1}.size( ));".format(member.cxxName, name)))
+            functions.append(Function(builder + "&",
+                                      "resize{0}( size_t size )".format(member.cxxName),
+                                      "_dynamics[{0}] = {{ nullptr, size * {1} }};".format(index, elem_size) + NEXTLINE +
+                                      "return *this;"))
+        functions.append(Function(self.name, "build() const",
+                                  "return {0}( _dynamics );".format(self.name)))
+        return functions
+
+    def write_builder_declaration(self, file):
+        if len(self.dynamic_members) == 0:
+            return
+
+        next_line(file)
+        next_line_indent(file)
+        file.write("/**" + NEXTLINE +
+                   " * Builds {0} objects with all dynamic members in a single allocation.".format(self.name) + NEXTLINE +
+                   " *" + NEXTLINE +
+                   " * The setters only reference the given data, which has to stay valid" + NEXTLINE +
+                   " * until build(); the binary of nested objects is kept by the builder." + NEXTLINE +
+                   " * resize() reserves zero-filled dynamic members. Static members have" + NEXTLINE +
+                   " * their default value and are set on the built object." + NEXTLINE +
+                   " */" + NEXTLINE +
+                   "class Builder" + NEXTLINE + "{" + NEXTLINE + "public:")
+        indent = NEXTLINE + "    "
+        for function in self.builder_functions():
+            if function.function == "build() const":
+                file.write(indent + "/** @return a new, compact {0} with the given dynamic members. */".format(self.name))
+            file.write(indent + function.definition().replace(self.name + "::Builder", "Builder"))
+        file.write("\n" + NEXTLINE + "private:" + indent +
+                   "::zerobuf::DynamicRange _dynamics[{0}];".format(len(self.dynamic_members)))
+        if any(isinstance(member, DynamicZeroBufMember) for member in self.dynamic_members):
+            file.write(indent + "::zerobuf::Data _sources[{0}]; // binary of nested objects".
+                       format(len(self.dynamic_members)))
+        file.write(NEXTLINE + "};")
+
     def introspection_functions(self):
         digest = self.md5.hexdigest()
         high = digest[ 0 : len( digest ) - 16 ]
@@ -1246,35 +1756,249 @@ class FbsTable():
                                       'return Const{0}Ptr( new {0}( ::zerobuf::AllocatorPtr( ' \
                                       'new ::zerobuf::ConstAllocator( reinterpret_cast< const uint8_t* >( data ), size ))));'
                                       .format(self.name), static=True, split=False))
+            functions.append(Function('Const{0}Ptr'.format(self.name),
+                                      'create( const ::zerobuf::Data& data )',
+                                      'return Const{0}Ptr( new {0}( ::zerobuf::AllocatorPtr( ' \
+                                      'new ::zerobuf::ConstAllocator( data.ptr, data.size ))));'
+                                      .format(self.name),
+                                      DoxygenDoc(["Create a read-only {0} sharing the ownership of the given data.".format(self.name),
+                                                  "The data is not copied and stays valid as long as the returned object."]),
+                                      static=True, split=False))
+            functions.append(Function('std::shared_ptr< const {0} >'.format(self.name),
+                                      'freeze() const',
+                                      'return std::shared_ptr< const {0} >( create( _freeze( )));'.format(self.name),
+                                      DoxygenDoc(["Create an immutable snapshot sharing the data of this object.",
+                                                  "The snapshot is readable from any thread. While it is alive, the next",
+                                                  "modification of this object copies its data first. Atomic modifications",
+                                                  "throw until the data is copied by a non-atomic one, and must not run",
+                                                  "concurrently to freeze()."]),
+                                      split=False))
         return functions
 
+    def column_members(self):
+        """The scalar members accessible in all elements of a Vector"""
+        if len(self.dynamic_members) > 0 or not self.has_data():
+            return []
+
+        return [member for member in self.static_members
+                if isinstance(member, FixedSizeMember) and
+                not member.value_type.is_zerobuf_type]
+
+    def column_functions(self):
+        """
+        Structure-of-arrays access to the scalar members of all elements of a
+        Vector of this table.
+        """
+        functions = []
+        vector_type = "::zerobuf::Vector< {0} >".format(self.name)
+        for member in self.column_members():
+            cxxtype = member.get_cxxtype()
+            functions.append(Function("void",
+                "gather{0}( const {1}& vector, {2}* column )".format(member.cxxName, vector_type, cxxtype),
+                "vector.gather( {0}, column );".format(member.allocator_offset),
+                DoxygenDoc(["Copy the {0} value of all elements into a contiguous column.".format(member.cxxName)],
+                           ["vector the elements to read from",
+                            "column output array for vector.size() values"]),
+                static=True))
+            functions.append(Function("void",
+                "scatter{0}( {1}& vector, const {2}* column )".format(member.cxxName, vector_type, cxxtype),
+                "vector.scatter( {0}, column );".format(member.allocator_offset),
+                DoxygenDoc(["Set the {0} value of all elements from a contiguous column.".format(member.cxxName),
+                            "notifyChanged() needs to be explicitly called on the owner of the vector afterwards."],
+                           ["vector the elements to update",
+                            "column input array of vector.size() values"]),
+                static=True))
+            if cxxtype == "bool": # std::vector< bool > has no contiguous storage
+                continue
+            functions.append(Function("std::vector< {0} >".format(cxxtype),
+                "gather{0}( const {1}& vector )".format(member.cxxName, vector_type),
+                "std::vector< {0} > column( vector.size( ));".format(cxxtype) + NEXTLINE +
+                "vector.gather( {0}, column.data( ));".format(member.allocator_offset) + NEXTLINE +
+                "return column;",
+                static=True))
+            functions.append(Function("void",
+                "scatter{0}( {1}& vector, const std::vector< {2} >& column )".format(member.cxxName, vector_type, cxxtype),
+                "if( column.size() != vector.size( ))" + NEXTLINE +
+                "    throw std::runtime_error( \"Column size does not match vector size\" );" + NEXTLINE +
+                "vector.scatter( {0}, column.data( ));".format(member.allocator_offset),
+                static=True))
+        return functions
+
+    def key_functions(self):
+        """Sorted access to the elements of a Vector of this table by key"""
+        if not self.key:
+            return []
+
+        member = self.key
+        vector_type = "::zerobuf::Vector< {0} >".format(self.name)
+        cxxtype = member.get_cxxtype()
+        return [
+            Function("void",
+                "sortByKey( {0}& vector )".format(vector_type),
+                "vector.sortBy< {0} >( {1} );".format(cxxtype, member.allocator_offset),
+                DoxygenDoc(["Sort the elements by their {0}, keeping the order of equal keys.".format(member.cxxName),
+                            "notifyChanged() needs to be explicitly called on the owner of the vector afterwards."],
+                           ["vector the elements to sort"]),
+                static=True),
+            Function("size_t",
+                "findByKey( const {0}& vector, const {1}& key )".format(vector_type, cxxtype),
+                "return vector.findSorted< {0} >( {1}, key );".format(cxxtype, member.allocator_offset),
+                DoxygenDoc(["Find an element by its {0} using a binary search.".format(member.cxxName),
+                            "The vector has to be sorted by the key, see sortByKey()."],
+                           ["vector the elements sorted by key",
+                            "key the {0} to look up".format(member.cxxName)],
+                           "the index of the first element with the key, or vector.size() if not found."),
+                static=True),
+            Function("size_t",
+                "insertSorted( {0}& vector, const {1}& value )".format(vector_type, self.name),
+                "return vector.insertSorted< {0} >( {1}, value );".format(cxxtype, member.allocator_offset),
+                DoxygenDoc(["Insert an element after all elements with a smaller or equal {0}.".format(member.cxxName),
+                            "notifyChanged() needs to be explicitly called on the owner of the vector afterwards."],
+                           ["vector the elements sorted by key",
+                            "value the element to insert"],
+                           "the index of the inserted element."),
+                static=True)]
+
+    def atomic_functions(self):
+        """Atomic accessors for the naturally aligned scalar static members"""
+        if not self.atomic:
+            return []
+
+        functions = []
+        order = "std::memory_order order = std::memory_order_seq_cst"
+        for member in self.static_members:
+            if not isinstance(member, FixedSizeMember) or \
+               member.value_type.is_zerobuf_type or \
+               member.value_type.size not in [1, 2, 4, 8]:
+                continue
+            cxxtype = member.get_cxxtype()
+            ptr = "getAllocator().template getItemPtr< {0} >( {1} )".format(cxxtype, member.allocator_offset)
+            # modifications never allocate or unshare the storage concurrently
+            mutable_ptr = "::zerobuf::getAtomicItemPtr< {0} >( getAllocator(), {1} )".\
+                format(cxxtype, member.allocator_offset)
+            functions.append(Function(cxxtype,
+                "load{0}( {1} ) const".format(member.cxxName, order),
+                "return ::zerobuf::atomicLoad( {0}, order );".format(ptr),
+                DoxygenDoc(["Atomically load the {0} value.".format(member.cxxName)],
+                           ["order the memory order of the operation"])))
+            functions.append(Function("void",
+                "store{0}( {1} value, {2} )".format(member.cxxName, cxxtype, order),
+                "::zerobuf::atomicStore( {0}, value, order );".format(mutable_ptr),
+                DoxygenDoc(["Atomically store the {0} value.".format(member.cxxName),
+                            "notifyChanged() is not called. " + ATOMIC_STORAGE_DOC],
+                           ["value the new {0} value".format(member.cxxName),
+                            "order the memory order of the operation"])))
+            if not member.value_type.is_enum_type and cxxtype != "bool":
+                functions.append(Function(cxxtype,
+                    "fetchAdd{0}( {1} value, {2} )".format(member.cxxName, cxxtype, order),
+                    "return ::zerobuf::atomicFetchAdd( {0}, value, order );".format(mutable_ptr),
+                    DoxygenDoc(["Atomically add to the {0} value.".format(member.cxxName),
+                                "notifyChanged() is not called. " + ATOMIC_STORAGE_DOC],
+                               ["value the value to add",
+                                "order the memory order of the operation"],
+                               "the previous {0} value.".format(member.cxxName))))
+            functions.append(Function("bool",
+                "compareExchange{0}( {1}& expected, {1} desired, {2} )".format(member.cxxName, cxxtype, order),
+                "return ::zerobuf::atomicCompareExchange( {0}, expected, desired, order );".format(mutable_ptr),
+                DoxygenDoc(["Atomically replace the {0} value if it equals expected.".format(member.cxxName),
+                            "notifyChanged() is not called. " + ATOMIC_STORAGE_DOC],
+                           ["expected the expected value, set to the current value on failure",
+                            "desired the new value",
+                            "order the memory order of the operation"],
+                           "true if the value was replaced.")))
+        return functions
+
+    def write_atomic_declarations(self, file):
+        functions = self.atomic_functions()
+        if len(functions) > 0:
+            next_line(file)
+            next_line_indent(file)
+            file.write("// Atomic access")
+            self.write_declarations(functions, file)
+
+    def write_column_declarations(self, file):
+        functions = self.column_functions()
+        if len(functions) > 0:
+            next_line(file)
+            next_line_indent(file)
+            file.write("// Column access")
+            for member in self.column_members():
+                next_line_indent(file)
+                file.write("/** Key functor reading {0} from the element storage, see zerobuf::VectorIndex. */".format(member.cxxName))
+                next_line_indent(file)
+                file.write("typedef ::zerobuf::FieldKey< {0}, {1} > {2}Field;".
+                           format(member.get_cxxtype(), member.allocator_offset, member.cxxName))
+            self.write_declarations(functions, file)
+
+    def write_key_declarations(self, file):
+        functions = self.key_functions()
+        if len(functions) > 0:
+            next_line(file)
+            next_line_indent(file)
+            file.write("// Key access")
+            next_line_indent(file)
+            file.write("/** Hash index of a Vector of {0} by {1} for lookups in constant time. */".format(self.name, self.key.cxxName))
+            next_line_indent(file)
+            file.write("typedef ::zerobuf::VectorIndex< {0}, {1}Field > KeyIndex;".format(self.name, self.key.cxxName))
+            self.write_declarations(functions, file)
+
+    def write_compact_format_declarations(self, file):
+        functions = self.compact_format_functions()
+        if len(functions) > 0:
+            next_line(file)
+            next_line_indent(file)
+            file.write("// Compact wire format")
+            self.write_declarations(functions, file)
+
     def json_functions(self):
-        from_json = []
+        from_json = OrderedDict()
         to_json = []
 
         for member in self.dynamic_members:
-            from_json.append(member.from_json())
+            from_json[member.json_name] = member.from_json().split(NEXTLINE)
             to_json.append(member.to_json())
         for member in self.static_members:
-            from_json.append(member.from_json())
+            from_json[member.json_name] = member.from_json().split(NEXTLINE)
             to_json.append(member.to_json())
 
         if not from_json or not to_json:
             return []
 
-        return [Function("void", "_parseJSON( const Json::Value& json ) final", NEXTLINE.join(from_json)),
+        # dispatch the fields of the JSON object using a perfect hash of the
+        # member names, without looking up each member
+        table = PerfectHash(list(from_json.keys()))
+        indent = NEXTLINE + "    "
+        parse = table.seeds_declaration() + NEXTLINE + \
+                "::zerobuf::forEachJSONField( json, [this]( const char* name, const size_t size," + NEXTLINE + \
+                "                                           const Json::Value& field )" + NEXTLINE + \
+                "{" + indent + table.switch("name", "size", from_json, indent) + NEXTLINE + "});"
+        return [Function("void", "_parseJSON( const Json::Value& json ) final", parse),
                 Function("void", "_createJSON( Json::Value& json ) const final", NEXTLINE.join(to_json))]
 
     def from_binary_function(self):
-        member_emits = []
+        # diff old and new data per member, emit only signals of changed ones
+        changes = []
+        emits = []
         for member in self.dynamic_members:
-            member_emits.append(member.emit_value_changed(True))
+            changes.append("_hasDynamicChanged( data, size, {0} )".format(member.dynamic_type_index))
+            emits.append(member)
         for member in self.static_members:
-            member_emits.append(member.emit_value_changed(True))
+            changes.append("_hasChanged( data, size, {0}, {1} )".
+                           format(member.allocator_offset, member.get_byte_size()))
+            emits.append(member)
+
         body = []
-        body.append("const bool ret = ::zerobuf::Zerobuf::_fromBinary( data, size );")
-        body.append(NEXTLINE.join(member_emits))
-        body.append("return ret;")
+        if len(changes) == 0:
+            body.append("return ::zerobuf::Zerobuf::_fromBinary( data, size );")
+        else:
+            body.append("const bool changed[] = {" + NEXTLINE + "    " +
+                        ("," + NEXTLINE + "    ").join(changes) + " };")
+            body.append("if( !::zerobuf::Zerobuf::_fromBinary( data, size ))" +
+                        NEXTLINE + "    return false;")
+            for i, member in enumerate(emits):
+                body.append("if( changed[{0}] )".format(i) + NEXTLINE +
+                            "    emit " + member.qsignal)
+            body.append("return true;")
         function = Function("bool", "_fromBinary( const void* data, const size_t size ) final",
             "{0}".format(NEXTLINE.join(body)))
         return function
@@ -1304,12 +2028,20 @@ class FbsTable():
         # class functions
         if len(self.dynamic_members) > 0:
             self.compact_function().write_declaration(file)
+        if self.nested_zerobuf_function():
+            self.nested_zerobuf_function().write_declaration(file)
 
         if self.has_data():
             self.write_declarations(self.special_member_functions(), file)
         else:
             self.write_declarations(self.empty_constructors(), file)
 
+        self.write_builder_declaration(file)
+        self.write_atomic_declarations(file)
+        self.write_column_declarations(file)
+        self.write_key_declarations(file)
+        self.write_compact_format_declarations(file)
+
         next_line(file)
         next_line_indent(file)
         file.write("// Introspection")
@@ -1319,6 +2051,8 @@ class FbsTable():
 
     def write_class_begin(self, file):
         parent_classes = ["public ::zerobuf::Zerobuf"]
+        if self.has_inline_storage(): # constructed before the Zerobuf
+            parent_classes.insert(0, "private " + self.get_inline_storage_base())
         if self.generate_qobject:
             parent_classes.insert(0, "public QObject")
         parents = ", ".join(parent_classes)
@@ -1362,7 +2096,9 @@ class FbsTable():
             file.write("\n")
 
     def write_class_end(self, file):
-        member_declarations = []
+        member_declarations = self.get_allocator_declarations()
+        if len(self.dynamic_members) > 0:
+            member_declarations.insert(0, self.builder_constructor().definition() + " // used by Builder")
 
         for member in self.dynamic_members:
             member_declarations.append(member.get_declaration())
@@ -1394,6 +2130,8 @@ class FbsTable():
             function.write_implementation(file, self.name)
 
     def write_implementation(self, file):
+        self.write_default_images(file)
+
         # members accessors
         for member in self.dynamic_members:
             member.write_accessors_implementation(file, self.name, self.generate_qobject)
@@ -1403,12 +2141,22 @@ class FbsTable():
         # class functions
         if len(self.dynamic_members) > 0:
             self.compact_function().write_implementation(file, self.name)
+        if self.nested_zerobuf_function():
+            self.nested_zerobuf_function().write_implementation(file, self.name)
 
         if self.has_data():
             self.write_implementations(self.special_member_functions(), file)
         else:
             self.write_implementations(self.empty_constructors(), file)
-
+        if len(self.dynamic_members) > 0:
+            self.builder_constructor().write_implementation(file, self.name)
+            for function in self.builder_functions():
+                function.write_implementation(file, self.name + "::Builder")
+
+        self.write_implementations(self.atomic_functions(), file)
+        self.write_implementations(self.column_functions(), file)
+        self.write_implementations(self.key_functions(), file)
+        self.write_implementations(self.compact_format_functions(), file)
         self.write_implementations(self.introspection_functions(), file)
         self.write_implementations(self.json_functions(), file)
         if self.generate_qobject:
@@ -1424,6 +2172,21 @@ class FbsTable():
         compact = compact[4:]
         return Function("void", "compact( float threshold = 0.1f ) final", compact)
 
+    def nested_zerobuf_function(self):
+        """Nested dynamic tables for canonicalize() and isCanonical()"""
+        nested = [member for member in self.dynamic_members
+                  if isinstance(member, DynamicZeroBufMember)]
+        if len(nested) == 0:
+            return None
+
+        body = "switch( index )" + NEXTLINE + "{"
+        for member in nested:
+            body += NEXTLINE + "case {0}: return &_{1};".\
+                format(member.dynamic_type_index, member.name)
+        body += NEXTLINE + "default: return nullptr;" + NEXTLINE + "}"
+        return Function("const ::zerobuf::Zerobuf*",
+                        "_getNestedZerobuf( const size_t index ) const final", body)
+
     def fill_initializer_list(self):
         for member in self.dynamic_members:
             self.initializers.append(member.get_initializer())
@@ -1431,78 +2194,74 @@ class FbsTable():
             if member.value_type.is_zerobuf_type:
                 self.initializers.append(member.get_initializer())
 
-    def get_move_statics(self):
-        movers = ''
+    def get_allocator_declarations(self):
+        declarations = []
         # [name, nElems, cxxtype, offset|index, elemSize]
         for initializer in self.initializers:
             if initializer[1] == 1: # single member
-                if initializer[4] == 0: # dynamic member
-                    allocator = "::zerobuf::NonMovingSubAllocator( {{0}}, {0}, {1}::ZEROBUF_NUM_DYNAMICS(), {1}::ZEROBUF_STATIC_SIZE( ))".format(initializer[3], initializer[2])
-                else:
-                    allocator = "::zerobuf::StaticSubAllocator( {{0}}, {0}, {1} )".format(initializer[3], initializer[4])
-                movers += "    _{0}.reset( ::zerobuf::AllocatorPtr( new {1}));\n" \
-                    .format(initializer[0], allocator ).format( "getAllocator()" )
-                movers += "    rhs._{0}.reset( ::zerobuf::AllocatorPtr( new {1}));\n" \
-                    .format(initializer[0], allocator ).format( "rhs.getAllocator()" )
+                allocator = "NonMovingSubAllocator" if initializer[4] == 0 else "StaticSubAllocator"
+                declarations.append("::zerobuf::{0} _{1}Allocator;".format(allocator, initializer[0]))
             elif initializer[1] != 0: # static array
-                for i in range(0, initializer[1]):
-                    movers += "    _{0}[{1}].reset( ::zerobuf::AllocatorPtr( " \
-                              "new ::zerobuf::StaticSubAllocator( getAllocator(), {2}, {3} )));\n" \
-                        .format(initializer[0], i, initializer[3], initializer[3] + i * initializer[4])
-                    movers += "    rhs._{0}[{1}].reset( ::zerobuf::AllocatorPtr( " \
-                              "new ::zerobuf::StaticSubAllocator( rhs.getAllocator(), {2}, {3} )));\n" \
-                        .format(initializer[0], i, initializer[3], initializer[3] + i * initializer[4])
-        return movers
+                declarations.append("std::array< ::zerobuf::StaticSubAllocator, {0} > _{1}Allocators;".
+                                    format(initializer[1], initializer[0]))
+        return declarations
 
-    def get_move_operator(self):
-        movers = ''
+    def get_move_rebinds(self, side):
+        rebinds = ''
         # [name, nElems, cxxtype, offset|index, elem_size]
         for initializer in self.initializers:
             if initializer[1] == 0: # dynamic array
-                movers += "    _{0}.reset( getAllocator( ));\n".format(initializer[0])
-                movers += "    rhs._{0}.reset( rhs.getAllocator( ));\n".format(initializer[0])
-        movers += self.get_move_statics()
-        return movers
+                rebinds += "    {1}_{0}.reset( {1}getAllocator( ));\n".format(initializer[0], side)
+            elif initializer[1] == 1: # single member
+                rebinds += "    {1}_{0}Allocator.reset( {1}getAllocator( ));\n".format(initializer[0], side)
+            else: # static array
+                rebinds += "    for( auto& allocator : {1}_{0}Allocators )\n" \
+                           "        allocator.reset( {1}getAllocator( ));\n".format(initializer[0], side)
+        return rebinds
 
-    def get_move_initializer(self):
-        initializers = ''
-        # [name, nElems, cxxtype, offset|index, elem_size]
-        for initializer in self.initializers:
-            if initializer[1] == 0: # dynamic array
-                initializers += "    , _{0}( getAllocator(), {1} )\n".format(initializer[0], initializer[3])
-        initializers += "{\n"
-        initializers += self.get_move_operator()
-        initializers += "}"
-        return initializers
+    def get_move_operator(self):
+        return self.get_move_rebinds("") + self.get_move_rebinds("rhs.")
 
     def get_initializer_list(self):
         initializers = ''
 
         # [name, nElems, cxxtype, offset, elem_size]
+        # nested members use embedded sub-allocators, declared before them
+        for initializer in self.initializers:
+            if initializer[1] == 1: # single member
+                if initializer[4] == 0: # dynamic member
+                    initializers += "    , _{0}Allocator( getAllocator(), {1}, {2}::ZEROBUF_NUM_DYNAMICS(), {2}::ZEROBUF_STATIC_SIZE( ){3})\n" \
+                        .format(initializer[0], initializer[3], initializer[2], self.get_alignment_arg())
+                else:
+                    initializers += "    , _{0}Allocator( getAllocator(), {1}, {2} )\n" \
+                        .format(initializer[0], initializer[3], initializer[4])
+            elif initializer[1] != 0: # static array
+                initializers += "    , _{0}Allocators{1}".format(initializer[0], "{{")
+                for i in range( 0, initializer[1] ):
+                    initializers += "\n        {{ getAllocator(), {0}, {1} }}{2}" \
+                        .format(initializer[3] + i * initializer[4], initializer[4], "}}\n" if i == initializer[1] - 1 else ",")
+
         for initializer in self.initializers:
             if initializer[1] == 0: # dynamic array
                 initializers += "    , _{0}( getAllocator(), {1} )\n".format(initializer[0], initializer[3])
             elif initializer[1] == 1: # single member
-                if initializer[4] == 0: # dynamic member
-                    allocator = "::zerobuf::NonMovingSubAllocator( getAllocator(), {0}, {1}::ZEROBUF_NUM_DYNAMICS(), {1}::ZEROBUF_STATIC_SIZE( ))".format(initializer[3], initializer[2])
-                else:
-                    allocator = "::zerobuf::StaticSubAllocator( getAllocator(), {0}, {1} )".format(initializer[3], initializer[4])
-                initializers += "    , _{0}( ::zerobuf::AllocatorPtr( new {1}))\n" \
-                    .format(initializer[0], allocator)
+                initializers += "    , _{0}( ::zerobuf::AllocatorPtr( &_{0}Allocator, ::zerobuf::AllocatorDeleter( false )))\n" \
+                    .format(initializer[0])
             else: # static array
                 initializers += "    , _{0}{1}".format(initializer[0], "{{")
                 for i in range( 0, initializer[1] ):
-                    initializers += "\n        {0}( ::zerobuf::AllocatorPtr( " \
-                                    "new ::zerobuf::StaticSubAllocator( getAllocator(), {1}, {2} ))){3} " \
-                        .format(initializer[2], initializer[3] + i * initializer[4], initializer[4], "}}\n" if i == initializer[1] - 1 else ",")
+                    initializers += "\n        {0}( ::zerobuf::AllocatorPtr( &_{1}Allocators[{2}], ::zerobuf::AllocatorDeleter( false ))){3}" \
+                        .format(initializer[2], initializer[0], i, "}}\n" if i == initializer[1] - 1 else ",")
         return initializers
 
 
 class FbsFile():
     """An fbs file which can be written to C++ header and implementation files."""
 
-    def __init__(self, schema, generate_qobject):
+    def __init__(self, schema, generate_qobject, atomic=False, alignment=0):
         self.generate_qobject = generate_qobject
+        self.atomic = atomic
+        self.alignment = alignment
         self.namespace = []
         self.enums = []
         self.enum_names = set()
@@ -1537,12 +2296,57 @@ class FbsFile():
         self.enums.append(enum)
 
     def add_table(self, item):
-        table = FbsTable(item[1], item[2:], self.namespace, self)
+        members = item[2:]
+        metadata = []
+        if len(members) > 0 and members[0][0] == '(': # table attributes
+            metadata = list(members[0][1:])
+            members = members[1:]
+        for attribute in metadata:
+            if attribute not in ["compact"]:
+                sys.exit("Unknown attribute {0} of table {1}".format(attribute, item[1]))
+
+        # strip the attributes of the table entries
+        attributes = []
+        member_metadata = {}
+        for member in members:
+            if member[-1][0] == '(': # entry attributes
+                member_metadata[member[0]] = list(member[-1][1:])
+                member = list(member)[:-1]
+            attributes.append(member)
+        for name, member_attributes in member_metadata.items():
+            for attribute in member_attributes:
+                if attribute not in ["key"]:
+                    sys.exit("Unknown attribute {0} of {1}.{2}".format(attribute, item[1], name))
+
+        table = FbsTable(item[1], attributes, self.namespace, self, metadata,
+                         member_metadata)
         self.tables.append(table)
         self.table_names.add(table.name)
         # record size in type lookup table, 0 if dynamically sized
         self.types[ table.name ] = TypeDescription( table.offset if len(table.dynamic_members) == 0 else 0, table.name )
 
+    def get_table(self, name):
+        for table in self.tables:
+            if table.name == name:
+                return table
+        sys.exit("Unknown table {0}".format(name))
+
+    def get_compact_layout_tables(self):
+        """Tables in the compact format and their nested tables, each after
+           its nested tables"""
+        tables = []
+        def visit(table):
+            if table in tables:
+                return
+            for nested in table.compact_dynamics:
+                if nested:
+                    visit(self.get_table(nested))
+            tables.append(table)
+        for table in self.tables:
+            if table.compact:
+                visit(table)
+        return tables
+
     def set_root_type(self, item):
         # Nothing to do with this statement
         return
@@ -1562,8 +2366,18 @@ class FbsFile():
         header.write("#pragma once\n")
         if self.generate_qobject:
             header.write( "#include <QObject> // base class\n")
+        if self.atomic:
+            header.write("#include <zerobuf/atomic.h> // used inline\n")
+        if any(table.compact for table in self.tables):
+            header.write("#include <zerobuf/compact.h> // return value\n")
+        header.write("#include <zerobuf/ArrayView.h> // return value\n")
         header.write("#include <zerobuf/ConstAllocator.h> // static create\n")
+        header.write("#include <zerobuf/NonMovingSubAllocator.h> // member\n")
+        header.write("#include <zerobuf/StaticSubAllocator.h> // member\n")
+        header.write("#include <zerobuf/StringView.h> // return value\n")
         header.write("#include <zerobuf/Vector.h> // member\n")
+        if any(table.column_members() for table in self.tables):
+            header.write("#include <zerobuf/VectorIndex.h> // typedef\n")
         header.write("#include <zerobuf/Zerobuf.h> // base class\n")
         header.write("#include <array> // member\n")
         header.write("#include <memory> // std::unique_ptr\n")
@@ -1590,9 +2404,10 @@ class FbsFile():
         """Write the C++ implementation file."""
 
         impl.write("#include <zerobuf/NonMovingAllocator.h>\n")
-        impl.write("#include <zerobuf/NonMovingSubAllocator.h>\n")
-        impl.write("#include <zerobuf/StaticSubAllocator.h>\n")
         impl.write("#include <zerobuf/json.h>\n")
+        impl.write("#include <zerobuf/version.h>\n")
+        impl.write("\n")
+        impl.write("#include <cstring>\n")
         impl.write("\n")
 
         self.write_namespace_opening(impl)
@@ -1600,6 +2415,13 @@ class FbsFile():
         for enum in self.enums:
             enum.write_implementation(impl)
 
+        compact_tables = self.get_compact_layout_tables()
+        if len(compact_tables) > 0:
+            impl.write("namespace\n{\n")
+            for table in compact_tables:
+                table.write_compact_layout(impl)
+            impl.write("}\n")
+
         for table in self.tables:
             table.write_implementation(impl)
 
@@ -1624,6 +2446,10 @@ if __name__ == "__main__":
                          help = "Generate a QObject with signals and slots.")
     parser.add_argument( '-e', '--extension', action='store', default = "cpp",
                          help = "Extension for generated source files. (default: cpp)")
+    parser.add_argument( '-a', '--atomic', action='store_true',
+                         help = "Align static members naturally, dynamic members to 8 bytes and generate atomic accessors.")
+    parser.add_argument( '--align', action='store', type=int, default=0, choices=[16, 32, 64],
+                         help = "Align static members naturally and dynamic members to the given bytes.")
 
     # Parse, interpret and validate arguments
     args = parser.parse_args()
@@ -1654,7 +2480,7 @@ if __name__ == "__main__":
         schema = fbsObject.parseFile(_file)
         # import pprint
         # pprint.pprint( schema.asList( ))
-        fbsFile = FbsFile(schema, args.qobject)
+        fbsFile = FbsFile(schema, args.qobject, args.atomic, args.align)
         fbsFile.write_declaration(header)
         fbsFile.write_implementation(impl)
 
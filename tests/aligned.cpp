@@ -0,0 +1,100 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE aligned
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/alignedSchema.h>
+#include <testschema/testSchema.h>
+
+namespace
+{
+const size_t alignment = 64;
+
+bool isAligned(const void* ptr)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+void checkAlignment(const test::AlignedSchema& object)
+{
+    if (!object.getPoints().empty())
+        BOOST_CHECK(isAligned(object.getPoints().data()));
+    if (!object.getIndices().empty())
+        BOOST_CHECK(isAligned(object.getIndices().data()));
+    if (!object.getName().empty())
+        BOOST_CHECK(isAligned(object.getName().data()));
+    const test::AlignedNested& nested = object.getNested();
+    BOOST_CHECK(isAligned(nested.toBinary().ptr.get()));
+    if (!nested.getWeights().empty())
+        BOOST_CHECK(isAligned(nested.getWeights().data()));
+}
+}
+
+BOOST_AUTO_TEST_CASE(layout)
+{
+    const test::AlignedSchema object;
+    BOOST_CHECK(isAligned(object.toBinary().ptr.get()));
+    BOOST_CHECK_EQUAL(object.getZerobufStaticSize() % 8, 0);
+    BOOST_CHECK_NE(test::AlignedSchema::ZEROBUF_TYPE_IDENTIFIER(),
+                   test::TestSchema::ZEROBUF_TYPE_IDENTIFIER());
+    checkAlignment(object);
+}
+
+BOOST_AUTO_TEST_CASE(dynamicAllocations)
+{
+    test::AlignedSchema object;
+    object.setName("aligned");
+    for (size_t i = 0; i < 100; ++i)
+    {
+        object.getPoints().push_back(float(i));
+        object.getIndices().push_back(uint16_t(i));
+        object.getNested().getWeights().push_back(float(i) * .5f);
+        if (i % 10 == 0)
+            object.getNested().setName(std::string(i + 1, 'n'));
+        checkAlignment(object);
+    }
+    object.setValue(42.);
+    BOOST_CHECK_EQUAL(object.getNameString(), "aligned");
+    BOOST_CHECK_EQUAL(object.getValue(), 42.);
+    BOOST_CHECK_EQUAL(object.getPoints()[99], 99.f);
+    BOOST_CHECK_EQUAL(object.getIndices()[42], 42);
+    BOOST_CHECK_EQUAL(object.getNested().getWeights()[10], 5.f);
+    BOOST_CHECK_EQUAL(object.getNested().getNameString(), std::string(91, 'n'));
+
+    object.getPoints().resize(3);
+    object.getName().clear();
+    object.compact(0.f);
+    checkAlignment(object);
+    BOOST_CHECK_EQUAL(object.getPoints().size(), 3);
+    BOOST_CHECK_EQUAL(object.getIndices()[42], 42);
+    BOOST_CHECK_EQUAL(object.getNested().getWeights()[10], 5.f);
+
+    const test::AlignedSchema copy(object);
+    checkAlignment(copy);
+    BOOST_CHECK_EQUAL(copy, object);
+
+    test::AlignedSchema moved(std::move(object));
+    BOOST_CHECK(isAligned(moved.getPoints().data()));
+    BOOST_CHECK(moved.getPointsVector() == copy.getPointsVector());
+    BOOST_CHECK(moved.getIndicesVector() == copy.getIndicesVector());
+    checkAlignment(moved);
+    BOOST_CHECK_EQUAL(moved, copy);
+    object.getPoints().push_back(1.f);
+    object.getIndices().push_back(1);
+    BOOST_CHECK(isAligned(object.getPoints().data()));
+    BOOST_CHECK(isAligned(object.getIndices().data()));
+
+    test::AlignedSchema binary;
+    BOOST_CHECK(binary.fromBinary(copy.toBinary().ptr.get(),
+                                  copy.toBinary().size));
+    checkAlignment(binary);
+    BOOST_CHECK_EQUAL(binary, copy);
+
+    test::AlignedSchema json;
+    BOOST_CHECK(json.fromJSON(copy.toJSON()));
+    checkAlignment(json);
+    BOOST_CHECK_EQUAL(json, copy);
+}
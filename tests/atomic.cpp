@@ -0,0 +1,169 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE atomic
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/atomicSchema.h>
+
+#include <thread>
+
+namespace
+{
+const size_t numThreads = 4;
+const uint64_t numUpdates = 100000;
+
+template <class T>
+bool isAligned(const T* ptr)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % sizeof(T) == 0;
+}
+}
+
+BOOST_AUTO_TEST_CASE(alignedLayout)
+{
+    const test::AtomicCounters counters;
+    const uint8_t* base =
+        reinterpret_cast<const uint8_t*>(counters.toBinary().ptr.get());
+
+    // static members are naturally aligned relative to the 8 byte aligned base
+    BOOST_CHECK(isAligned(reinterpret_cast<const uint64_t*>(base)));
+    BOOST_CHECK_EQUAL(counters.getZerobufStaticSize() % 8, 0);
+    BOOST_CHECK_EQUAL(test::AtomicNested::ZEROBUF_STATIC_SIZE() % 8, 0);
+
+    const uint8_t* nested = reinterpret_cast<const uint8_t*>(
+        counters.getNested().toBinary().ptr.get());
+    BOOST_CHECK_EQUAL((nested - base) % 8, 0);
+    for (const auto& element : counters.getNestedarray())
+    {
+        const uint8_t* ptr =
+            reinterpret_cast<const uint8_t*>(element.toBinary().ptr.get());
+        BOOST_CHECK_EQUAL((ptr - base) % 8, 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(accessors)
+{
+    test::AtomicCounters counters;
+    counters.setName("counters");
+
+    counters.storeCount(42);
+    BOOST_CHECK_EQUAL(counters.loadCount(), 42);
+    BOOST_CHECK_EQUAL(counters.getCount(), 42);
+    BOOST_CHECK_EQUAL(counters.fetchAddCount(8), 42);
+    BOOST_CHECK_EQUAL(counters.loadCount(std::memory_order_acquire), 50);
+
+    uint64_t expected = 1;
+    BOOST_CHECK(!counters.compareExchangeCount(expected, 2));
+    BOOST_CHECK_EQUAL(expected, 50);
+    BOOST_CHECK(counters.compareExchangeCount(expected, 2));
+    BOOST_CHECK_EQUAL(counters.getCount(), 2);
+
+    counters.storeSmall(-3, std::memory_order_release);
+    BOOST_CHECK_EQUAL(counters.fetchAddSmall(5), -3);
+    BOOST_CHECK_EQUAL(counters.getSmall(), 2);
+
+    counters.storeEnabled(true);
+    BOOST_CHECK(counters.loadEnabled());
+    bool flag = true;
+    BOOST_CHECK(counters.compareExchangeEnabled(flag, false));
+    BOOST_CHECK(!counters.getEnabled());
+
+    counters.setValue(1.5);
+    BOOST_CHECK_EQUAL(counters.fetchAddValue(2.5), 1.5);
+    BOOST_CHECK_EQUAL(counters.loadValue(), 4.0);
+    BOOST_CHECK_EQUAL(counters.fetchAddRatio(0.5f), 0.f);
+    BOOST_CHECK_EQUAL(counters.fetchAddId(-7), 0);
+    BOOST_CHECK_EQUAL(counters.getId(), -7);
+
+    counters.getNested().fetchAddCounter(3);
+    BOOST_CHECK_EQUAL(counters.getNested().loadCounter(), 3);
+    counters.getNestedarray()[1].storeFlag(true);
+    BOOST_CHECK(counters.getNestedarray()[1].getFlag());
+    BOOST_CHECK(!counters.getNestedarray()[0].getFlag());
+
+    // atomic accessors modify the zerobuf like the plain setters
+    BOOST_CHECK_EQUAL(counters.getNameString(), "counters");
+    const test::AtomicCounters copy(counters);
+    BOOST_CHECK_EQUAL(copy, counters);
+    BOOST_CHECK_EQUAL(copy.loadValue(), 4.0);
+}
+
+BOOST_AUTO_TEST_CASE(concurrentUpdates)
+{
+    test::AtomicCounters counters;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < numThreads; ++i)
+        threads.emplace_back([&counters] {
+            for (uint64_t j = 0; j < numUpdates; ++j)
+            {
+                counters.fetchAddCount(1, std::memory_order_relaxed);
+                counters.fetchAddValue(1.0);
+                counters.getNested().fetchAddCounter(2);
+            }
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    BOOST_CHECK_EQUAL(counters.getCount(), numThreads * numUpdates);
+    BOOST_CHECK_EQUAL(counters.getValue(), double(numThreads * numUpdates));
+    BOOST_CHECK_EQUAL(counters.getNested().getCounter(),
+                      2 * numThreads * numUpdates);
+}
+
+BOOST_AUTO_TEST_CASE(dynamicMembers)
+{
+    test::AtomicHolder holder;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        // odd string sizes shift the following dynamic allocations
+        holder.setName(std::string(2 * i + 1, 'x'));
+        holder.getElements().push_back(test::AtomicElement(uint64_t(i)));
+        holder.getNested().setName(std::string(i + 3, 'y'));
+
+        for (const auto& element : holder.getElements())
+            BOOST_CHECK(isAligned(reinterpret_cast<const uint64_t*>(
+                element.toBinary().ptr.get())));
+        BOOST_CHECK(isAligned(reinterpret_cast<const uint64_t*>(
+            holder.getNested().toBinary().ptr.get())));
+    }
+
+    BOOST_CHECK_EQUAL(holder.getElements()[0].fetchAddCounter(1), 0);
+    BOOST_CHECK_EQUAL(holder.getElements()[2].fetchAddCounter(1), 2);
+    BOOST_CHECK_EQUAL(holder.getElements()[2].loadCounter(), 3);
+    BOOST_CHECK_EQUAL(holder.getNested().fetchAddCount(5), 0);
+    BOOST_CHECK_EQUAL(holder.getNested().fetchAddValue(0.5), 0.0);
+    holder.getNested().getNested().storeCounter(7);
+    BOOST_CHECK_EQUAL(holder.getNested().getNested().loadCounter(), 7);
+}
+
+BOOST_AUTO_TEST_CASE(unsharedStorage)
+{
+    test::AtomicCounters counters;
+    counters.setCount(1);
+    test::AtomicCounters moved(std::move(counters));
+
+    // atomic modifications do not allocate the storage of a moved-from object
+    BOOST_CHECK_THROW(counters.fetchAddCount(1), std::runtime_error);
+    BOOST_CHECK_THROW(counters.storeSmall(1), std::runtime_error);
+    BOOST_CHECK_EQUAL(counters.loadCount(), 0);
+    counters.setCount(2);
+    BOOST_CHECK_EQUAL(counters.fetchAddCount(1), 2);
+
+    // nor do they unshare the storage of a frozen object
+    auto snapshot = moved.freeze();
+    uint64_t expected = 1;
+    BOOST_CHECK_THROW(moved.fetchAddCount(1), std::runtime_error);
+    BOOST_CHECK_THROW(moved.compareExchangeCount(expected, 2),
+                      std::runtime_error);
+    BOOST_CHECK_THROW(moved.getNested().fetchAddCounter(1),
+                      std::runtime_error);
+    BOOST_CHECK_EQUAL(moved.loadCount(), 1);
+
+    moved.setSmall(1);
+    BOOST_CHECK_EQUAL(moved.fetchAddCount(1), 1);
+    BOOST_CHECK_EQUAL(moved.loadCount(), 2);
+    BOOST_CHECK_EQUAL(snapshot->loadCount(), 1);
+}
@@ -0,0 +1,248 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE binaryStream
+
+#include <boost/test/unit_test.hpp>
+
+#include "serialization.h"
+#include <testschema/alignedSchema.h>
+#include <zerobuf/BinaryStream.h>
+#include <zerobuf/SegmentedAllocator.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace
+{
+std::atomic<size_t> _maxAllocation(0);
+
+std::vector<uint8_t> stream(const zerobuf::Zerobuf& object,
+                            const size_t chunkSize)
+{
+    zerobuf::BinaryStreamWriter writer(object, chunkSize);
+    std::vector<uint8_t> binary;
+    for (zerobuf::DynamicRange chunk = writer.next(); chunk.size > 0;
+         chunk = writer.next())
+    {
+        BOOST_CHECK_LE(chunk.size, chunkSize);
+        const uint8_t* data = static_cast<const uint8_t*>(chunk.data);
+        binary.insert(binary.end(), data, data + chunk.size);
+    }
+    BOOST_CHECK_EQUAL(binary.size(), writer.getSize());
+    return binary;
+}
+
+void read(zerobuf::BinaryStreamReader& reader,
+          const std::vector<uint8_t>& binary, const size_t chunkSize)
+{
+    for (size_t i = 0; i < binary.size(); i += chunkSize)
+    {
+        BOOST_CHECK(!reader.isComplete());
+        reader.read(binary.data() + i, std::min(chunkSize, binary.size() - i));
+    }
+    BOOST_CHECK(reader.isComplete());
+}
+}
+
+void* operator new(const size_t size)
+{
+    size_t max = _maxAllocation;
+    while (size > max && !_maxAllocation.compare_exchange_weak(max, size))
+        ;
+    if (void* ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+BOOST_AUTO_TEST_CASE(roundTrip)
+{
+    const test::TestSchema source = getTestObject();
+    for (const size_t chunkSize :
+         {size_t(1), size_t(7), size_t(64), size_t(1 << 20)})
+    {
+        const std::vector<uint8_t> binary = stream(source, chunkSize);
+
+        // the stream is a valid binary
+        test::TestSchema fromBinary;
+        BOOST_CHECK(fromBinary.fromBinary(binary.data(), binary.size()));
+        checkTestObject(fromBinary);
+
+        // reader and writer chunks are independent
+        for (const size_t readSize : {size_t(1), size_t(13), size_t(4096)})
+        {
+            test::TestSchema object;
+            zerobuf::BinaryStreamReader reader(object);
+            read(reader, binary, readSize);
+            BOOST_CHECK_EQUAL(reader.getPosition(), binary.size());
+            checkTestObject(object);
+            BOOST_CHECK_EQUAL(object, source);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(memberHandler)
+{
+    const test::TestSchema source = getTestObject();
+    const std::vector<uint8_t> binary = stream(source, 16);
+
+    test::TestSchema object;
+    std::vector<size_t> completed;
+    zerobuf::BinaryStreamReader reader(object, [&](const size_t index) {
+        completed.push_back(index);
+        BOOST_CHECK(!reader.isComplete()); // after the last member
+    });
+
+    // members are not complete before the static section
+    reader.read(binary.data(), object.getZerobufStaticSize() - 1);
+    BOOST_CHECK(completed.empty());
+    read(reader, std::vector<uint8_t>(binary.begin() +
+                                          object.getZerobufStaticSize() - 1,
+                                      binary.end()),
+         16);
+    BOOST_CHECK_EQUAL(reader.getPosition(), binary.size());
+
+    BOOST_CHECK_EQUAL(completed.size(), object.getZerobufNumDynamics());
+    std::sort(completed.begin(), completed.end());
+    for (size_t i = 0; i < completed.size(); ++i)
+        BOOST_CHECK_EQUAL(completed[i], i);
+    checkTestObject(object);
+}
+
+BOOST_AUTO_TEST_CASE(segmentedReceiver)
+{
+    const test::TestSchema source = getTestObject();
+    test::TestSchema object(
+        zerobuf::AllocatorPtr(new zerobuf::SegmentedAllocator(
+            test::TestSchema::ZEROBUF_STATIC_SIZE(),
+            test::TestSchema::ZEROBUF_NUM_DYNAMICS())));
+    zerobuf::BinaryStreamReader reader(object);
+    read(reader, stream(source, 32), 32);
+    checkTestObject(object);
+
+    // and back, from a non-contiguous object
+    test::TestSchema copy;
+    zerobuf::BinaryStreamReader copyReader(copy);
+    read(copyReader, stream(object, 5), 11);
+    checkTestObject(copy);
+}
+
+BOOST_AUTO_TEST_CASE(alignment)
+{
+    test::AlignedSchema source(
+        zerobuf::AllocatorPtr(new zerobuf::SegmentedAllocator(
+            test::AlignedSchema::ZEROBUF_STATIC_SIZE(),
+            test::AlignedSchema::ZEROBUF_NUM_DYNAMICS(), 64)));
+    source.setName("aligned");
+    for (size_t i = 0; i < 100; ++i)
+        source.getPoints().push_back(float(i));
+
+    const std::vector<uint8_t> binary = stream(source, 100);
+    const zerobuf::Data& data = source.toBinary();
+    BOOST_CHECK_EQUAL(binary.size(), data.size);
+    BOOST_CHECK_EQUAL(::memcmp(binary.data(), data.ptr.get(), data.size), 0);
+
+    test::AlignedSchema object;
+    zerobuf::BinaryStreamReader reader(object);
+    read(reader, binary, 100);
+    BOOST_CHECK_EQUAL(object, source);
+}
+
+BOOST_AUTO_TEST_CASE(boundedMemory)
+{
+    const size_t numFloats = 4 * 1024 * 1024; // 16 MB payload
+    const size_t chunkSize = 4096;
+    test::TestSchema source;
+    source.getFloatdynamic().resize(numFloats);
+    for (size_t i = 0; i < numFloats; ++i)
+        source.getFloatdynamic()[i] = float(i);
+    const uint8_t* begin =
+        reinterpret_cast<const uint8_t*>(source.getFloatdynamic().data());
+    const uint8_t* end = begin + numFloats * sizeof(float);
+
+    // transport pipe between the sink of the writer and the source of the
+    // reader, which reads in smaller pieces than the sink receives
+    test::TestSchema object;
+    std::vector<uint8_t> pipe;
+    pipe.reserve(chunkSize);
+    size_t numChunks = 0;
+    size_t maxBuffered = 0;
+    size_t numReferenced = 0; // chunks pointing into the source vector
+
+    _maxAllocation = 0;
+    {
+        zerobuf::BinaryStreamWriter writer(source, chunkSize);
+        zerobuf::BinaryStreamReader reader(object);
+        for (zerobuf::DynamicRange chunk = writer.next(); chunk.size > 0;
+             chunk = writer.next())
+        {
+            const uint8_t* data = static_cast<const uint8_t*>(chunk.data);
+            if (data >= begin && data < end)
+                ++numReferenced;
+            pipe.insert(pipe.end(), data, data + chunk.size);
+            maxBuffered = std::max(maxBuffered, pipe.size());
+            ++numChunks;
+
+            for (size_t i = 0; i < pipe.size(); i += 1000)
+                reader.read(pipe.data() + i,
+                            std::min(size_t(1000), pipe.size() - i));
+            pipe.clear();
+        }
+        BOOST_CHECK(reader.isComplete());
+    }
+    const size_t maxAllocation = _maxAllocation;
+
+    BOOST_CHECK_LE(maxBuffered, chunkSize);
+    BOOST_CHECK_GE(numChunks, numFloats * sizeof(float) / chunkSize);
+    BOOST_CHECK_EQUAL(numReferenced, numFloats * sizeof(float) / chunkSize);
+    // neither writer nor reader buffer the large member
+    BOOST_CHECK_LE(maxAllocation, chunkSize);
+    BOOST_CHECK_EQUAL(object.getFloatdynamic().size(), numFloats);
+    BOOST_CHECK_EQUAL(object.getFloatdynamic()[numFloats - 1],
+                      float(numFloats - 1));
+}
+
+BOOST_AUTO_TEST_CASE(invalidStreams)
+{
+    BOOST_CHECK_THROW(zerobuf::BinaryStreamWriter(getTestObject(), 0),
+                      std::runtime_error);
+
+    const std::vector<uint8_t> binary = stream(getTestObject(), 1024);
+    {
+        std::vector<uint8_t> wrongVersion = binary;
+        wrongVersion[0] ^= 0xff;
+        test::TestSchema object;
+        zerobuf::BinaryStreamReader reader(object);
+        BOOST_CHECK_THROW(reader.read(wrongVersion.data(),
+                                      wrongVersion.size()),
+                          std::runtime_error);
+    }
+    {
+        std::vector<uint8_t> wrongOffset = binary;
+        ::memset(wrongOffset.data() + 4, 0, 8); // first dynamic in header
+        test::TestSchema object;
+        zerobuf::BinaryStreamReader reader(object);
+        BOOST_CHECK_THROW(reader.read(wrongOffset.data(), wrongOffset.size()),
+                          std::runtime_error);
+    }
+    {
+        test::TestSchema object;
+        zerobuf::BinaryStreamReader reader(object);
+        reader.read(binary.data(), binary.size());
+        BOOST_CHECK(reader.isComplete());
+        BOOST_CHECK_THROW(reader.read(binary.data(), 1), std::runtime_error);
+    }
+}
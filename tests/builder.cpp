@@ -0,0 +1,154 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE builder
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/alignedSchema.h>
+#include <testschema/testSchema.h>
+#include <zerobuf/SegmentedAllocator.h>
+
+#include <string>
+#include <vector>
+
+namespace
+{
+size_t getCompactSize(test::TestSchema object)
+{
+    object.compact(0.f);
+    return object.toBinary().size;
+}
+}
+
+BOOST_AUTO_TEST_CASE(buildTestSchema)
+{
+    const std::vector<int32_t> ints{1, 2, 3, 4, 5};
+    const std::vector<double> doubles{1.5, 2.5};
+    const std::vector<uint8_t> bytes{7, 8, 9};
+    const std::string name("The quick brown fox");
+
+    const test::TestSchema object = test::TestSchema::Builder()
+                                        .setIntdynamic(ints)
+                                        .setDoubledynamic(doubles)
+                                        .setUint8Tdynamic(bytes)
+                                        .setStringvalue(name)
+                                        .build();
+
+    test::TestSchema expected;
+    expected.setIntdynamic(ints);
+    expected.setDoubledynamic(doubles);
+    expected.setUint8Tdynamic(bytes);
+    expected.setStringvalue(name);
+
+    BOOST_CHECK_EQUAL(object, expected);
+    BOOST_CHECK(object.getIntdynamicVector() == ints);
+    BOOST_CHECK(object.getDoubledynamicVector() == doubles);
+    BOOST_CHECK(object.getUint8TdynamicVector() == bytes);
+    BOOST_CHECK_EQUAL(object.getStringvalueString(), name);
+    BOOST_CHECK(object.getFloatdynamic().empty());
+
+    // static members have their default value
+    BOOST_CHECK_EQUAL(object.getUintvalue(), 42);
+    BOOST_CHECK_EQUAL(object.getFloatvalue(), 4.2f);
+    BOOST_CHECK(object.getTrueBool());
+    BOOST_CHECK_EQUAL(object.getNestedMember().getIntvalue(), 7);
+
+    // built objects are compact
+    BOOST_CHECK_EQUAL(object.toBinary().size, getCompactSize(expected));
+    object.check();
+}
+
+BOOST_AUTO_TEST_CASE(buildNested)
+{
+    test::TestDynamic dynamic;
+    dynamic.setIntvalue(42);
+    dynamic.setName("Hugo");
+
+    test::TestNestedZerobuf object =
+        test::TestNestedZerobuf::Builder().setDynamic(dynamic).build();
+    BOOST_CHECK_EQUAL(object.getDynamic(), dynamic);
+    BOOST_CHECK_EQUAL(object.getDynamic().getNameString(), "Hugo");
+    BOOST_CHECK_EQUAL(object.getNest().getIntvalue(), -17);
+    BOOST_CHECK(object.getNested().empty());
+
+    // unset nested members have their default value
+    object = test::TestNestedZerobuf::Builder().build();
+    BOOST_CHECK_EQUAL(object, test::TestNestedZerobuf());
+    BOOST_CHECK_EQUAL(object.getDynamic().getIntvalue(), 7);
+
+    // built objects are regular, growable zerobufs
+    object.getDynamic().setName("Hugo");
+    object.getNested().push_back(test::TestNested(1, 2));
+    BOOST_CHECK_EQUAL(object.getDynamic().getNameString(), "Hugo");
+    BOOST_CHECK_EQUAL(object.getNested()[0], test::TestNested(1, 2));
+}
+
+BOOST_AUTO_TEST_CASE(buildFromTemporaryBinary)
+{
+    // segmented objects assemble a temporary binary in toBinary()
+    test::TestDynamic dynamic(zerobuf::AllocatorPtr(
+        new zerobuf::SegmentedAllocator(test::TestDynamic::ZEROBUF_STATIC_SIZE(),
+                                        test::TestDynamic::ZEROBUF_NUM_DYNAMICS())));
+    dynamic.setIntvalue(42);
+    dynamic.setName("Hugo");
+
+    test::TestNestedZerobuf::Builder builder;
+    builder.setDynamic(dynamic);
+    const test::TestNestedZerobuf object = builder.build();
+    BOOST_CHECK_EQUAL(object.getDynamic(), dynamic);
+    BOOST_CHECK_EQUAL(object.getDynamic().getNameString(), "Hugo");
+    BOOST_CHECK_EQUAL(object.getDynamic().getIntvalue(), 42);
+}
+
+BOOST_AUTO_TEST_CASE(resize)
+{
+    test::TestSchema object = test::TestSchema::Builder()
+                                  .resizeIntdynamic(3)
+                                  .resizeNesteddynamic(2)
+                                  .setStringvalue("name")
+                                  .build();
+    const size_t size = object.toBinary().size;
+
+    BOOST_REQUIRE_EQUAL(object.getIntdynamic().size(), 3);
+    BOOST_CHECK_EQUAL(object.getIntdynamic()[0], 0);
+    BOOST_REQUIRE_EQUAL(object.getNesteddynamic().size(), 2);
+    BOOST_CHECK_EQUAL(object.getNesteddynamic()[1], test::TestNested());
+
+    // filling reserved members does not reallocate
+    const int32_t ints[] = {1, 2, 3};
+    object.setIntdynamic(ints, 3);
+    object.getNesteddynamic()[1] = test::TestNested(4, 5);
+    BOOST_CHECK_EQUAL(object.toBinary().size, size);
+    BOOST_CHECK_EQUAL(object.getIntdynamic()[2], 3);
+    BOOST_CHECK_EQUAL(object.getNesteddynamic()[1], test::TestNested(4, 5));
+    BOOST_CHECK_EQUAL(object.getStringvalueString(), "name");
+}
+
+BOOST_AUTO_TEST_CASE(buildAligned)
+{
+    test::AlignedNested nested;
+    nested.setName("nested");
+    nested.setWeights(std::vector<float>{1.f, 2.f, 3.f});
+
+    const std::vector<uint16_t> indices{1, 2, 3};
+    const test::AlignedSchema object = test::AlignedSchema::Builder()
+                                           .setIndices(indices)
+                                           .setName("aligned")
+                                           .setNested(nested)
+                                           .build();
+
+    const uint8_t* base =
+        reinterpret_cast<const uint8_t*>(object.toBinary().ptr.get());
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(base) % 64, 0);
+    BOOST_CHECK_EQUAL(
+        reinterpret_cast<uintptr_t>(object.getIndices().data()) % 64, 0);
+    BOOST_CHECK_EQUAL(
+        reinterpret_cast<uintptr_t>(object.getName().data()) % 64, 0);
+    BOOST_CHECK(object.getIndicesVector() == indices);
+    BOOST_CHECK_EQUAL(object.getNameString(), "aligned");
+    BOOST_CHECK_EQUAL(object.getNested(), nested);
+    BOOST_CHECK_EQUAL(object.getNested().getWeights()[2], 3.f);
+    object.check();
+}
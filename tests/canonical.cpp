@@ -0,0 +1,164 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE canonical
+
+#include <boost/test/unit_test.hpp>
+
+#include "serialization.h"
+#include <zerobuf/SegmentedAllocator.h>
+
+#include <cstring>
+
+namespace
+{
+std::vector<uint8_t> getBinary(const zerobuf::Zerobuf& zerobuf)
+{
+    const zerobuf::Data& data = zerobuf.toBinary();
+    const uint8_t* ptr = static_cast<const uint8_t*>(data.ptr.get());
+    return std::vector<uint8_t>(ptr, ptr + data.size);
+}
+
+std::vector<uint8_t> getCanonicalBinary(const zerobuf::Zerobuf& zerobuf)
+{
+    std::vector<uint8_t> binary;
+    zerobuf.toCanonicalBinary(binary);
+    return binary;
+}
+
+// same content as getTestObject(), with holes and in a different order
+test::TestSchema getFragmentedObject()
+{
+    test::TestSchema object = getTestObject();
+    object.getNestedMember().setName("a much longer name than Hugo");
+    object.setStringvalue("a much longer test message");
+    object.getNestedMember().setName("Hugo");
+    object.setStringvalue("testmessage");
+    return object;
+}
+}
+
+BOOST_AUTO_TEST_CASE(equalObjects)
+{
+    const test::TestSchema object = getTestObject();
+    test::TestSchema fragmented = getFragmentedObject();
+    BOOST_CHECK_EQUAL(fragmented.getNestedMember().getNameString(), "Hugo");
+    BOOST_CHECK_EQUAL(fragmented, object);
+    BOOST_CHECK(getBinary(fragmented) != getBinary(object));
+    BOOST_CHECK(!fragmented.isCanonical());
+
+    const std::vector<uint8_t> canonical = getCanonicalBinary(object);
+    BOOST_CHECK(getCanonicalBinary(fragmented) == canonical);
+
+    fragmented.canonicalize();
+    BOOST_CHECK(fragmented.isCanonical());
+    BOOST_CHECK(fragmented.getNestedMember().isCanonical());
+    BOOST_CHECK(getBinary(fragmented) == canonical);
+    checkTestObject(fragmented);
+
+    test::TestSchema copy;
+    BOOST_CHECK(copy.fromBinary(canonical.data(), canonical.size()));
+    BOOST_CHECK(copy.isCanonical());
+    BOOST_CHECK_EQUAL(copy, object);
+}
+
+BOOST_AUTO_TEST_CASE(canonicalLayout)
+{
+    test::TestSchema object;
+    BOOST_CHECK(object.isCanonical());
+
+    // the string member precedes the default-initialized nested member
+    object.setStringvalue("test");
+    BOOST_CHECK(!object.isCanonical());
+    object.canonicalize();
+    BOOST_CHECK(object.isCanonical());
+    BOOST_CHECK_EQUAL(object.getStringvalueString(), "test");
+    BOOST_CHECK_EQUAL(object.getNestedMember().getIntvalue(), 7);
+
+    // shrinking a member leaves a hole
+    object.setStringvalue("t");
+    BOOST_CHECK(!object.isCanonical());
+    object.canonicalize();
+    BOOST_CHECK(object.isCanonical());
+    BOOST_CHECK_EQUAL(object.toBinary().size,
+                      test::TestSchema::ZEROBUF_STATIC_SIZE() + 1 +
+                          test::TestDynamic::ZEROBUF_STATIC_SIZE());
+
+    // emptied members have no offset, dynamics are in schema order
+    object.getIntdynamic().push_back(1);
+    object.setStringvalue("");
+    BOOST_CHECK(!object.isCanonical());
+    object.canonicalize();
+    BOOST_CHECK_EQUAL(object.getIntdynamic()[0], 1);
+    BOOST_CHECK(object.getStringvalueString().empty());
+
+    object.setStringvalue("test");
+    object.getUintdynamic().push_back(2);
+    BOOST_CHECK(!object.isCanonical());
+    object.canonicalize();
+    BOOST_CHECK(object.isCanonical());
+    BOOST_CHECK_EQUAL(object.getUintdynamic()[0], 2);
+    BOOST_CHECK_EQUAL(object.getStringvalueString(), "test");
+}
+
+BOOST_AUTO_TEST_CASE(stalePadding)
+{
+    test::TestSchema object = getTestObject();
+    object.canonicalize();
+    std::vector<uint8_t> binary = getBinary(object);
+
+    // garbage between the static section and the first dynamic member
+    const size_t offset = object.getZerobufStaticSize();
+    uint64_t header[2];
+    ::memcpy(header, binary.data() + 4, sizeof(header));
+    binary.insert(binary.begin() + offset, 8, 0xff);
+    for (size_t i = 0; i < object.getZerobufNumDynamics(); ++i)
+    {
+        ::memcpy(header, binary.data() + 4 + i * 16, sizeof(header));
+        if (header[1] > 0)
+            header[0] += 8;
+        ::memcpy(binary.data() + 4 + i * 16, header, sizeof(header));
+    }
+
+    test::TestSchema padded;
+    BOOST_CHECK(padded.fromBinary(binary.data(), binary.size()));
+    checkTestObject(padded);
+    BOOST_CHECK(!padded.isCanonical());
+    BOOST_CHECK(getCanonicalBinary(padded) == getBinary(object));
+}
+
+BOOST_AUTO_TEST_CASE(constSource)
+{
+    const test::TestSchema fragmented = getFragmentedObject();
+    const std::vector<uint8_t> binary = getBinary(fragmented);
+    const std::vector<uint8_t> canonical = getCanonicalBinary(fragmented);
+    BOOST_CHECK(getBinary(fragmented) == binary);
+
+    const test::ConstTestSchemaPtr view =
+        test::TestSchema::create(binary.data(), binary.size());
+    BOOST_CHECK(!view->isCanonical());
+    BOOST_CHECK(getCanonicalBinary(*view) == canonical);
+    BOOST_CHECK_THROW(const_cast<test::TestSchema&>(*view).canonicalize(),
+                      std::runtime_error);
+
+    const test::ConstTestSchemaPtr canonicalView =
+        test::TestSchema::create(canonical.data(), canonical.size());
+    BOOST_CHECK(canonicalView->isCanonical());
+    BOOST_CHECK_NO_THROW(
+        const_cast<test::TestSchema&>(*canonicalView).canonicalize());
+}
+
+BOOST_AUTO_TEST_CASE(segmentedSource)
+{
+    test::TestSchema segmented(
+        zerobuf::AllocatorPtr(new zerobuf::SegmentedAllocator(
+            test::TestSchema::ZEROBUF_STATIC_SIZE(),
+            test::TestSchema::ZEROBUF_NUM_DYNAMICS())));
+    segmented = getFragmentedObject();
+    BOOST_CHECK(getCanonicalBinary(segmented) ==
+                getCanonicalBinary(getTestObject()));
+    segmented.canonicalize();
+    BOOST_CHECK(segmented.isCanonical());
+    checkTestObject(segmented);
+}
@@ -0,0 +1,128 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE compact
+
+#include <boost/test/unit_test.hpp>
+
+#include "serialization.h"
+#include <testschema/compactSchema.h>
+#include <zerobuf/SegmentedAllocator.h>
+
+#include <cstring>
+
+BOOST_AUTO_TEST_CASE(roundTrip)
+{
+    const test::TestSchema source = getTestObject();
+    const std::vector<uint8_t> compact = source.toCompactBinary();
+
+    test::TestSchema object;
+    BOOST_CHECK(object.fromCompactBinary(compact.data(), compact.size()));
+    checkTestObject(object);
+    BOOST_CHECK_EQUAL(object, source);
+
+    // 8 bytes per dynamic member, the versions of nested tables
+    const size_t numNested = 1 /*nested*/ + 4 /*nestedarray*/ +
+                             source.getNesteddynamic().size() +
+                             1 /*nestedMember*/;
+    BOOST_CHECK_LE(compact.size() + source.getZerobufNumDynamics() * 8 +
+                       numNested * 4,
+                   source.toBinary().size);
+}
+
+BOOST_AUTO_TEST_CASE(explicitConversion)
+{
+    const test::TestSchema source = getTestObject();
+    const zerobuf::Data& binary = source.toBinary();
+    const zerobuf::CompactLayout& layout =
+        test::TestSchema::ZEROBUF_COMPACT_LAYOUT();
+
+    const std::vector<uint8_t> compact =
+        zerobuf::toCompactBinary(binary.ptr.get(), binary.size, layout);
+    BOOST_CHECK(compact == source.toCompactBinary());
+    uint32_t version;
+    ::memcpy(&version, compact.data(), sizeof(version));
+    BOOST_CHECK_EQUAL(version, zerobuf::compactVersion);
+    BOOST_CHECK_NE(version, ZEROBUF_VERSION_ABI);
+
+    // standard binary readable by all zerobufs
+    const std::vector<uint8_t> standard =
+        zerobuf::fromCompactBinary(compact.data(), compact.size(), layout);
+    test::TestSchema object;
+    BOOST_CHECK(object.fromBinary(standard.data(), standard.size()));
+    BOOST_CHECK_EQUAL(object, source);
+    BOOST_CHECK(zerobuf::toCompactBinary(standard.data(), standard.size(),
+                                         layout) == compact);
+}
+
+BOOST_AUTO_TEST_CASE(segmentedSource)
+{
+    test::TestSchema segmented(
+        zerobuf::AllocatorPtr(new zerobuf::SegmentedAllocator(
+            test::TestSchema::ZEROBUF_STATIC_SIZE(),
+            test::TestSchema::ZEROBUF_NUM_DYNAMICS())));
+    segmented = getTestObject();
+
+    const std::vector<uint8_t> compact = segmented.toCompactBinary();
+    test::TestSchema object;
+    BOOST_CHECK(object.fromCompactBinary(compact.data(), compact.size()));
+    checkTestObject(object);
+}
+
+BOOST_AUTO_TEST_CASE(controlMessage)
+{
+    test::ControlMessage message;
+    message.setSequence(42);
+    message.setCommand("open");
+    message.setSource("viewer");
+    message.setArguments("--fullscreen");
+    message.setPrimary(test::ControlTarget(7, 0.5f));
+    message.getTargets().push_back(test::ControlTarget(1, 1.f));
+    message.getTargets().push_back(test::ControlTarget(2, 2.f));
+
+    const std::vector<uint8_t> compact = message.toCompactBinary();
+    BOOST_CHECK_EQUAL(compact.size() + 12 * 8 + 3 * 4,
+                      message.toBinary().size);
+
+    test::ControlMessage copy;
+    BOOST_CHECK(copy.fromCompactBinary(compact.data(), compact.size()));
+    BOOST_CHECK_EQUAL(copy, message);
+    BOOST_CHECK_EQUAL(copy.getArgumentsString(), "--fullscreen");
+    BOOST_CHECK_EQUAL(copy.getTargets()[1].getWeight(), 2.f);
+    BOOST_CHECK_EQUAL(copy.getPrimary().getId(), 7);
+}
+
+BOOST_AUTO_TEST_CASE(invalidBinaries)
+{
+    const test::TestSchema source = getTestObject();
+    const zerobuf::CompactLayout& layout =
+        test::TestSchema::ZEROBUF_COMPACT_LAYOUT();
+    test::TestSchema object;
+
+    // standard and compact binaries are not interchangeable
+    const zerobuf::Data& binary = source.toBinary();
+    BOOST_CHECK_THROW(object.fromCompactBinary(binary.ptr.get(), binary.size),
+                      std::runtime_error);
+    std::vector<uint8_t> compact = source.toCompactBinary();
+    BOOST_CHECK(!object.fromBinary(compact.data(), compact.size()));
+    BOOST_CHECK_THROW(zerobuf::toCompactBinary(compact.data(), compact.size(),
+                                               layout),
+                      std::runtime_error);
+
+    std::vector<uint8_t> wrongVersion = compact;
+    wrongVersion[0] ^= 0x01;
+    BOOST_CHECK_THROW(object.fromCompactBinary(wrongVersion.data(),
+                                               wrongVersion.size()),
+                      std::runtime_error);
+
+    BOOST_CHECK_THROW(object.fromCompactBinary(compact.data(), 12),
+                      std::runtime_error);
+
+    std::vector<uint8_t> wrongSize = compact;
+    const uint32_t size = uint32_t(compact.size());
+    ::memcpy(wrongSize.data() + 4 + 4, &size, sizeof(size)); // dynamic #0
+    BOOST_CHECK_THROW(object.fromCompactBinary(wrongSize.data(),
+                                               wrongSize.size()),
+                      std::runtime_error);
+}
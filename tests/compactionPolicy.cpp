@@ -0,0 +1,161 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE compactionPolicy
+
+#include <boost/test/unit_test.hpp>
+
+#include "serialization.h"
+
+namespace
+{
+size_t getCanonicalSize(const zerobuf::Zerobuf& zerobuf)
+{
+    std::vector<uint8_t> binary;
+    zerobuf.toCanonicalBinary(binary);
+    return binary.size();
+}
+
+// grows and shrinks members in turn, leaving holes behind
+void edit(test::TestSchema& object, const size_t i)
+{
+    object.setStringvalue(std::string(i % 97 + 1, 'a' + char(i % 26)));
+    test::TestSchema::Intdynamic& ints = object.getIntdynamic();
+    ints.resize(i % 61);
+    std::fill(ints.data(), ints.data() + ints.size(), int32_t(i));
+    if (i % 3 == 0)
+        object.getDoubledynamic().push_back(double(i));
+    if (i % 7 == 0)
+        object.getDoubledynamic().clear();
+    object.getNestedMember().setName(std::string(i % 13, 'n'));
+}
+}
+
+BOOST_AUTO_TEST_CASE(editHeavyWorkload)
+{
+    test::TestSchema reference;
+    test::TestSchema object;
+    object.setCompactionPolicy(zerobuf::CompactionPolicy(.5f, .1f));
+
+    size_t maxReference = 0;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        edit(reference, i);
+        edit(object, i);
+        maxReference = std::max(maxReference, reference.toBinary().size);
+
+        // members are compacted before the allocation of the next edit
+        const size_t optimal = getCanonicalSize(object);
+        const size_t dynamics = optimal - object.getZerobufStaticSize();
+        BOOST_CHECK_LE(object.toBinary().size, optimal + dynamics * 2 + 256);
+    }
+    BOOST_CHECK_EQUAL(object, reference);
+    BOOST_CHECK_LT(object.toBinary().size, maxReference);
+}
+
+BOOST_AUTO_TEST_CASE(hysteresis)
+{
+    test::TestSchema object;
+    object.setCompactionPolicy(zerobuf::CompactionPolicy(.5f, .25f));
+    object.getIntdynamic().resize(1000);
+    object.setStringvalue(std::string(3000, 'a'));
+
+    // compaction keeps a quarter of the used memory free at the end
+    object.setStringvalue("");
+    const size_t used = test::TestDynamic::ZEROBUF_STATIC_SIZE() + 4000;
+    const size_t compacted = getCanonicalSize(object) + used / 4;
+    BOOST_CHECK_EQUAL(object.toBinary().size, compacted);
+
+    // growing into the reserve neither compacts nor reallocates
+    const int32_t* data = object.getIntdynamic().data();
+    object.getIntdynamic().resize(1200);
+    BOOST_CHECK_EQUAL(object.getIntdynamic().data(), data);
+    BOOST_CHECK_EQUAL(object.toBinary().size, compacted);
+}
+
+BOOST_AUTO_TEST_CASE(budget)
+{
+    test::TestSchema reference;
+    test::TestSchema object;
+    object.setCompactionPolicy(zerobuf::CompactionPolicy(.5f, 0.f, 64));
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        edit(reference, i);
+        edit(object, i);
+    }
+    BOOST_CHECK_EQUAL(object, reference);
+    BOOST_CHECK_LT(object.toBinary().size, reference.toBinary().size);
+}
+
+BOOST_AUTO_TEST_CASE(deferred)
+{
+    test::TestSchema reference;
+    test::TestSchema object;
+    object.setCompactionPolicy(zerobuf::CompactionPolicy(.5f, 0.f, 0, true));
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        edit(reference, i);
+        edit(object, i);
+    }
+    // holes within the nested member are not compacted
+    const size_t nested =
+        test::TestDynamic::ZEROBUF_STATIC_SIZE() + 13 + 16;
+    BOOST_CHECK_LE(object.toBinarySegments()[0].size,
+                   getCanonicalSize(object) + nested);
+    BOOST_CHECK_EQUAL(object, reference);
+
+    // holes accumulate until the next toBinary()
+    object.setStringvalue(std::string(1000, 'a'));
+    object.getIntdynamic().resize(1000);
+    object.setStringvalue("a");
+    object.getIntdynamic().clear();
+    BOOST_CHECK_LE(object.toBinary().size, getCanonicalSize(object) + nested);
+}
+
+BOOST_AUTO_TEST_CASE(moveAndReplace)
+{
+    test::TestSchema object;
+    object.setCompactionPolicy(zerobuf::CompactionPolicy(.5f, 0.f, 0, true));
+
+    // usage is tracked again after replacing the data
+    object = getTestObject();
+    object.setStringvalue(std::string(1000, 'a'));
+    object.setStringvalue("testmessage");
+    BOOST_CHECK_EQUAL(object.toBinary().size, getCanonicalSize(object));
+    checkTestObject(object);
+
+    test::TestSchema moved(std::move(object));
+    moved.setStringvalue(std::string(1000, 'a'));
+    moved.setStringvalue("testmessage");
+    BOOST_CHECK_EQUAL(moved.toBinary().size, getCanonicalSize(moved));
+    checkTestObject(moved);
+}
+
+BOOST_AUTO_TEST_CASE(resetToDefaults)
+{
+    test::TestSchema object;
+    object.setCompactionPolicy(zerobuf::CompactionPolicy(.5f, 0.f));
+    object.setStringvalue(std::string(100000, 'x'));
+    BOOST_CHECK_GT(object.toBinary().size, 100000);
+
+    // the cleared members are reclaimed by the next edits, as after a setter
+    object.resetToDefaults();
+    for (size_t i = 0; i < 20; ++i)
+        edit(object, i);
+    BOOST_CHECK_LT(object.toBinary().size, 2000);
+}
+
+BOOST_AUTO_TEST_CASE(unsupported)
+{
+    test::TestSchema object;
+    BOOST_CHECK_THROW(object.getNestedMember().setCompactionPolicy(
+                          zerobuf::CompactionPolicy(.5f)),
+                      std::runtime_error);
+
+    const zerobuf::Data& binary = object.toBinary();
+    const test::ConstTestSchemaPtr view = test::TestSchema::create(binary);
+    BOOST_CHECK_THROW(const_cast<test::TestSchema&>(*view).setCompactionPolicy(
+                          zerobuf::CompactionPolicy(.5f)),
+                      std::runtime_error);
+}
@@ -0,0 +1,128 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE compression
+
+#include <boost/test/unit_test.hpp>
+
+#include "serialization.h"
+#include <zerobuf/compression.h>
+
+namespace
+{
+const zerobuf::Codec codecs[] = {zerobuf::Codec::none, zerobuf::Codec::zeroRun,
+                                 zerobuf::Codec::lz};
+
+std::vector<uint8_t> roundTrip(const std::vector<uint8_t>& data,
+                               const zerobuf::Codec codec)
+{
+    const auto& compressed = zerobuf::compress(data.data(), data.size(), codec);
+    return zerobuf::decompress(compressed.data(), compressed.size());
+}
+}
+
+BOOST_AUTO_TEST_CASE(rawData)
+{
+    std::vector<uint8_t> data(10000);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = (i / 100) % 3 == 0 ? 0 : uint8_t(i % 17);
+
+    for (const auto codec : codecs)
+    {
+        BOOST_CHECK(roundTrip(data, codec) == data);
+        BOOST_CHECK(roundTrip(std::vector<uint8_t>(), codec).empty());
+        BOOST_CHECK(roundTrip(std::vector<uint8_t>(3, 0), codec) ==
+                    std::vector<uint8_t>(3, 0));
+    }
+
+    const auto& zeroRun =
+        zerobuf::compress(data.data(), data.size(), zerobuf::Codec::zeroRun);
+    const auto& lz =
+        zerobuf::compress(data.data(), data.size(), zerobuf::Codec::lz);
+    BOOST_CHECK_LT(zeroRun.size(), data.size());
+    BOOST_CHECK_LT(lz.size(), zeroRun.size());
+}
+
+BOOST_AUTO_TEST_CASE(overlappingMatch)
+{
+    const std::string pattern = "abcabcabcabcabcabcabcabcabcabcabcabcabcx";
+    const std::vector<uint8_t> data(pattern.begin(), pattern.end());
+    const auto& compressed =
+        zerobuf::compress(data.data(), data.size(), zerobuf::Codec::lz);
+    BOOST_CHECK_LT(compressed.size(), data.size());
+    BOOST_CHECK(zerobuf::decompress(compressed.data(), compressed.size()) ==
+                data);
+}
+
+BOOST_AUTO_TEST_CASE(zerobufs)
+{
+    const test::TestSchema object = getTestObject();
+    for (const auto codec : codecs)
+    {
+        const auto& compressed = zerobuf::compress(object, codec);
+        test::TestSchema copy;
+        BOOST_CHECK(
+            zerobuf::decompress(compressed.data(), compressed.size(), copy));
+        BOOST_CHECK_EQUAL(object, copy);
+    }
+
+    BOOST_CHECK(zerobuf::getCodec(object.getTypeIdentifier()) ==
+                zerobuf::Codec::none);
+    zerobuf::setCodec(object.getTypeIdentifier(), zerobuf::Codec::lz);
+    BOOST_CHECK(zerobuf::getCodec(object.getTypeIdentifier()) ==
+                zerobuf::Codec::lz);
+    BOOST_CHECK_LT(zerobuf::compress(object).size(),
+                   object.toBinary().size / 2);
+    zerobuf::setCodec(object.getTypeIdentifier(), zerobuf::Codec::none);
+}
+
+BOOST_AUTO_TEST_CASE(holesAreNotTransmitted)
+{
+    test::TestSchema object;
+    object.setStringvalue(std::string(1000, 'x'));
+    object.setIntdynamic(std::vector<int32_t>(1000, 42));
+    object.setStringvalue("short"); // leaves a hole with stale data
+
+    const auto& compressed = zerobuf::compress(object, zerobuf::Codec::lz);
+    BOOST_CHECK_LT(compressed.size(), 1000);
+
+    test::TestSchema copy;
+    BOOST_CHECK(
+        zerobuf::decompress(compressed.data(), compressed.size(), copy));
+    BOOST_CHECK_EQUAL(copy.getStringvalueString(), "short");
+    BOOST_CHECK_EQUAL(object, copy);
+}
+
+BOOST_AUTO_TEST_CASE(corruptFrames)
+{
+    std::vector<uint8_t> data(1000, 7);
+    auto compressed =
+        zerobuf::compress(data.data(), data.size(), zerobuf::Codec::lz);
+
+    BOOST_CHECK_THROW(zerobuf::decompress(data.data(), data.size()),
+                      std::runtime_error);
+    BOOST_CHECK_THROW(zerobuf::decompress(compressed.data(),
+                                          compressed.size() - 1),
+                      std::runtime_error);
+    compressed[4] = 42; // codec
+    BOOST_CHECK_THROW(zerobuf::decompress(compressed.data(), compressed.size()),
+                      std::runtime_error);
+
+    // a small frame announcing a huge size is rejected before allocating
+    const uint8_t huge[] = {0x43, 0x5a, 0x42, 0x5a, 1, // magic, zeroRun
+                            0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, // 2^42
+                            0x81, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01}; // zeros
+    BOOST_CHECK_THROW(zerobuf::decompress(huge, sizeof(huge)),
+                      std::runtime_error);
+    test::TestSchema object;
+    BOOST_CHECK_THROW(zerobuf::decompress(huge, sizeof(huge), object),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(largeZeroRuns)
+{
+    const std::vector<uint8_t> zeros(1 << 20, 0);
+    for (const auto codec : {zerobuf::Codec::zeroRun, zerobuf::Codec::lz})
+        BOOST_CHECK(roundTrip(zeros, codec) == zeros);
+}
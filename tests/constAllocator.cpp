@@ -9,6 +9,9 @@
 
 #include "serialization.h"
 
+#include <cstring>
+#include <thread>
+
 BOOST_AUTO_TEST_CASE(construction)
 {
     const std::vector<uint8_t> data(10);
@@ -50,3 +53,34 @@ BOOST_AUTO_TEST_CASE(zerobufVectorAccessFromConstAllocatorParent)
         test::TestNestedZerobuf::create(binary.ptr.get(), binary.size));
     BOOST_CHECK_NO_THROW(constObject->getNested()[0]);
 }
+
+BOOST_AUTO_TEST_CASE(createShared)
+{
+    const test::TestSchema& object = getTestObject();
+    const zerobuf::Data& data = object.toBinary();
+
+    // a received buffer, released by a custom callback
+    bool released = false;
+    uint8_t* buffer = new uint8_t[data.size];
+    ::memcpy(buffer, data.ptr.get(), data.size);
+    zerobuf::Data received;
+    received.ptr.reset(buffer, [&released](const void* ptr) {
+        delete[] reinterpret_cast<const uint8_t*>(ptr);
+        released = true;
+    });
+    received.size = data.size;
+
+    test::ConstTestSchemaPtr shared = test::TestSchema::create(received);
+    received = zerobuf::Data();
+    BOOST_CHECK(!released);
+    BOOST_CHECK_EQUAL(shared->toBinary().ptr.get(), buffer);
+    checkTestObject(*shared);
+
+    // ownership is shared with the object, also across threads
+    std::shared_ptr<const test::TestSchema> copy(std::move(shared));
+    std::thread reader([copy] { checkTestObject(*copy); });
+    reader.join();
+    BOOST_CHECK(!released);
+    copy.reset();
+    BOOST_CHECK(released);
+}
@@ -0,0 +1,177 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE freeze
+
+#include <boost/test/unit_test.hpp>
+
+#include "serialization.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+const void* getData(const zerobuf::Zerobuf& zerobuf)
+{
+    return zerobuf.toBinary().ptr.get();
+}
+}
+
+BOOST_AUTO_TEST_CASE(shareWithoutCopy)
+{
+    test::TestSchema object = getTestObject();
+    const void* data = getData(object);
+
+    std::shared_ptr<const test::TestSchema> snapshot = object.freeze();
+    checkTestObject(*snapshot);
+    BOOST_CHECK_EQUAL(getData(*snapshot), data);
+
+    // further snapshots share the same data until the object is modified
+    const std::shared_ptr<const test::TestSchema> second = object.freeze();
+    BOOST_CHECK_EQUAL(getData(*second), data);
+    BOOST_CHECK_EQUAL(getData(object), data);
+    BOOST_CHECK_EQUAL(object.getIntvalue(), 42); // reading does not copy
+    BOOST_CHECK_EQUAL(getData(object), data);
+
+    // no copy once all snapshots are gone
+    snapshot.reset();
+    BOOST_CHECK_EQUAL(getData(*second), data);
+}
+
+BOOST_AUTO_TEST_CASE(copyOnWrite)
+{
+    test::TestSchema object = getTestObject();
+    const void* data = getData(object);
+    const std::shared_ptr<const test::TestSchema> snapshot = object.freeze();
+
+    object.setIntvalue(7);
+    BOOST_CHECK_NE(getData(object), data);
+    BOOST_CHECK_EQUAL(getData(*snapshot), data);
+    BOOST_CHECK_EQUAL(object.getIntvalue(), 7);
+    checkTestObject(*snapshot);
+
+    // the copy is not shared anymore
+    const void* copy = getData(object);
+    object.setIntvalue(8);
+    BOOST_CHECK_EQUAL(getData(object), copy);
+
+    // nested members and dynamic growth
+    const std::shared_ptr<const test::TestSchema> second = object.freeze();
+    object.getNestedMember().setName("changed");
+    BOOST_CHECK_NE(getData(object), copy);
+    BOOST_CHECK_EQUAL(second->getNestedMember().getNameString(), "Hugo");
+
+    const std::shared_ptr<const test::TestSchema> third = object.freeze();
+    for (int32_t i = 0; i < 1000; ++i)
+        object.getIntdynamic().push_back(i);
+    BOOST_CHECK_EQUAL(third->getIntdynamic().size(),
+                      second->getIntdynamic().size());
+    BOOST_CHECK_EQUAL(object.getIntdynamic().size(),
+                      second->getIntdynamic().size() + 1000);
+    BOOST_CHECK_EQUAL(third->getIntvalue(), 8);
+    BOOST_CHECK_EQUAL(third->getNestedMember().getNameString(), "changed");
+}
+
+BOOST_AUTO_TEST_CASE(takeBackOwnership)
+{
+    test::TestSchema object = getTestObject();
+    const void* data = getData(object);
+    object.freeze();
+    object.setIntvalue(7);
+    BOOST_CHECK_EQUAL(getData(object), data);
+
+    // also after moves
+    const std::shared_ptr<const test::TestSchema> snapshot = object.freeze();
+    test::TestSchema moved(std::move(object));
+    BOOST_CHECK_EQUAL(getData(moved), data);
+    moved.setIntvalue(8);
+    BOOST_CHECK_NE(getData(moved), data);
+    BOOST_CHECK_EQUAL(snapshot->getIntvalue(), 7);
+}
+
+BOOST_AUTO_TEST_CASE(freezeCopies)
+{
+    // inline storage
+    test::TestNested nested(1, 2);
+    const std::shared_ptr<const test::TestNested> frozenNested =
+        nested.freeze();
+    nested.setIntvalue(3);
+    BOOST_CHECK_EQUAL(frozenNested->getIntvalue(), 1);
+
+    // member of another zerobuf
+    test::TestSchema object = getTestObject();
+    const std::shared_ptr<const test::TestDynamic> member =
+        object.getNestedMember().freeze();
+    object.getNestedMember().setName("changed");
+    BOOST_CHECK_EQUAL(member->getNameString(), "Hugo");
+
+    // view
+    const zerobuf::Data& binary = object.toBinary();
+    const test::ConstTestSchemaPtr view = test::TestSchema::create(binary);
+    const std::shared_ptr<const test::TestSchema> frozenView = view->freeze();
+    BOOST_CHECK_NE(getData(*frozenView), getData(*view));
+    BOOST_CHECK_EQUAL(*frozenView, object);
+}
+
+BOOST_AUTO_TEST_CASE(concurrentReaders)
+{
+    test::TestSchema object = getTestObject();
+    std::shared_ptr<const test::TestSchema> snapshot = object.freeze();
+    std::atomic<bool> running(true);
+    std::atomic<size_t> errors(0);
+
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < 4; ++i)
+        readers.emplace_back([snapshot, &running, &errors] {
+            while (running)
+            {
+                if (snapshot->getIntvalue() != 42 ||
+                    snapshot->getStringvalueString() != "testmessage")
+                {
+                    ++errors;
+                }
+            }
+        });
+
+    for (int32_t i = 0; i < 1000; ++i)
+    {
+        object.setIntvalue(i);
+        object.setStringvalue(std::to_string(i));
+        snapshot = object.freeze();
+    }
+    running = false;
+    for (std::thread& reader : readers)
+        reader.join();
+
+    BOOST_CHECK_EQUAL(errors, 0);
+    BOOST_CHECK_EQUAL(snapshot->getIntvalue(), 999);
+    BOOST_CHECK_EQUAL(snapshot->getStringvalueString(), "999");
+}
+
+BOOST_AUTO_TEST_CASE(concurrentFreeze)
+{
+    for (size_t iteration = 0; iteration < 100; ++iteration)
+    {
+        const test::TestSchema object = getTestObject();
+        const void* data = getData(object);
+        std::atomic<size_t> errors(0);
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < 4; ++i)
+            threads.emplace_back([&object, data, &errors] {
+                const std::shared_ptr<const test::TestSchema> snapshot =
+                    object.freeze();
+                if (getData(*snapshot) != data ||
+                    snapshot->getIntvalue() != 42)
+                {
+                    ++errors;
+                }
+            });
+        for (std::thread& thread : threads)
+            thread.join();
+        BOOST_CHECK_EQUAL(errors, 0);
+    }
+}
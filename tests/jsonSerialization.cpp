@@ -263,6 +263,39 @@ BOOST_AUTO_TEST_CASE(enum_string_conversion)
 
     BOOST_CHECK_THROW(test::string_to_AnotherTestEnum("wrong"),
                       std::runtime_error);
+
+    // names are looked up in a perfect hash table and compared completely
+    for (const auto value : {test::TestEnum::FIRST, test::TestEnum::SECOND,
+                             test::TestEnum::THIRD_UNDERSCORE})
+    {
+        BOOST_CHECK_EQUAL(test::string_to_TestEnum(test::to_string(value)),
+                          value);
+    }
+    const char buffer[] = "SECONDS";
+    BOOST_CHECK_EQUAL(test::string_to_TestEnum(buffer, 6),
+                      test::TestEnum::SECOND);
+    BOOST_CHECK_THROW(test::string_to_TestEnum(buffer, 7), std::runtime_error);
+    BOOST_CHECK_THROW(test::string_to_TestEnum("second"), std::runtime_error);
+    BOOST_CHECK_THROW(test::string_to_TestEnum(""), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(jsonFieldDispatch)
+{
+    test::TestSchema object(getTestObject());
+    BOOST_CHECK(object.fromJSON(
+        "{ \"intvalu\" : 1, \"intvalue2\" : 2, \"unknown\" : 3 }"));
+    checkTestObject(object);
+
+    BOOST_CHECK(object.fromJSON("{ \"enumdynamic\" : [ \"FIRST\" ], "
+                                "\"enumeration\" : \"THIRD_UNDERSCORE\" }"));
+    BOOST_CHECK_EQUAL(object.getEnumdynamic().size(), 1);
+    BOOST_CHECK_EQUAL(object.getEnumdynamic()[0], test::TestEnum::FIRST);
+    BOOST_CHECK_EQUAL(object.getEnumeration(),
+                      test::TestEnum::THIRD_UNDERSCORE);
+
+    BOOST_CHECK(!object.fromJSON("{ \"enumeration\" : \"FOURTH\" }"));
+    BOOST_CHECK(!object.fromJSON("{ \"enumeration\" : 1 }"));
+    BOOST_CHECK(!object.fromJSON("[ 1, 2 ]"));
 }
 
 BOOST_AUTO_TEST_CASE(json_schema_empty)
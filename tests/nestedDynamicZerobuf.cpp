@@ -9,6 +9,7 @@
 #include <testschema/testSchema.h>
 
 #include <utility>
+#include <vector>
 
 BOOST_AUTO_TEST_CASE(defaultValues)
 {
@@ -18,6 +19,35 @@ BOOST_AUTO_TEST_CASE(defaultValues)
     BOOST_CHECK_EQUAL(testNestedZerobuf.getNest().getUintvalue(), 17);
 }
 
+BOOST_AUTO_TEST_CASE(resetToDefaults)
+{
+    test::TestNestedZerobuf object;
+    object.getNest().setIntvalue(1);
+    object.getDynamic().setIntvalue(2);
+    object.getDynamic().setName("Hugo");
+    object.getNested().push_back(test::TestNested(1, 2));
+    BOOST_CHECK_NE(object, test::TestNestedZerobuf());
+
+    object.resetToDefaults();
+    BOOST_CHECK_EQUAL(object, test::TestNestedZerobuf());
+    BOOST_CHECK(object.getNested().empty());
+    BOOST_CHECK_EQUAL(object.getNest().getIntvalue(), -17);
+    BOOST_CHECK_EQUAL(object.getNest().getUintvalue(), 17);
+    BOOST_CHECK_EQUAL(object.getDynamic().getIntvalue(), 7);
+    BOOST_CHECK(object.getDynamic().getName().empty());
+
+    // nested static and dynamic objects stay valid zerobufs
+    const test::TestNested nest(object.getNest());
+    BOOST_CHECK_EQUAL(nest, test::TestNested(-17, 17));
+    test::TestDynamic dynamic;
+    BOOST_CHECK(dynamic.fromBinary(object.getDynamic().toBinary().ptr.get(),
+                                   object.getDynamic().toBinary().size));
+    BOOST_CHECK_EQUAL(dynamic.getIntvalue(), 7);
+
+    object.getDynamic().setName("Hugo");
+    BOOST_CHECK_EQUAL(object.getDynamic().getNameString(), "Hugo");
+}
+
 BOOST_AUTO_TEST_CASE(copyConstructTestNestedZerobuf)
 {
     test::TestNestedZerobuf temporary;
@@ -71,6 +101,91 @@ BOOST_AUTO_TEST_CASE(moveConstructTestNestedZerobuf)
                       std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(moveNestedMembers)
+{
+    test::TestNestedZerobuf temporary;
+    temporary.getDynamic().setName("Hugo");
+    temporary.getNest().setIntvalue(42);
+    test::TestNestedZerobuf object(std::move(temporary));
+
+    // nested members of both objects stay bound to their parent
+    object.getDynamic().setName("Otto");
+    object.getNest().setUintvalue(17);
+    test::TestNestedZerobuf copy;
+    BOOST_CHECK(copy.fromBinary(object.toBinary().ptr.get(),
+                                object.toBinary().size));
+    BOOST_CHECK_EQUAL(copy.getDynamic().getNameString(), "Otto");
+    BOOST_CHECK_EQUAL(copy.getNest(), test::TestNested(42, 17));
+
+    temporary.getDynamic().setName("Hugo");
+    BOOST_CHECK_EQUAL(temporary.getDynamic().getNameString(), "Hugo");
+    BOOST_CHECK_EQUAL(object.getDynamic().getNameString(), "Otto");
+
+    // nested members can't be moved out of their parent, they are copied
+    test::TestDynamic dynamic(std::move(object.getDynamic()));
+    test::TestNested nest(std::move(object.getNest()));
+    BOOST_CHECK_EQUAL(dynamic.getNameString(), "Otto");
+    BOOST_CHECK_EQUAL(nest, test::TestNested(42, 17));
+    dynamic.setName("Hugo");
+    nest.setIntvalue(1);
+    BOOST_CHECK_EQUAL(object.getDynamic().getNameString(), "Otto");
+    BOOST_CHECK_EQUAL(object.getNest(), test::TestNested(42, 17));
+
+    object.getNest() = std::move(nest);
+    BOOST_CHECK_EQUAL(object.getNest(), test::TestNested(1, 17));
+    BOOST_CHECK_EQUAL(object.toJSON(), test::TestNestedZerobuf(object).toJSON());
+}
+
+BOOST_AUTO_TEST_CASE(moveIntoVector)
+{
+    std::vector<test::TestNestedZerobuf> objects;
+    for (int i = 0; i < 100; ++i)
+    {
+        test::TestNestedZerobuf object;
+        object.getNest().setIntvalue(i);
+        object.getDynamic().setName(std::to_string(i));
+        objects.push_back(std::move(object));
+
+        // moved-from object is allocated again on access
+        BOOST_CHECK_EQUAL(object.getNest().getIntvalue(), 0);
+        BOOST_CHECK(object.getDynamic().getName().empty());
+        object.getDynamic().setName("moved");
+        BOOST_CHECK_EQUAL(object.getDynamic().getNameString(), "moved");
+    }
+
+    for (int i = 0; i < 100; ++i)
+    {
+        BOOST_CHECK_EQUAL(objects[i].getNest().getIntvalue(), i);
+        BOOST_CHECK_EQUAL(objects[i].getDynamic().getNameString(),
+                          std::to_string(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(readMovedFromObject)
+{
+    test::TestNestedZerobuf object;
+    object.getDynamic().setName("name");
+    const test::TestNestedZerobuf moved(std::move(object));
+
+    // const access reads the empty image without allocating
+    const test::TestNestedZerobuf& constObject = object;
+    const void* data = constObject.toBinary().ptr.get();
+    BOOST_CHECK_EQUAL(constObject.getNest().getIntvalue(), 0);
+    BOOST_CHECK_EQUAL(constObject.getDynamic().getNameString(), "");
+    BOOST_CHECK_EQUAL(constObject.toBinary().ptr.get(), data);
+
+    // the static section of a nested member is only allocated on modification
+    object.getNest().setIntvalue(1);
+    const size_t size = constObject.toBinary().size;
+    BOOST_CHECK_EQUAL(constObject.getDynamic().getNameString(), "");
+    BOOST_CHECK_EQUAL(constObject.toBinary().size, size);
+
+    object.getDynamic().setName("again");
+    BOOST_CHECK_GT(constObject.toBinary().size, size);
+    BOOST_CHECK_EQUAL(constObject.getDynamic().getNameString(), "again");
+    BOOST_CHECK_EQUAL(moved.getDynamic().getNameString(), "name");
+}
+
 BOOST_AUTO_TEST_CASE(changeTestNestedZerobuf)
 {
     test::TestNestedZerobuf object;
@@ -0,0 +1,82 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfAligned
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/alignedSchema.h>
+#include <testschema/testSchema.h>
+
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+const size_t numFieldUpdates = 10000000;
+const size_t numElements = 1000003;
+const size_t numArrayLoops = 200;
+
+template <class T>
+void benchmarkField(const std::string& name, T& object,
+                    double (T::*get)() const, void (T::*set)(double))
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < numFieldUpdates; ++i)
+        (object.*set)((object.*get)() + 1.0);
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << " double field: " << numFieldUpdates / seconds / 1e6
+              << " M updates/s" << std::endl;
+    BOOST_CHECK_EQUAL((object.*get)(), double(numFieldUpdates));
+}
+
+template <class V>
+void benchmarkArray(const std::string& name, V& vector)
+{
+    float sum = 0.f;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t loop = 0; loop < numArrayLoops; ++loop)
+    {
+        float* data = vector.data();
+        for (size_t i = 0; i < numElements; ++i)
+            data[i] = data[i] * 0.5f + 1.f;
+        sum += data[loop];
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << " float array (offset "
+              << reinterpret_cast<uintptr_t>(vector.data()) % 64
+              << "): " << numArrayLoops * numElements * sizeof(float) / seconds /
+                              1024. / 1024. / 1024.
+              << " GB/s" << std::endl;
+    BOOST_CHECK_GT(sum, 0.f);
+}
+}
+
+BOOST_AUTO_TEST_CASE(fields)
+{
+    // TestSchema packs its static members, AlignedSchema aligns them
+    test::TestSchema packed;
+    benchmarkField("packed", packed, &test::TestSchema::getDoublevalue,
+                   &test::TestSchema::setDoublevalue);
+    test::AlignedSchema aligned;
+    benchmarkField("aligned", aligned, &test::AlignedSchema::getValue,
+                   &test::AlignedSchema::setValue);
+}
+
+BOOST_AUTO_TEST_CASE(arrays)
+{
+    test::TestSchema packed;
+    packed.setStringvalue("odd");
+    packed.setFloatdynamic(std::vector<float>(numElements, 1.f));
+    benchmarkArray("packed", packed.getFloatdynamic());
+
+    test::AlignedSchema aligned;
+    aligned.setName("odd");
+    aligned.setPoints(std::vector<float>(numElements, 1.f));
+    benchmarkArray("aligned", aligned.getPoints());
+}
@@ -0,0 +1,66 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfAtomic
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/atomicSchema.h>
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+const size_t maxThreads = 8;
+const uint64_t numUpdates = 1000000;
+
+template <class F>
+void benchmark(const std::string& name, const F& update)
+{
+    for (size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < numThreads; ++i)
+            threads.emplace_back([&update] {
+                for (uint64_t j = 0; j < numUpdates; ++j)
+                    update();
+            });
+        for (auto& thread : threads)
+            thread.join();
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << name << " " << numThreads << " threads: "
+                  << numThreads * numUpdates / seconds / 1e6 << " M updates/s"
+                  << std::endl;
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(fetchAdd)
+{
+    test::AtomicCounters counters;
+    benchmark("fetchAdd", [&counters] {
+        counters.fetchAddCount(1, std::memory_order_relaxed);
+    });
+    benchmark("fetchAdd double", [&counters] { counters.fetchAddValue(1.0); });
+}
+
+BOOST_AUTO_TEST_CASE(mutexLocked)
+{
+    test::AtomicCounters counters;
+    std::mutex lock;
+    benchmark("mutex setter", [&counters, &lock] {
+        std::lock_guard<std::mutex> guard(lock);
+        counters.setCount(counters.getCount() + 1);
+    });
+    benchmark("mutex double", [&counters, &lock] {
+        std::lock_guard<std::mutex> guard(lock);
+        counters.setValue(counters.getValue() + 1.0);
+    });
+}
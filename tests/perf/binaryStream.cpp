@@ -0,0 +1,112 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfBinaryStream
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+#include <zerobuf/BinaryStream.h>
+#include <zerobuf/SegmentedAllocator.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+const size_t numFloats = 32 * 1024 * 1024; // 128 MB payload
+const size_t chunkSize = 64 * 1024;
+std::atomic<size_t> _maxAllocation(0);
+
+test::TestSchema createReceiver()
+{
+    return test::TestSchema(
+        zerobuf::AllocatorPtr(new zerobuf::SegmentedAllocator(
+            test::TestSchema::ZEROBUF_STATIC_SIZE(),
+            test::TestSchema::ZEROBUF_NUM_DYNAMICS())));
+}
+
+template <class F>
+void benchmark(const std::string& name, const F& function)
+{
+    _maxAllocation = 0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    const size_t size = function();
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << size / seconds / 1024. / 1024.
+              << " MB/s, largest buffer "
+              << _maxAllocation / 1024. << " KB" << std::endl;
+}
+}
+
+void* operator new(const size_t size)
+{
+    size_t max = _maxAllocation;
+    while (size > max && !_maxAllocation.compare_exchange_weak(max, size))
+        ;
+    if (void* ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+BOOST_AUTO_TEST_CASE(streamLargeObject)
+{
+    test::TestSchema source;
+    source.getFloatdynamic().resize(numFloats);
+    std::fill_n(source.getFloatdynamic().data(), numFloats, 1.f);
+    source.setStringvalue("large");
+
+    // receive the whole stream in a buffer before deserializing it
+    benchmark("buffered", [&] {
+        zerobuf::BinaryStreamWriter writer(source, chunkSize);
+        std::vector<uint8_t> buffer;
+        for (zerobuf::DynamicRange chunk = writer.next(); chunk.size > 0;
+             chunk = writer.next())
+        {
+            const uint8_t* data = static_cast<const uint8_t*>(chunk.data);
+            buffer.insert(buffer.end(), data, data + chunk.size);
+        }
+        test::TestSchema receiver = createReceiver();
+        BOOST_CHECK(receiver.fromBinary(buffer.data(), buffer.size()));
+        BOOST_CHECK_EQUAL(receiver.getFloatdynamic().size(), numFloats);
+        return buffer.size();
+    });
+
+    // rebuild the object incrementally from each transmitted chunk
+    benchmark("streamed", [&] {
+        zerobuf::BinaryStreamWriter writer(source, chunkSize);
+        test::TestSchema receiver = createReceiver();
+        bool floatsReady = false;
+        zerobuf::BinaryStreamReader reader(receiver, [&](size_t) {
+            floatsReady = floatsReady ||
+                          receiver.getFloatdynamicView().size() == numFloats;
+        });
+        std::vector<uint8_t> transport(chunkSize);
+        for (zerobuf::DynamicRange chunk = writer.next(); chunk.size > 0;
+             chunk = writer.next())
+        {
+            ::memcpy(transport.data(), chunk.data, chunk.size);
+            reader.read(transport.data(), chunk.size);
+        }
+        BOOST_CHECK(reader.isComplete());
+        BOOST_CHECK(floatsReady);
+        BOOST_CHECK_EQUAL(receiver.getFloatdynamic()[numFloats - 1], 1.f);
+        BOOST_CHECK_LE(size_t(_maxAllocation), chunkSize);
+        return size_t(writer.getSize());
+    });
+}
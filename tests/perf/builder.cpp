@@ -0,0 +1,88 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfBuilder
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+const size_t numMessages = 100000;
+const size_t numSizes = 16;
+
+// mixed-size payloads of a publisher
+struct Payload
+{
+    explicit Payload(const size_t i)
+        : ints(i * 7 + 1, int32_t(i))
+        , doubles(i * 3, double(i))
+        , bytes(i * 61 + 5, uint8_t(i))
+        , name(i * 5 + 3, 'a' + char(i))
+    {
+    }
+
+    std::vector<int32_t> ints;
+    std::vector<double> doubles;
+    std::vector<uint8_t> bytes;
+    std::string name;
+};
+
+template <class F>
+size_t benchmark(const std::string& name, const std::vector<Payload>& payloads,
+                 const F& function)
+{
+    size_t bytes = 0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < numMessages; ++i)
+    {
+        const test::TestSchema& message = function(payloads[i % numSizes]);
+        bytes += message.toBinary().size;
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << numMessages / seconds / 1e3 << " K msgs/s, "
+              << bytes / numMessages << " bytes/msg" << std::endl;
+    return bytes;
+}
+}
+
+BOOST_AUTO_TEST_CASE(assembleMessages)
+{
+    std::vector<Payload> payloads;
+    for (size_t i = 0; i < numSizes; ++i)
+        payloads.emplace_back(i);
+
+    const size_t setterBytes =
+        benchmark("setters", payloads, [](const Payload& payload) {
+            test::TestSchema message;
+            message.setIntdynamic(payload.ints);
+            message.setDoubledynamic(payload.doubles);
+            message.setUint8Tdynamic(payload.bytes);
+            message.setStringvalue(payload.name);
+            message.setUintvalue(17);
+            return message;
+        });
+
+    const size_t builderBytes =
+        benchmark("builder", payloads, [](const Payload& payload) {
+            test::TestSchema message = test::TestSchema::Builder()
+                                           .setIntdynamic(payload.ints)
+                                           .setDoubledynamic(payload.doubles)
+                                           .setUint8Tdynamic(payload.bytes)
+                                           .setStringvalue(payload.name)
+                                           .build();
+            message.setUintvalue(17);
+            return message;
+        });
+
+    BOOST_CHECK_LE(builderBytes, setterBytes);
+}
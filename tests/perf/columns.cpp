@@ -0,0 +1,61 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfColumns
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+
+#include <chrono>
+#include <iostream>
+#include <numeric>
+
+namespace
+{
+const size_t numElements = 10000000;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double elapsed(const Clock::time_point& start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+}
+
+BOOST_AUTO_TEST_CASE(sumColumn)
+{
+    test::TestSchema object;
+    auto& nested = object.getNesteddynamic();
+    nested.resize(numElements);
+
+    std::vector<int32_t> values(numElements);
+    for (size_t i = 0; i < numElements; ++i)
+        values[i] = int32_t(i % 1000);
+    test::TestNested::scatterIntvalue(nested, values);
+
+    auto start = Clock::now();
+    std::vector<int32_t> column(numElements);
+    test::TestNested::gatherIntvalue(nested, column.data());
+    const int64_t columnSum =
+        std::accumulate(column.begin(), column.end(), int64_t(0));
+    const double columnTime = elapsed(start);
+
+    start = Clock::now();
+    int64_t elementSum = 0;
+    const auto& constNested = nested;
+    for (size_t i = 0; i < numElements; ++i)
+        elementSum += constNested[i].getIntvalue();
+    const double elementTime = elapsed(start);
+
+    BOOST_CHECK_EQUAL(columnSum, elementSum);
+    std::cout << "Sum of " << numElements << " values: gather "
+              << numElements / columnTime / 1e6 << " M/s, operator[] "
+              << numElements / elementTime / 1e6 << " M/s" << std::endl;
+
+    start = Clock::now();
+    test::TestNested::scatterIntvalue(nested, column);
+    std::cout << "Scatter: " << numElements / elapsed(start) / 1e6 << " M/s"
+              << std::endl;
+}
@@ -0,0 +1,77 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfCompact
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/compactSchema.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace
+{
+const size_t numMessages = 1000000;
+const double linkBytesPerSecond = 1e9 / 8.; // 1 GbE
+
+test::ControlMessage createMessage()
+{
+    test::ControlMessage message;
+    message.setSequence(1);
+    message.setCommand("open");
+    message.setSource("viewer");
+    message.setDestination("renderer");
+    message.setSession("s42");
+    message.setUser("alice");
+    message.setHost("node17");
+    message.setApplication("tide");
+    message.setScene("cells");
+    message.setCamera("main");
+    message.setTool("lasso");
+    message.setArguments("-f");
+    message.setPrimary(test::ControlTarget(7, 0.5f));
+    return message;
+}
+
+// serializes and deserializes each message, returns its size on the wire
+template <class F>
+void benchmark(const std::string& name, const F& function)
+{
+    size_t size = 0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < numMessages; ++i)
+        size = function(i);
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << size << " bytes, "
+              << numMessages / seconds / 1e6 << " M msgs/s encode+decode, "
+              << linkBytesPerSecond / size / 1e6 << " M msgs/s on 1 GbE"
+              << std::endl;
+}
+}
+
+BOOST_AUTO_TEST_CASE(controlMessages)
+{
+    test::ControlMessage message = createMessage();
+    test::ControlMessage received;
+
+    benchmark("standard", [&](const size_t i) {
+        message.setSequence(i);
+        const zerobuf::Data& data = message.toBinary();
+        BOOST_CHECK(received.fromBinary(data));
+        return data.size;
+    });
+    BOOST_CHECK_EQUAL(received, message);
+
+    benchmark("compact", [&](const size_t i) {
+        message.setSequence(i);
+        const std::vector<uint8_t> data = message.toCompactBinary();
+        BOOST_CHECK(received.fromCompactBinary(data.data(), data.size()));
+        return data.size();
+    });
+    BOOST_CHECK_EQUAL(received, message);
+}
@@ -0,0 +1,71 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfCompactionPolicy
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+const size_t numEdits = 100000;
+const size_t reportInterval = 20000;
+
+// a long-lived state object with members growing and shrinking in turn
+void edit(test::TestSchema& object, const size_t i)
+{
+    object.setStringvalue(std::string(i % 997 + 1, 'a'));
+    object.getFloatdynamic().resize((i * 7) % 4099);
+    if (i % 5 == 0)
+        object.getDoubledynamic().push_back(double(i));
+    if (i % 1009 == 0)
+        object.getDoubledynamic().clear();
+    object.getNestedMember().setName(std::string(i % 31, 'n'));
+}
+
+void benchmark(const std::string& name, const zerobuf::CompactionPolicy& policy)
+{
+    test::TestSchema object;
+    object.setCompactionPolicy(policy);
+
+    std::cout << name << ": memory";
+    std::vector<double> latencies;
+    latencies.reserve(numEdits);
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 1; i <= numEdits; ++i)
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        edit(object, i);
+        const auto end = std::chrono::high_resolution_clock::now();
+        latencies.push_back(std::chrono::duration<double>(end - begin).count());
+
+        if (i % reportInterval == 0)
+        {
+            object.toBinarySegments(); // runs deferred compaction
+            std::cout << " " << object.toBinary().size / 1024 << "KB";
+        }
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << ", " << numEdits / seconds << " edits/s, 99.9% latency "
+              << latencies[numEdits * 999 / 1000] * 1000000. << " us"
+              << std::endl;
+}
+}
+
+BOOST_AUTO_TEST_CASE(editHeavyWorkload)
+{
+    benchmark("none", zerobuf::CompactionPolicy());
+    benchmark("eager", zerobuf::CompactionPolicy(.5f, .1f));
+    benchmark("budget", zerobuf::CompactionPolicy(.5f, .1f, 4096));
+    benchmark("deferred", zerobuf::CompactionPolicy(.5f, .1f, 0, true));
+}
@@ -0,0 +1,86 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfCompression
+
+#include <boost/test/unit_test.hpp>
+
+#include "../serialization.h"
+#include <zerobuf/compression.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+namespace
+{
+const zerobuf::Codec codecs[] = {zerobuf::Codec::none, zerobuf::Codec::zeroRun,
+                                 zerobuf::Codec::lz};
+const char* const codecNames[] = {"none", "zeroRun", "lz"};
+const size_t minBytes = 256 * 1024 * 1024;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double elapsed(const Clock::time_point& start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void benchmark(const std::string& name, const uint8_t* data, const size_t size)
+{
+    const size_t loops = std::max(minBytes / size, size_t(1));
+    for (size_t i = 0; i < 3; ++i)
+    {
+        auto start = Clock::now();
+        std::vector<uint8_t> compressed;
+        for (size_t j = 0; j < loops; ++j)
+            compressed = zerobuf::compress(data, size, codecs[i]);
+        const double compressTime = elapsed(start);
+
+        start = Clock::now();
+        std::vector<uint8_t> decompressed;
+        for (size_t j = 0; j < loops; ++j)
+            decompressed =
+                zerobuf::decompress(compressed.data(), compressed.size());
+        const double decompressTime = elapsed(start);
+        BOOST_CHECK_EQUAL(decompressed.size(), size);
+
+        const double megabytes = double(size * loops) / 1024. / 1024.;
+        std::cout << name << " " << codecNames[i] << ": ratio "
+                  << double(size) / double(compressed.size()) << ", compress "
+                  << megabytes / compressTime << " MB/s, decompress "
+                  << megabytes / decompressTime << " MB/s" << std::endl;
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(testSchema)
+{
+    const test::TestSchema object = getTestObject();
+    const zerobuf::Data& data = object.toBinary();
+    benchmark("TestSchema", reinterpret_cast<const uint8_t*>(data.ptr.get()),
+              data.size);
+}
+
+BOOST_AUTO_TEST_CASE(synthetic)
+{
+    std::mt19937 rng;
+    std::vector<uint8_t> random(16 * 1024 * 1024);
+    for (uint8_t& byte : random)
+        byte = uint8_t(rng());
+    benchmark("Random", random.data(), random.size());
+
+    // sparse payload: mostly zero with small, repetitive records
+    std::vector<uint8_t> sparse(random.size(), 0);
+    for (size_t i = 0; i < sparse.size(); i += 64)
+        for (size_t j = 0; j < 12; ++j)
+            sparse[i + j] = uint8_t(j + (i >> 12));
+    benchmark("Sparse", sparse.data(), sparse.size());
+
+    std::vector<float> floats(random.size() / sizeof(float));
+    for (size_t i = 0; i < floats.size(); ++i)
+        floats[i] = float(i % 1024) * 0.5f;
+    benchmark("Floats", reinterpret_cast<const uint8_t*>(floats.data()),
+              floats.size() * sizeof(float));
+}
@@ -0,0 +1,91 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfDefaults
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+#include <zerobuf/NonMovingAllocator.h>
+
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+const size_t numObjects = 1000000;
+
+template <class F>
+void benchmark(const std::string& name, const F& function)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < numObjects; ++i)
+        function();
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << numObjects / seconds / 1e6 << " M/s"
+              << std::endl;
+}
+
+// construction through the allocator constructor uses the setters
+template <class T>
+T createWithSetters()
+{
+    return T(zerobuf::AllocatorPtr(
+        new zerobuf::NonMovingAllocator(T::ZEROBUF_STATIC_SIZE(),
+                                        T::ZEROBUF_NUM_DYNAMICS())));
+}
+}
+
+BOOST_AUTO_TEST_CASE(construction)
+{
+    size_t sum = 0;
+    benchmark("TestSchema default image", [&sum] {
+        const test::TestSchema object;
+        sum += object.getUintvalue();
+    });
+    benchmark("TestSchema setters", [&sum] {
+        const test::TestSchema object(createWithSetters<test::TestSchema>());
+        sum += object.getUintvalue();
+    });
+    benchmark("TestNestedZerobuf default image", [&sum] {
+        const test::TestNestedZerobuf object;
+        sum += object.getNest().getUintvalue();
+    });
+    benchmark("TestNestedZerobuf setters", [&sum] {
+        const test::TestNestedZerobuf object(
+            createWithSetters<test::TestNestedZerobuf>());
+        sum += object.getNest().getUintvalue();
+    });
+    BOOST_CHECK_EQUAL(sum, numObjects * 2 * (42 + 17));
+}
+
+BOOST_AUTO_TEST_CASE(reset)
+{
+    test::TestSchema object;
+    benchmark("TestSchema resetToDefaults", [&object] {
+        object.setIntvalue(1);
+        object.resetToDefaults();
+    });
+    benchmark("TestSchema assign default object", [&object] {
+        object.setIntvalue(1);
+        object = test::TestSchema();
+    });
+    BOOST_CHECK_EQUAL(object, test::TestSchema());
+
+    test::TestNestedZerobuf nested;
+    benchmark("TestNestedZerobuf resetToDefaults", [&nested] {
+        nested.getNest().setIntvalue(1);
+        nested.resetToDefaults();
+    });
+    benchmark("TestNestedZerobuf setters", [&nested] {
+        nested.getNest().setIntvalue(1);
+        nested.setNest(test::TestNested(-17, 17));
+        nested.getDynamic().setIntvalue(7);
+        nested.getDynamic().getName().clear();
+        nested.getNested().clear();
+    });
+    BOOST_CHECK_EQUAL(nested, test::TestNestedZerobuf());
+}
@@ -0,0 +1,73 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfEnumJSON
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace
+{
+const size_t numValues = 1000000;
+const size_t numConversions = 10000000;
+const size_t numDocuments = 20000;
+
+template <class F>
+void benchmark(const std::string& name, const size_t numQueries,
+               const std::string& unit, const F& function)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < numQueries; ++i)
+        function(i);
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << numQueries / seconds << " " << unit << "/s"
+              << std::endl;
+}
+}
+
+BOOST_AUTO_TEST_CASE(enumConversion)
+{
+    const std::string names[] = {"FIRST", "SECOND", "THIRD_UNDERSCORE"};
+    size_t sum = 0;
+    benchmark("string_to_TestEnum", numConversions, "conversions",
+              [&](const size_t i) {
+                  sum += size_t(test::string_to_TestEnum(names[i % 3]));
+              });
+    BOOST_CHECK_EQUAL(sum, numConversions - 1);
+}
+
+BOOST_AUTO_TEST_CASE(enumVectorFromJSON)
+{
+    test::TestSchema object;
+    auto& values = object.getEnumdynamic();
+    for (size_t i = 0; i < numValues; ++i)
+        values.push_back(test::TestEnum(i % 3));
+    const std::string json = object.toJSON();
+    values.clear();
+
+    benchmark("fromJSON enum vector", 1, "documents",
+              [&](size_t) { BOOST_CHECK(object.fromJSON(json)); });
+    BOOST_CHECK_EQUAL(values.size(), numValues);
+    BOOST_CHECK_EQUAL(values[numValues - 1],
+                      test::TestEnum((numValues - 1) % 3));
+}
+
+BOOST_AUTO_TEST_CASE(fieldDispatch)
+{
+    test::TestSchema object;
+    object.setEnumeration(test::TestEnum::THIRD_UNDERSCORE);
+    const std::string json = object.toJSON();
+
+    benchmark("fromJSON TestSchema", numDocuments, "documents",
+              [&](size_t) { object.fromJSON(json); });
+    BOOST_CHECK_EQUAL(object.getEnumeration(),
+                      test::TestEnum::THIRD_UNDERSCORE);
+}
@@ -0,0 +1,75 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfFreeze
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+const size_t numFloats = 256 * 1024; // 1 MB payload
+const size_t numConsumers = 100;
+const size_t numPublications = 100;
+
+template <class F>
+void benchmark(const std::string& name, const F& function)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    const size_t checksum = function();
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    BOOST_CHECK_EQUAL(checksum, numConsumers * numPublications *
+                                    (numPublications - 1) / 2);
+    std::cout << name << ": " << numPublications / seconds
+              << " publications/s to " << numConsumers << " consumers"
+              << std::endl;
+}
+}
+
+BOOST_AUTO_TEST_CASE(fanOut)
+{
+    test::TestSchema source;
+    source.getFloatdynamic().resize(numFloats);
+
+    // each consumer gets its own copy
+    benchmark("copy", [&] {
+        size_t checksum = 0;
+        for (size_t i = 0; i < numPublications; ++i)
+        {
+            source.setIntvalue(int32_t(i));
+            std::vector<test::TestSchema> consumers;
+            consumers.reserve(numConsumers);
+            for (size_t j = 0; j < numConsumers; ++j)
+                consumers.emplace_back(source);
+            for (const test::TestSchema& consumer : consumers)
+                checksum += size_t(consumer.getIntvalue());
+        }
+        return checksum;
+    });
+
+    // all consumers share one snapshot, the writer copies once per update
+    benchmark("freeze", [&] {
+        size_t checksum = 0;
+        std::vector<std::shared_ptr<const test::TestSchema>> consumers;
+        for (size_t i = 0; i < numPublications; ++i)
+        {
+            source.setIntvalue(int32_t(i));
+            const std::shared_ptr<const test::TestSchema> snapshot =
+                source.freeze();
+            consumers.assign(numConsumers, snapshot);
+            for (const auto& consumer : consumers)
+                checksum += size_t(consumer->getIntvalue());
+        }
+        return checksum;
+    });
+}
@@ -0,0 +1,64 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfKeyLookup
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace
+{
+const int32_t numEntries = 100000;
+const size_t numLookups = 1000000;
+const size_t numLinearLookups = 1000;
+
+template <class F>
+void benchmark(const std::string& name, const size_t numQueries,
+               const F& function)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    size_t found = 0;
+    for (size_t i = 0; i < numQueries; ++i)
+        found += function(int32_t((i * 7919) % numEntries));
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    BOOST_CHECK_EQUAL(found, numQueries);
+    std::cout << name << ": " << numQueries / seconds << " lookups/s"
+              << std::endl;
+}
+}
+
+BOOST_AUTO_TEST_CASE(lookupTable)
+{
+    test::TestSchema object;
+    auto& table = object.getNesteddynamic();
+    for (int32_t i = 0; i < numEntries; ++i)
+        table.push_back(test::TestNested(int32_t((i * 7) % numEntries),
+                                         uint32_t(i)));
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    test::TestNested::sortByKey(table);
+    const auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "sortByKey: "
+              << std::chrono::duration<double>(end - start).count() * 1000.
+              << " ms for " << numEntries << " entries" << std::endl;
+
+    const auto& constTable = table;
+    benchmark("linear", numLinearLookups, [&](const int32_t key) {
+        for (const test::TestNested& entry : constTable)
+            if (entry.getIntvalue() == key)
+                return 1;
+        return 0;
+    });
+    benchmark("findByKey", numLookups, [&](const int32_t key) {
+        const size_t index = test::TestNested::findByKey(constTable, key);
+        return index < constTable.size() ? 1 : 0;
+    });
+}
@@ -0,0 +1,92 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfMove
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace
+{
+const size_t numObjects = 10000;
+const size_t numLoops = 100;
+std::atomic<size_t> _numAllocations(0);
+
+test::TestNestedZerobuf createObject(const size_t i)
+{
+    test::TestNestedZerobuf object;
+    object.getNest().setIntvalue(int32_t(i));
+    object.getDynamic().setName("object");
+    object.getNested().push_back(test::TestNested(int32_t(i), 0));
+    return object;
+}
+
+void report(const std::string& name, const size_t numMoves,
+            const std::chrono::high_resolution_clock::time_point& start,
+            const size_t allocations)
+{
+    const auto end = std::chrono::high_resolution_clock::now();
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << numMoves / seconds / 1e6 << " M moves/s, "
+              << allocations << " allocations" << std::endl;
+}
+}
+
+void* operator new(const size_t size)
+{
+    ++_numAllocations;
+    if (void* ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+BOOST_AUTO_TEST_CASE(vectorGrowth)
+{
+    size_t allocations = 0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < numLoops; ++i)
+    {
+        std::vector<test::TestNestedZerobuf> objects(numObjects);
+        const size_t before = _numAllocations;
+        objects.reserve(numObjects * 2); // moves all objects
+        allocations += _numAllocations - before - 1 /* vector storage */;
+    }
+    report("std::vector growth", numObjects * numLoops, start, allocations);
+    BOOST_CHECK_EQUAL(allocations, 0);
+}
+
+BOOST_AUTO_TEST_CASE(queue)
+{
+    std::vector<test::TestNestedZerobuf> slots(numObjects);
+    test::TestNestedZerobuf object = createObject(42);
+    size_t head = 0;
+    size_t tail = 0;
+
+    const size_t before = _numAllocations;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < numObjects * numLoops; ++i)
+    {
+        slots[head++ % numObjects] = std::move(object); // push
+        object = std::move(slots[tail++ % numObjects]); // pop
+    }
+    const size_t allocations = _numAllocations - before;
+    report("queue push/pop", 2 * numObjects * numLoops, start, allocations);
+
+    BOOST_CHECK_EQUAL(allocations, 0);
+    BOOST_CHECK_EQUAL(object, createObject(42));
+}
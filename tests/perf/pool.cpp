@@ -0,0 +1,102 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfPool
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+#include <zerobuf/Pool.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace
+{
+const size_t numMessages = 1000000; // per measurement, split over threads
+const size_t maxThreads = 32;
+std::atomic<size_t> _numAllocations(0);
+
+typedef zerobuf::Pool<test::TestSchema> SchemaPool;
+
+const std::vector<int32_t> payload(16, 42);
+
+size_t fill(test::TestSchema& message, const size_t i)
+{
+    message.setIntvalue(int32_t(i));
+    message.setIntdynamic(payload);
+    message.setStringvalue("message");
+    return message.getIntdynamicView().size(); // toBinary() allocates
+}
+
+template <class F>
+void benchmark(const std::string& name, const size_t numThreads,
+               const F& function)
+{
+    std::vector<std::thread> threads;
+    const size_t perThread = numMessages / numThreads;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < numThreads; ++i)
+        threads.emplace_back([&function, perThread] {
+            for (size_t j = 0; j < perThread; ++j)
+                function(j);
+        });
+    for (std::thread& thread : threads)
+        thread.join();
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ", " << numThreads
+              << " threads: " << perThread * numThreads / seconds / 1e6
+              << " M msgs/s" << std::endl;
+}
+}
+
+void* operator new(const size_t size)
+{
+    ++_numAllocations;
+    if (void* ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+BOOST_AUTO_TEST_CASE(steadyStateAllocations)
+{
+    for (size_t i = 0; i < 100; ++i) // warm up
+        fill(*SchemaPool::acquire(), i);
+
+    const size_t before = _numAllocations;
+    size_t values = 0;
+    for (size_t i = 0; i < numMessages; ++i)
+        values += fill(*SchemaPool::acquire(), i);
+    const size_t allocations = _numAllocations - before;
+
+    std::cout << "pooled: " << double(allocations) / numMessages
+              << " allocations/msg" << std::endl;
+    BOOST_CHECK_EQUAL(allocations, 0);
+    BOOST_CHECK_EQUAL(values, numMessages * payload.size());
+}
+
+BOOST_AUTO_TEST_CASE(throughput)
+{
+    for (size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+    {
+        benchmark("new objects", numThreads, [](const size_t i) {
+            test::TestSchema message;
+            fill(message, i);
+        });
+        benchmark("pooled objects", numThreads,
+                  [](const size_t i) { fill(*SchemaPool::acquire(), i); });
+    }
+}
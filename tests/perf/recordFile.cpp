@@ -0,0 +1,78 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfRecordFile
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+#include <zerobuf/RecordFile.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+namespace
+{
+const size_t numRecords = 10000000;
+const size_t numReads = 1000000;
+const std::string filename("perfRecordFile.zbr");
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double elapsed(const Clock::time_point& start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+}
+
+BOOST_AUTO_TEST_CASE(recordFile)
+{
+    std::remove(filename.c_str());
+    std::remove((filename + ".idx").c_str());
+
+    test::TestNested record;
+    auto start = Clock::now();
+    {
+        zerobuf::RecordFileWriter writer(filename);
+        for (size_t i = 0; i < numRecords; ++i)
+        {
+            record.setIntvalue(int32_t(i));
+            writer.append(record, i);
+        }
+    }
+    const double writeTime = elapsed(start);
+    std::cout << "Write: " << numRecords / writeTime << " records/s"
+              << std::endl;
+
+    start = Clock::now();
+    const zerobuf::RecordFileReader reader(filename);
+    std::cout << "Reopen: " << elapsed(start) * 1000. << " ms" << std::endl;
+    BOOST_REQUIRE_EQUAL(reader.getNumRecords(), numRecords);
+
+    std::mt19937_64 rng;
+    std::uniform_int_distribution<size_t> distribution(0, numRecords - 1);
+    std::vector<size_t> indices(numReads);
+    for (size_t& index : indices)
+        index = distribution(rng);
+
+    int64_t sum = 0;
+    start = Clock::now();
+    for (const size_t index : indices)
+        sum += reader.get<test::TestNested>(index)->getIntvalue();
+    const double readTime = elapsed(start);
+    std::cout << "Random read: " << readTime / numReads * 1e9 << " ns/record"
+              << std::endl;
+    BOOST_CHECK_GT(sum, 0);
+
+    start = Clock::now();
+    for (size_t i = 0; i < numReads; ++i)
+        sum += int64_t(reader.findRecord(indices[i]));
+    std::cout << "Timestamp lookup: " << elapsed(start) / numReads * 1e9
+              << " ns/record" << std::endl;
+
+    std::remove(filename.c_str());
+    std::remove((filename + ".idx").c_str());
+}
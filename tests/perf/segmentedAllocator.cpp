@@ -0,0 +1,64 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfSegmentedAllocator
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+#include <zerobuf/SegmentedAllocator.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+const size_t chunkSize = 1024 * 1024; // floats per append, 4 MB
+const size_t numChunks = 64;
+
+// appends chunks to a volume, interleaved with entries of a chunk index
+void benchmark(const std::string& name, test::TestSchema& object)
+{
+    const std::vector<float> chunk(chunkSize, 1.f);
+    std::chrono::duration<double> maxStall(0);
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < numChunks; ++i)
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        auto& volume = object.getFloatdynamic();
+        const size_t size = volume.size();
+        volume.resize(size + chunkSize);
+        ::memcpy(volume.data() + size, chunk.data(), chunkSize * sizeof(float));
+        object.getDoubledynamic().push_back(double(size));
+        const std::chrono::duration<double> stall =
+            std::chrono::high_resolution_clock::now() - begin;
+        maxStall = std::max(maxStall, stall);
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << numChunks * chunkSize * sizeof(float) /
+                                     seconds / 1024. / 1024.
+              << " MB/s, max stall " << maxStall.count() * 1000. << " ms"
+              << std::endl;
+    BOOST_CHECK_EQUAL(object.getFloatdynamic().size(), numChunks * chunkSize);
+}
+}
+
+BOOST_AUTO_TEST_CASE(incrementalGrowth)
+{
+    {
+        test::TestSchema contiguous;
+        benchmark("contiguous", contiguous);
+    }
+    test::TestSchema segmented(
+        zerobuf::AllocatorPtr(new zerobuf::SegmentedAllocator(
+            test::TestSchema::ZEROBUF_STATIC_SIZE(),
+            test::TestSchema::ZEROBUF_NUM_DYNAMICS())));
+    benchmark("segmented", segmented);
+}
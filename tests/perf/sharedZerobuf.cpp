@@ -0,0 +1,88 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfSharedZerobuf
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+#include <zerobuf/SharedZerobuf.h>
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+const size_t maxReaders = 64;
+const std::chrono::milliseconds duration(500);
+
+template <class R, class W>
+void benchmark(const std::string& name, const R& read, const W& write)
+{
+    for (size_t numReaders = 1; numReaders <= maxReaders; numReaders *= 2)
+    {
+        std::atomic<bool> running(true);
+        std::atomic<uint64_t> reads(0);
+        std::vector<std::thread> readers;
+        for (size_t i = 0; i < numReaders; ++i)
+            readers.emplace_back([&] {
+                uint64_t local = 0;
+                while (running)
+                {
+                    read();
+                    ++local;
+                }
+                reads += local;
+            });
+
+        uint64_t writes = 0;
+        const auto end = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < end)
+            write(writes++);
+        running = false;
+        for (auto& reader : readers)
+            reader.join();
+
+        const double seconds = std::chrono::duration<double>(duration).count();
+        std::cout << name << " " << numReaders << " readers: "
+                  << reads / seconds / 1e6 << " M reads/s, "
+                  << writes / seconds / 1e6 << " M writes/s" << std::endl;
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(sharedZerobuf)
+{
+    zerobuf::SharedZerobuf<test::TestNested> shared;
+    test::TestNested value;
+    benchmark("SharedZerobuf",
+              [&] {
+                  shared.read([](const test::TestNested& nested) {
+                      volatile int32_t v = nested.getIntvalue();
+                      (void)v;
+                  });
+              },
+              [&](const uint64_t i) {
+                  value.setIntvalue(int32_t(i));
+                  shared.publish(value);
+              });
+}
+
+BOOST_AUTO_TEST_CASE(mutexLocked)
+{
+    std::mutex lock;
+    test::TestNested shared;
+    benchmark("Mutex",
+              [&] {
+                  std::lock_guard<std::mutex> guard(lock);
+                  volatile int32_t v = shared.getIntvalue();
+                  (void)v;
+              },
+              [&](const uint64_t i) {
+                  std::lock_guard<std::mutex> guard(lock);
+                  shared.setIntvalue(int32_t(i));
+              });
+}
@@ -0,0 +1,59 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfSmallMessages
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+#include <zerobuf/NonMovingAllocator.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace
+{
+const size_t numMessages = 10000000;
+
+// heap allocator and data, as used before inline storage
+::zerobuf::AllocatorPtr createHeapAllocator()
+{
+    return ::zerobuf::AllocatorPtr(new ::zerobuf::NonMovingAllocator(
+        test::TestNested::ZEROBUF_STATIC_SIZE(), 0));
+}
+
+template <class F>
+void benchmark(const std::string& name, const F& function)
+{
+    uint64_t sum = 0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < numMessages; ++i)
+        sum += function(i);
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << numMessages / seconds / 1e6 << " M msgs/s"
+              << std::endl;
+    BOOST_CHECK_EQUAL(sum, uint64_t(numMessages) * (numMessages - 1));
+}
+}
+
+BOOST_AUTO_TEST_CASE(createCopyDestroy)
+{
+    benchmark("heap storage", [](const size_t i) {
+        test::TestNested message(createHeapAllocator());
+        message.setIntvalue(int32_t(i));
+        message.setUintvalue(uint32_t(i));
+        test::TestNested copy(createHeapAllocator());
+        copy = message;
+        return uint64_t(message.getIntvalue()) + copy.getUintvalue();
+    });
+
+    benchmark("inline storage", [](const size_t i) {
+        const test::TestNested message{int32_t(i), uint32_t(i)};
+        const test::TestNested copy(message);
+        return uint64_t(message.getIntvalue()) + copy.getUintvalue();
+    });
+}
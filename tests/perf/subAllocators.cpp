@@ -0,0 +1,88 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfSubAllocators
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <utility>
+
+namespace
+{
+const size_t numObjects = 200000;
+std::atomic<size_t> _numAllocations(0);
+
+// generated objects embed their sub-allocators, at most the root allocator
+// object is allocated per constructed object, the data itself is malloc'ed
+template <class F>
+void benchmark(const std::string& name, const size_t maxAllocations,
+               const F& function)
+{
+    const size_t allocations = _numAllocations;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < numObjects; ++i)
+        function();
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    const double perObject =
+        double(_numAllocations - allocations) / double(numObjects);
+    std::cout << name << ": " << numObjects / seconds / 1e6 << " M/s, "
+              << perObject << " allocations/op" << std::endl;
+    BOOST_CHECK_LE(perObject, double(maxAllocations));
+}
+}
+
+void* operator new(const size_t size)
+{
+    ++_numAllocations;
+    if (void* ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+BOOST_AUTO_TEST_CASE(construction)
+{
+    size_t sum = 0;
+    benchmark("TestNestedZerobuf construction", 1, [&sum] {
+        const test::TestNestedZerobuf object;
+        sum += object.getNest().getUintvalue();
+    });
+    benchmark("TestNestedArray construction", 1, [&sum] {
+        const test::TestNestedArray object;
+        sum += object.getNested()[63].getUintvalue();
+    });
+    BOOST_CHECK_EQUAL(sum, numObjects * 17);
+}
+
+BOOST_AUTO_TEST_CASE(move)
+{
+    test::TestNestedZerobuf nested;
+    nested.getNest().setUintvalue(1);
+    benchmark("TestNestedZerobuf move", 0, [&nested] {
+        test::TestNestedZerobuf moved(std::move(nested));
+        nested = std::move(moved);
+    });
+    BOOST_CHECK_EQUAL(nested.getNest().getUintvalue(), 1);
+
+    test::TestNestedArray array;
+    array.getNested()[63].setUintvalue(1);
+    benchmark("TestNestedArray move", 0, [&array] {
+        test::TestNestedArray moved(std::move(array));
+        array = std::move(moved);
+    });
+    BOOST_CHECK_EQUAL(array.getNested()[63].getUintvalue(), 1);
+}
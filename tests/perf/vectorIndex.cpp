@@ -0,0 +1,114 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE perfVectorIndex
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace
+{
+const int32_t numEntries = 1000000;
+const size_t numLookups = 10000000;
+const size_t numLinearLookups = 1000;
+
+template <class F>
+void benchmark(const std::string& name, const size_t numQueries,
+               const F& function)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    size_t found = 0;
+    for (size_t i = 0; i < numQueries; ++i)
+        found += function(int32_t((i * 7919) % numEntries));
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    BOOST_CHECK_EQUAL(found, numQueries);
+    std::cout << name << ": " << numQueries / seconds << " lookups/s"
+              << std::endl;
+}
+
+template <class F>
+void time(const std::string& name, const F& function)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    function();
+    const auto end = std::chrono::high_resolution_clock::now();
+    std::cout << name << ": "
+              << std::chrono::duration<double>(end - start).count() * 1000.
+              << " ms for " << numEntries << " entries" << std::endl;
+}
+}
+
+BOOST_AUTO_TEST_CASE(lookupTable)
+{
+    test::TestSchema object;
+    auto& table = object.getNesteddynamic();
+    table.resize(numEntries);
+    std::vector<int32_t> keys(numEntries);
+    std::vector<uint32_t> values(numEntries);
+    for (int32_t i = 0; i < numEntries; ++i)
+    {
+        keys[i] = int32_t((int64_t(i) * 7) % numEntries);
+        values[i] = uint32_t(i);
+    }
+    test::TestNested::scatterIntvalue(table, keys);
+    test::TestNested::scatterUintvalue(table, values);
+
+    std::unique_ptr<test::TestNested::KeyIndex> index;
+    time("build index", [&] {
+        index.reset(new test::TestNested::KeyIndex(table));
+    });
+    time("rebuild index", [&] { index->rebuild(); });
+
+    std::vector<uint8_t> binary;
+    index->toBinary(binary);
+    index.reset();
+    time("load index", [&] {
+        index.reset(new test::TestNested::KeyIndex(table, binary.data(),
+                                                   binary.size()));
+    });
+
+    const auto& constTable = table;
+    const std::vector<int32_t> column =
+        test::TestNested::gatherIntvalue(constTable);
+    benchmark("linear scan", numLinearLookups, [&](const int32_t key) {
+        for (const int32_t value : column)
+            if (value == key)
+                return 1;
+        return 0;
+    });
+    benchmark("VectorIndex", numLookups, [&](const int32_t key) {
+        return index->find(key) < constTable.size() ? 1 : 0;
+    });
+    index.reset();
+
+    time("sortByKey", [&] { test::TestNested::sortByKey(table); });
+    benchmark("findByKey", numLookups, [&](const int32_t key) {
+        const size_t i = test::TestNested::findByKey(constTable, key);
+        return i < constTable.size() ? 1 : 0;
+    });
+
+    // incremental maintenance while appending
+    test::TestSchema plain;
+    time("push_back", [&] {
+        for (int32_t i = 0; i < numEntries; ++i)
+            plain.getNesteddynamic().push_back(
+                test::TestNested(keys[i], values[i]));
+    });
+
+    test::TestSchema appended;
+    auto& growing = appended.getNesteddynamic();
+    test::TestNested::KeyIndex growingIndex(growing);
+    time("push_back with index", [&] {
+        for (int32_t i = 0; i < numEntries; ++i)
+            growing.push_back(test::TestNested(keys[i], values[i]));
+    });
+    BOOST_CHECK_EQUAL(growingIndex.find(keys[4711]), 4711);
+}
@@ -0,0 +1,72 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE pool
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+#include <zerobuf/Pool.h>
+
+#include <thread>
+
+typedef zerobuf::Pool<test::TestSchema> SchemaPool;
+
+BOOST_AUTO_TEST_CASE(recycle)
+{
+    SchemaPool::clear();
+    const void* data = nullptr;
+    const test::TestSchema* address = nullptr;
+    {
+        SchemaPool::Ptr object = SchemaPool::acquire();
+        BOOST_CHECK_EQUAL(*object, test::TestSchema());
+        object->setIntvalue(42);
+        object->setIntdynamic(std::vector<int32_t>(1000, 7));
+        object->getNestedMember().setName("nested");
+        address = object.get();
+        data = object->toBinary().ptr.get();
+        BOOST_CHECK_EQUAL(SchemaPool::getNumCached(), 0);
+    }
+    BOOST_CHECK_EQUAL(SchemaPool::getNumCached(), 1);
+
+    // recycled object is reset to defaults, but keeps its storage
+    SchemaPool::Ptr object = SchemaPool::acquire();
+    BOOST_CHECK_EQUAL(object.get(), address);
+    BOOST_CHECK_EQUAL(object->toBinary().ptr.get(), data);
+    BOOST_CHECK_EQUAL(*object, test::TestSchema());
+    BOOST_CHECK(object->getIntdynamicVector().empty());
+
+    object->setIntdynamic(std::vector<int32_t>(1000, 3));
+    BOOST_CHECK_EQUAL(object->toBinary().ptr.get(), data);
+    SchemaPool::clear();
+}
+
+BOOST_AUTO_TEST_CASE(overflow)
+{
+    SchemaPool::clear();
+    const size_t numObjects = SchemaPool::cacheSize * 2;
+    {
+        std::vector<SchemaPool::Ptr> objects;
+        for (size_t i = 0; i < numObjects; ++i)
+            objects.push_back(SchemaPool::acquire());
+    }
+    BOOST_CHECK_LE(SchemaPool::getNumCached(), SchemaPool::cacheSize);
+    BOOST_CHECK_EQUAL(SchemaPool::getNumCached() + SchemaPool::getNumShared(),
+                      numObjects);
+
+    // other threads take over the shared objects and return their cache on exit
+    std::thread thread([] {
+        BOOST_CHECK_EQUAL(SchemaPool::getNumCached(), 0);
+        SchemaPool::Ptr object = SchemaPool::acquire();
+        BOOST_CHECK_EQUAL(*object, test::TestSchema());
+        BOOST_CHECK_EQUAL(SchemaPool::getNumCached(),
+                          SchemaPool::cacheSize / 2 - 1);
+    });
+    thread.join();
+    BOOST_CHECK_EQUAL(SchemaPool::getNumCached() + SchemaPool::getNumShared(),
+                      numObjects);
+    SchemaPool::clear();
+    BOOST_CHECK_EQUAL(SchemaPool::getNumCached(), 0);
+    BOOST_CHECK_EQUAL(SchemaPool::getNumShared(), 0);
+}
@@ -0,0 +1,235 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE recordFile
+
+#include <boost/test/unit_test.hpp>
+
+#include "serialization.h"
+#include <zerobuf/RecordFile.h>
+
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+struct TempFile
+{
+    TempFile()
+        : name("recordFileTest." + std::to_string(::getpid()) + ".zbr")
+    {
+        remove();
+    }
+    ~TempFile() { remove(); }
+    void remove()
+    {
+        std::remove(name.c_str());
+        std::remove((name + ".idx").c_str());
+    }
+    const std::string name;
+};
+
+size_t fileSize(const std::string& name)
+{
+    FILE* file = std::fopen(name.c_str(), "rb");
+    std::fseek(file, 0, SEEK_END);
+    const size_t size = size_t(std::ftell(file));
+    std::fclose(file);
+    return size;
+}
+}
+
+BOOST_AUTO_TEST_CASE(writeAndRead)
+{
+    const TempFile file;
+    {
+        zerobuf::RecordFileWriter writer(file.name, 7);
+        for (int32_t i = 0; i < 100; ++i)
+            BOOST_CHECK_EQUAL(writer.append(test::TestNested(i, uint32_t(i)),
+                                            uint64_t(i) * 10),
+                              size_t(i));
+        BOOST_CHECK_EQUAL(writer.getNumRecords(), 100);
+    }
+
+    const zerobuf::RecordFileReader reader(file.name);
+    BOOST_REQUIRE_EQUAL(reader.getNumRecords(), 100);
+    for (size_t i = 0; i < 100; ++i)
+    {
+        const auto nested = reader.get<test::TestNested>(i);
+        BOOST_CHECK_EQUAL(nested->getIntvalue(), int32_t(i));
+        BOOST_CHECK_EQUAL(nested->getUintvalue(), uint32_t(i));
+        BOOST_CHECK_EQUAL(reader.getTimestamp(i), i * 10);
+    }
+    BOOST_CHECK_THROW(reader.getData(100), std::runtime_error);
+
+    BOOST_CHECK_EQUAL(reader.findRecord(0), 0);
+    BOOST_CHECK_EQUAL(reader.findRecord(15), 2);
+    BOOST_CHECK_EQUAL(reader.findRecord(20), 2);
+    BOOST_CHECK_EQUAL(reader.findRecord(990), 99);
+    BOOST_CHECK_EQUAL(reader.findRecord(991), 100);
+}
+
+BOOST_AUTO_TEST_CASE(dynamicRecords)
+{
+    const TempFile file;
+    const test::TestSchema object = getTestObject();
+    {
+        zerobuf::RecordFileWriter writer(file.name);
+        writer.append(object, 1);
+        writer.append(test::TestSchema(), 2);
+    }
+
+    const zerobuf::RecordFileReader reader(file.name);
+    BOOST_REQUIRE_EQUAL(reader.getNumRecords(), 2);
+    BOOST_CHECK_EQUAL(*reader.get<test::TestSchema>(0), object);
+    BOOST_CHECK_EQUAL(*reader.get<test::TestSchema>(1), test::TestSchema());
+}
+
+BOOST_AUTO_TEST_CASE(appendToExisting)
+{
+    const TempFile file;
+    {
+        zerobuf::RecordFileWriter writer(file.name);
+        writer.append(test::TestNested(1, 1), 1);
+    }
+    {
+        zerobuf::RecordFileWriter writer(file.name);
+        BOOST_CHECK_EQUAL(writer.getNumRecords(), 1);
+        BOOST_CHECK_THROW(writer.append(test::TestNested(0, 0), 0),
+                          std::runtime_error);
+        BOOST_CHECK_EQUAL(writer.append(test::TestNested(2, 2), 2), 1);
+    }
+
+    const zerobuf::RecordFileReader reader(file.name);
+    BOOST_REQUIRE_EQUAL(reader.getNumRecords(), 2);
+    BOOST_CHECK_EQUAL(reader.get<test::TestNested>(1)->getIntvalue(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(recoverUnindexedTail)
+{
+    const TempFile file;
+    const std::string indexName = file.name + ".idx";
+    {
+        zerobuf::RecordFileWriter writer(file.name, 10);
+        for (int32_t i = 0; i < 25; ++i)
+            writer.append(test::TestNested(i, 0), uint64_t(i));
+        writer.flush();
+    }
+
+    // simulate a crash after the data was written but before the last index
+    // flush, leaving a partial index entry
+    const size_t indexSize = fileSize(indexName);
+    BOOST_REQUIRE_EQUAL(::truncate(indexName.c_str(),
+                                   off_t(indexSize - 5 * 16 - 3)),
+                        0);
+    {
+        const zerobuf::RecordFileReader reader(file.name);
+        BOOST_REQUIRE_EQUAL(reader.getNumRecords(), 25);
+        for (size_t i = 0; i < 25; ++i)
+            BOOST_CHECK_EQUAL(reader.get<test::TestNested>(i)->getIntvalue(),
+                              int32_t(i));
+        BOOST_CHECK_EQUAL(reader.findRecord(22), 22);
+    }
+
+    // simulate a crash in the middle of writing the last record
+    const size_t dataSize = fileSize(file.name);
+    BOOST_REQUIRE_EQUAL(::truncate(file.name.c_str(), off_t(dataSize - 4)), 0);
+    {
+        const zerobuf::RecordFileReader reader(file.name);
+        BOOST_CHECK_EQUAL(reader.getNumRecords(), 24);
+    }
+    {
+        zerobuf::RecordFileWriter writer(file.name, 10);
+        BOOST_CHECK_EQUAL(writer.getNumRecords(), 24);
+        writer.append(test::TestNested(42, 0), 42);
+    }
+
+    const zerobuf::RecordFileReader reader(file.name);
+    BOOST_REQUIRE_EQUAL(reader.getNumRecords(), 25);
+    BOOST_CHECK_EQUAL(reader.get<test::TestNested>(24)->getIntvalue(), 42);
+}
+
+BOOST_AUTO_TEST_CASE(corruptRecord)
+{
+    const TempFile file;
+    {
+        zerobuf::RecordFileWriter writer(file.name, 100);
+        for (int32_t i = 0; i < 10; ++i)
+            writer.append(test::TestNested(i, 0), uint64_t(i));
+        writer.flush();
+    }
+    BOOST_REQUIRE_EQUAL(::truncate((file.name + ".idx").c_str(), 0), 0);
+
+    // flip a payload byte of the 6th record, recovery stops before it
+    size_t offset = 0;
+    {
+        const zerobuf::RecordFileReader reader(file.name);
+        const uint8_t* first = static_cast<const uint8_t*>(reader.getData(0));
+        offset = 64 /* first payload */ +
+                 size_t(static_cast<const uint8_t*>(reader.getData(5)) - first);
+    }
+    const int fd = ::open(file.name.c_str(), O_RDWR);
+    BOOST_REQUIRE(fd >= 0);
+    const uint8_t garbage = 0xff;
+    BOOST_CHECK_EQUAL(::pwrite(fd, &garbage, 1, off_t(offset + 6)), 1);
+    ::close(fd);
+
+    const zerobuf::RecordFileReader reader(file.name);
+    BOOST_CHECK_EQUAL(reader.getNumRecords(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(alignedRecords)
+{
+    const TempFile file;
+    {
+        zerobuf::RecordFileWriter writer(file.name);
+        for (size_t i = 0; i < 10; ++i)
+            writer.append(std::string(i * 7, 'x').data(), i * 7, i);
+    }
+
+    const zerobuf::RecordFileReader reader(file.name);
+    BOOST_REQUIRE_EQUAL(reader.getNumRecords(), 10);
+    for (size_t i = 0; i < 10; ++i)
+    {
+        BOOST_CHECK_EQUAL(size_t(reader.getData(i)) % 64, 0);
+        BOOST_CHECK_EQUAL(reader.getSize(i), i * 7);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(corruptIndex)
+{
+    const TempFile file;
+    {
+        zerobuf::RecordFileWriter writer(file.name);
+        for (int32_t i = 0; i < 10; ++i)
+            writer.append(test::TestNested(i, 0), uint64_t(i));
+    }
+
+    // point the first index entry past the end of the data file
+    const int fd = ::open((file.name + ".idx").c_str(), O_RDWR);
+    BOOST_REQUIRE(fd >= 0);
+    const uint64_t offset = uint64_t(1) << 40;
+    BOOST_CHECK_EQUAL(::pwrite(fd, &offset, sizeof(offset), 16),
+                      ssize_t(sizeof(offset)));
+    ::close(fd);
+
+    const zerobuf::RecordFileReader reader(file.name);
+    BOOST_REQUIRE_EQUAL(reader.getNumRecords(), 10);
+    BOOST_CHECK_THROW(reader.getData(0), std::runtime_error);
+    BOOST_CHECK_EQUAL(reader.get<test::TestNested>(9)->getIntvalue(), 9);
+}
+
+BOOST_AUTO_TEST_CASE(emptyFile)
+{
+    const TempFile file;
+    {
+        zerobuf::RecordFileWriter writer(file.name);
+    }
+    const zerobuf::RecordFileReader reader(file.name);
+    BOOST_CHECK_EQUAL(reader.getNumRecords(), 0);
+    BOOST_CHECK_EQUAL(reader.findRecord(0), 0);
+    BOOST_CHECK_THROW(zerobuf::RecordFileReader("doesNotExist.zbr"),
+                      std::runtime_error);
+}
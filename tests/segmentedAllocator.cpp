@@ -0,0 +1,172 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE segmentedAllocator
+
+#include <boost/test/unit_test.hpp>
+
+#include "serialization.h"
+#include <testschema/alignedSchema.h>
+#include <zerobuf/SegmentedAllocator.h>
+
+#include <cstring>
+
+namespace
+{
+template <class T>
+zerobuf::AllocatorPtr createAllocator(const size_t alignment = 1)
+{
+    return zerobuf::AllocatorPtr(
+        new zerobuf::SegmentedAllocator(T::ZEROBUF_STATIC_SIZE(),
+                                        T::ZEROBUF_NUM_DYNAMICS(), alignment));
+}
+
+std::vector<uint8_t> gather(const std::vector<zerobuf::DynamicRange>& ranges)
+{
+    std::vector<uint8_t> binary;
+    for (const zerobuf::DynamicRange& range : ranges)
+    {
+        const uint8_t* data = static_cast<const uint8_t*>(range.data);
+        binary.insert(binary.end(), data, data + range.size);
+    }
+    return binary;
+}
+}
+
+BOOST_AUTO_TEST_CASE(copyToAndFromSegments)
+{
+    const test::TestSchema source = getTestObject();
+
+    test::TestSchema segmented(createAllocator<test::TestSchema>());
+    segmented = source;
+    checkTestObject(segmented);
+    BOOST_CHECK_EQUAL(segmented, source);
+
+    // regular objects copy and read segmented ones
+    const test::TestSchema copy(segmented);
+    checkTestObject(copy);
+    test::TestSchema binaryCopy;
+    BOOST_CHECK(binaryCopy.fromBinary(segmented.toBinary()));
+    checkTestObject(binaryCopy);
+
+    // the scatter-gather list is the binary
+    const std::vector<zerobuf::DynamicRange> ranges =
+        segmented.toBinarySegments();
+    BOOST_CHECK_GT(ranges.size(), 1);
+    const std::vector<uint8_t> binary = gather(ranges);
+    const zerobuf::Data& data = segmented.toBinary();
+    BOOST_CHECK_EQUAL(binary.size(), data.size);
+    BOOST_CHECK_EQUAL(::memcmp(binary.data(), data.ptr.get(), data.size), 0);
+
+    // regular objects have a single range
+    BOOST_CHECK_EQUAL(copy.toBinarySegments().size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(transparentAccess)
+{
+    test::TestSchema segmented(createAllocator<test::TestSchema>());
+    test::TestSchema regular;
+    for (test::TestSchema* object : {&segmented, &regular})
+    {
+        object->setIntvalue(42);
+        object->setStringvalue("segments");
+        object->getNestedMember().setName("nested");
+        for (int32_t i = 0; i < 1000; ++i)
+        {
+            object->getIntdynamic().push_back(i);
+            object->getDoubledynamic().push_back(i * 0.5);
+        }
+        object->getNesteddynamic().push_back(test::TestNested(1, 2));
+    }
+    BOOST_CHECK_EQUAL(segmented, regular);
+
+    int32_t expected = 0;
+    for (const int32_t value : segmented.getIntdynamic())
+        BOOST_CHECK_EQUAL(value, expected++);
+    BOOST_CHECK_EQUAL(segmented.getDoubledynamic()[999], 499.5);
+    BOOST_CHECK_EQUAL(segmented.getNestedMember().getNameString(), "nested");
+    BOOST_CHECK_EQUAL(segmented.getNesteddynamic()[0].getUintvalue(), 2);
+
+    test::TestSchema fromSegmented;
+    BOOST_CHECK(fromSegmented.fromBinary(segmented.toBinary()));
+    BOOST_CHECK_EQUAL(fromSegmented, regular);
+}
+
+BOOST_AUTO_TEST_CASE(independentGrowth)
+{
+    zerobuf::SegmentedAllocator* allocator = new zerobuf::SegmentedAllocator(
+        test::TestSchema::ZEROBUF_STATIC_SIZE(),
+        test::TestSchema::ZEROBUF_NUM_DYNAMICS());
+    test::TestSchema object{zerobuf::AllocatorPtr(allocator)};
+    object.setStringvalue("does not move");
+    const char* string = object.getStringvalueView().data();
+
+    const size_t numFloats = 10000;
+    for (size_t i = 0; i < numFloats; ++i)
+        object.getFloatdynamic().push_back(float(i));
+    BOOST_CHECK_EQUAL(
+        static_cast<const void*>(object.getStringvalueView().data()),
+        static_cast<const void*>(string));
+    BOOST_CHECK_EQUAL(object.getFloatdynamic()[numFloats - 1],
+                      float(numFloats - 1));
+
+    // geometric growth of the segment, released by compact
+    size_t index = 0;
+    while (allocator->getDynamicSize(index) != numFloats * sizeof(float))
+        ++index;
+    BOOST_CHECK_GE(allocator->getCapacity(index), numFloats * sizeof(float));
+    object.getFloatdynamic().clear();
+    object.compact(0.f);
+    BOOST_CHECK_EQUAL(allocator->getCapacity(index), 0);
+    BOOST_CHECK_EQUAL(object.getStringvalueString(), "does not move");
+
+    // compact binary layout
+    size_t size = object.getZerobufStaticSize();
+    for (size_t i = 0; i < object.getZerobufNumDynamics(); ++i)
+        size += allocator->getDynamicSize(i);
+    BOOST_CHECK_EQUAL(object.toBinary().size, size);
+}
+
+BOOST_AUTO_TEST_CASE(alignment)
+{
+    test::AlignedSchema object(createAllocator<test::AlignedSchema>(64));
+    object.setName("aligned");
+    for (size_t i = 0; i < 100; ++i)
+    {
+        object.getPoints().push_back(float(i));
+        object.getNested().getWeights().push_back(float(i));
+        BOOST_CHECK_EQUAL(size_t(object.getPoints().data()) % 64, 0);
+        BOOST_CHECK_EQUAL(size_t(object.getNested().toBinary().ptr.get()) % 64,
+                          0);
+    }
+
+    const zerobuf::Data& data = object.toBinary();
+    const std::vector<uint8_t> binary = gather(object.toBinarySegments());
+    BOOST_CHECK_EQUAL(binary.size(), data.size);
+    BOOST_CHECK_EQUAL(::memcmp(binary.data(), data.ptr.get(), data.size), 0);
+
+    test::AlignedSchema copy;
+    BOOST_CHECK(copy.fromBinary(data));
+    BOOST_CHECK_EQUAL(copy, object);
+}
+
+BOOST_AUTO_TEST_CASE(adoptBinaryKeepsAllocator)
+{
+    const test::TestSchema source = getTestObject();
+    const zerobuf::Data& data = source.toBinary();
+    uint8_t* buffer = new uint8_t[data.size];
+    ::memcpy(buffer, data.ptr.get(), data.size);
+    size_t released = 0;
+    const auto deleter = [&released](uint8_t* ptr) {
+        ++released;
+        delete[] ptr;
+    };
+
+    // custom allocators copy the data and release the buffer
+    test::TestSchema object(createAllocator<test::TestSchema>());
+    BOOST_CHECK(object.adoptBinary(buffer, data.size, deleter));
+    BOOST_CHECK_EQUAL(released, 1);
+    checkTestObject(object);
+    BOOST_CHECK_GT(object.toBinarySegments().size(), 1);
+}
@@ -10,6 +10,35 @@
 
 #include "serialization.h"
 
+#include <zerobuf/NonMovingAllocator.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+class CountingSchema : public test::TestSchema
+{
+public:
+    size_t numChanged = 0;
+
+    // the per-member diff of the generated Qt _fromBinary(), using the
+    // dynamic index of stringvalue and the offset of intvalue
+    bool hasStringChanged(const zerobuf::Data& data) const
+    {
+        return _hasDynamicChanged(data.ptr.get(), data.size, 18);
+    }
+    bool hasIntChanged(const zerobuf::Data& data) const
+    {
+        return _hasChanged(data.ptr.get(), data.size, 356, 4);
+    }
+
+protected:
+    void notifyChanged() final { ++numChanged; }
+};
+}
+
 BOOST_AUTO_TEST_CASE(defaultValues)
 {
     test::TestSchema object;
@@ -23,6 +52,40 @@ BOOST_AUTO_TEST_CASE(defaultValues)
     BOOST_CHECK_EQUAL(small.getDynamic().getIntvalue(), 7);
 }
 
+BOOST_AUTO_TEST_CASE(resetToDefaults)
+{
+    test::TestSchema object = getTestObject();
+    BOOST_CHECK_NE(object, test::TestSchema());
+
+    object.resetToDefaults();
+    BOOST_CHECK_EQUAL(object, test::TestSchema());
+    BOOST_CHECK_EQUAL(object.getIntvalue(), 0);
+    BOOST_CHECK_EQUAL(object.getUintvalue(), 42);
+    BOOST_CHECK_EQUAL(object.getFloatvalue(), 4.2f);
+    BOOST_CHECK(object.getTrueBool());
+    BOOST_CHECK(object.getStringvalue().empty());
+    BOOST_CHECK(object.getIntdynamic().empty());
+
+    // a view on existing data keeps its values
+    const test::TestSchema& source = getTestObject();
+    test::TestSchema view(zerobuf::AllocatorPtr(
+        new zerobuf::NonMovingAllocator(source.getZerobufStaticSize(),
+                                        source.getZerobufNumDynamics())));
+    view = source;
+    checkTestObject(view);
+    view.resetToDefaults();
+    view.compact(0.f);
+    BOOST_CHECK_EQUAL(view, test::TestSchema());
+    BOOST_CHECK_LT(view.toBinary().size, source.toBinary().size);
+
+    const test::ConstTestSchemaPtr constObject =
+        test::TestSchema::create(source.toBinary().ptr.get(),
+                                 source.toBinary().size);
+    BOOST_CHECK_THROW(const_cast<test::TestSchema&>(*constObject)
+                          .resetToDefaults(),
+                      std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(initialized)
 {
     const test::TestSchema& schema = getTestObject();
@@ -83,6 +146,56 @@ BOOST_AUTO_TEST_CASE(test_string)
     BOOST_CHECK_EQUAL(emptyMessage, object.getStringvalueString());
 }
 
+BOOST_AUTO_TEST_CASE(stringView)
+{
+    test::TestSchema object;
+    BOOST_CHECK(object.getStringvalueView().empty());
+
+    object.setStringvalue("The quick brown fox");
+    const zerobuf::StringView view = object.getStringvalueView();
+    BOOST_CHECK_EQUAL(view.size(), 19);
+    BOOST_CHECK_EQUAL(static_cast<const void*>(view.data()),
+                      static_cast<const void*>(object.getStringvalue().data()));
+    BOOST_CHECK(view == "The quick brown fox");
+    BOOST_CHECK(view.substr(4, 5) == "quick");
+    BOOST_CHECK(view != "The quick");
+    BOOST_CHECK_EQUAL(std::string(view), object.getStringvalueString());
+
+    // not null-terminated
+    const char buffer[] = "foxes";
+    object.setStringvalue(zerobuf::StringView(buffer, 3));
+    BOOST_CHECK(object.getStringvalueView() == "fox");
+
+    std::ostringstream os;
+    os << object.getStringvalueView() << "|" << object.getStringvalue();
+    BOOST_CHECK_EQUAL(os.str(), "fox|fox");
+
+    object.setStringvalue(std::string("std::string"));
+    BOOST_CHECK_EQUAL(object.getStringvalueString(), "std::string");
+}
+
+BOOST_AUTO_TEST_CASE(arrayView)
+{
+    test::TestSchema object;
+    BOOST_CHECK(object.getUint8TdynamicView().empty());
+
+    const std::vector<uint8_t> bytes{1, 2, 3, 4};
+    object.setUint8Tdynamic(bytes);
+    const zerobuf::ByteView view = object.getUint8TdynamicView();
+    BOOST_CHECK_EQUAL(view.size(), 4);
+    BOOST_CHECK_EQUAL(view.data(), object.getUint8Tdynamic().data());
+    BOOST_CHECK(view == zerobuf::ByteView(bytes));
+    BOOST_CHECK(view.toVector() == bytes);
+    BOOST_CHECK_EQUAL(view[2], 3);
+    BOOST_CHECK_THROW(view.at(4), std::runtime_error);
+
+    object.setIntdynamic(std::vector<int32_t>{3, 4, 5});
+    int32_t sum = 0;
+    for (const int32_t value : object.getIntdynamicView())
+        sum += value;
+    BOOST_CHECK_EQUAL(sum, 12);
+}
+
 BOOST_AUTO_TEST_CASE(mutablePODArrays)
 {
     test::TestSchema object;
@@ -192,3 +305,144 @@ BOOST_AUTO_TEST_CASE(compact)
     copy.fromJSON(schema.toJSON());
     BOOST_CHECK_EQUAL(schema.toBinary().size, copy.toBinary().size);
 }
+
+BOOST_AUTO_TEST_CASE(adoptBinary)
+{
+    const test::TestSchema& source = getTestObject();
+    const zerobuf::Data& data = source.toBinary();
+
+    // malloc'ed buffer, released with free()
+    uint8_t* buffer = (uint8_t*)::malloc(data.size);
+    ::memcpy(buffer, data.ptr.get(), data.size);
+    test::TestSchema object;
+    BOOST_CHECK(object.adoptBinary(buffer, data.size));
+    BOOST_CHECK_EQUAL(object.toBinary().ptr.get(), buffer);
+    checkTestObject(object);
+
+    // adopted buffers grow like own storage
+    object.setStringvalue(std::string(1000, 'x'));
+    BOOST_CHECK_EQUAL(object.getStringvalueString(), std::string(1000, 'x'));
+
+    // custom deleter, buffer released with the object
+    size_t released = 0;
+    const auto deleter = [&released](uint8_t* ptr) {
+        ++released;
+        delete[] ptr;
+    };
+    buffer = new uint8_t[data.size];
+    ::memcpy(buffer, data.ptr.get(), data.size);
+    {
+        test::TestSchema adopted;
+        BOOST_CHECK(adopted.adoptBinary(buffer, data.size, deleter));
+        checkTestObject(adopted);
+
+        const test::TestSchema moved(std::move(adopted));
+        BOOST_CHECK_EQUAL(moved.toBinary().ptr.get(), buffer);
+        checkTestObject(moved);
+        BOOST_CHECK_EQUAL(released, 0);
+    }
+    BOOST_CHECK_EQUAL(released, 1);
+
+    // nested members copy the data and release the buffer immediately
+    test::TestDynamic dynamic;
+    dynamic.setName("Hugo");
+    const zerobuf::Data& dynamicData = dynamic.toBinary();
+    buffer = new uint8_t[dynamicData.size];
+    ::memcpy(buffer, dynamicData.ptr.get(), dynamicData.size);
+    test::TestNestedZerobuf nested;
+    BOOST_CHECK(nested.getDynamic().adoptBinary(buffer, dynamicData.size,
+                                                deleter));
+    BOOST_CHECK_EQUAL(released, 2);
+    BOOST_CHECK_EQUAL(nested.getDynamic().getNameString(), "Hugo");
+
+    // invalid buffers stay with the caller
+    const uint8_t* bytes = static_cast<const uint8_t*>(data.ptr.get());
+    std::vector<uint8_t> corrupt(bytes, bytes + data.size);
+    BOOST_CHECK_THROW(object.adoptBinary(corrupt.data(), 16, deleter),
+                      std::runtime_error);
+    corrupt[0] = 0; // version
+    BOOST_CHECK(!object.adoptBinary(corrupt.data(), corrupt.size(), deleter));
+    BOOST_CHECK_EQUAL(released, 2);
+    BOOST_CHECK_EQUAL(object.getStringvalueString(), std::string(1000, 'x'));
+}
+
+BOOST_AUTO_TEST_CASE(fromBinaryChanges)
+{
+    CountingSchema object;
+    const test::TestSchema source = getTestObject();
+    BOOST_CHECK(object.fromBinary(source.toBinary()));
+    BOOST_CHECK_EQUAL(object.numChanged, 1);
+
+    // notifyChanged() is called on every copy, also of identical data
+    BOOST_CHECK(object.fromBinary(source.toBinary()));
+    BOOST_CHECK_EQUAL(object.numChanged, 2);
+    BOOST_CHECK(!object.hasStringChanged(source.toBinary()));
+    BOOST_CHECK(!object.hasIntChanged(source.toBinary()));
+
+    // identical members with a different layout of the dynamic members
+    test::TestSchema relaid = source;
+    relaid.setStringvalue(std::string(100, 'x'));
+    relaid.setStringvalue(source.getStringvalueString());
+    BOOST_CHECK(!object.hasStringChanged(relaid.toBinary()));
+
+    // changed static member
+    test::TestSchema changed = source;
+    changed.setIntvalue(source.getIntvalue() + 1);
+    BOOST_CHECK(object.hasIntChanged(changed.toBinary()));
+    BOOST_CHECK(!object.hasStringChanged(changed.toBinary()));
+
+    // changed size of a dynamic member
+    changed.setStringvalue(source.getStringvalueString() + "!");
+    BOOST_CHECK(object.hasStringChanged(changed.toBinary()));
+
+    // changed content of a dynamic member with the same size
+    std::string string = source.getStringvalueString();
+    string[0] = string[0] == 'a' ? 'b' : 'a';
+    changed.setStringvalue(string);
+    BOOST_CHECK(object.hasStringChanged(changed.toBinary()));
+    BOOST_CHECK(object.fromBinary(changed.toBinary()));
+    BOOST_CHECK_EQUAL(object.numChanged, 3);
+    BOOST_CHECK(!object.hasStringChanged(changed.toBinary()));
+}
+
+BOOST_AUTO_TEST_CASE(inlineStorage)
+{
+    const auto isInline = [](const test::TestNested& object) {
+        const uint8_t* data =
+            static_cast<const uint8_t*>(object.toBinary().ptr.get());
+        const uint8_t* begin = reinterpret_cast<const uint8_t*>(&object);
+        return data >= begin && data < begin + sizeof(object);
+    };
+
+    test::TestNested object(42, 17);
+    BOOST_CHECK(isInline(object));
+
+    const test::TestNested copy(object);
+    BOOST_CHECK(isInline(copy));
+    BOOST_CHECK_EQUAL(copy, object);
+
+    test::TestNested moved(std::move(object));
+    BOOST_CHECK(isInline(moved));
+    BOOST_CHECK_EQUAL(moved, copy);
+    BOOST_CHECK(!isInline(object)); // const access reads the empty image
+    BOOST_CHECK_EQUAL(object.getIntvalue(), 0);
+    object.setIntvalue(0);
+    BOOST_CHECK(isInline(object)); // lazily allocated again
+
+    object = std::move(moved);
+    BOOST_CHECK(isInline(object));
+    BOOST_CHECK_EQUAL(object, copy);
+
+    // data not fitting into the inline storage spills to the heap
+    std::vector<uint8_t> large(1024);
+    ::memcpy(large.data(), copy.toBinary().ptr.get(),
+             copy.getZerobufStaticSize());
+    BOOST_CHECK(object.fromBinary(large.data(), large.size()));
+    BOOST_CHECK(!isInline(object));
+    BOOST_CHECK_EQUAL(object.toBinary().size, large.size());
+    BOOST_CHECK_EQUAL(object.getIntvalue(), 42);
+
+    object = copy; // back to the inline storage
+    BOOST_CHECK(isInline(object));
+    BOOST_CHECK_EQUAL(object, copy);
+}
@@ -0,0 +1,169 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE sharedZerobuf
+
+#include <boost/test/unit_test.hpp>
+
+#include <testschema/testSchema.h>
+#include <zerobuf/SharedZerobuf.h>
+
+#include <thread>
+
+namespace
+{
+const size_t numReaders = 4;
+const int32_t numUpdates = 20000;
+}
+
+BOOST_AUTO_TEST_CASE(publishAndRead)
+{
+    zerobuf::SharedZerobuf<test::TestNested> shared;
+    BOOST_CHECK_EQUAL(shared.getVersion(), 1);
+    BOOST_CHECK_EQUAL(shared.get(), test::TestNested());
+
+    shared.publish(test::TestNested(1, 2));
+    BOOST_CHECK_EQUAL(shared.getVersion(), 2);
+    shared.read([](const test::TestNested& nested) {
+        BOOST_CHECK_EQUAL(nested.getIntvalue(), 1);
+        BOOST_CHECK_EQUAL(nested.getUintvalue(), 2);
+    });
+
+    zerobuf::SharedZerobuf<test::TestSchema> schema;
+    test::TestSchema object;
+    object.setIntdynamic(std::vector<int32_t>(100, 7));
+    schema.publish(object);
+    BOOST_CHECK_EQUAL(schema.get(), object);
+
+    BOOST_CHECK_THROW(shared.read([](const test::TestNested&) {
+        throw std::runtime_error("propagated");
+    }),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(stressStatic)
+{
+    zerobuf::SharedZerobuf<test::TestNested> shared;
+    std::atomic<bool> running(true);
+    std::atomic<size_t> inconsistent(0);
+    std::vector<std::thread> readers;
+
+    for (size_t i = 0; i < numReaders; ++i)
+        readers.emplace_back([&] {
+            while (running)
+            {
+                int32_t intValue = 0;
+                uint32_t uintValue = 0;
+                shared.read([&](const test::TestNested& nested) {
+                    intValue = nested.getIntvalue();
+                    uintValue = nested.getUintvalue();
+                });
+                if (uint32_t(intValue) != uintValue)
+                    ++inconsistent;
+            }
+        });
+
+    test::TestNested value;
+    for (int32_t i = 0; i < numUpdates; ++i)
+    {
+        value.setIntvalue(i);
+        value.setUintvalue(uint32_t(i));
+        shared.publish(value);
+    }
+    running = false;
+    for (auto& reader : readers)
+        reader.join();
+
+    BOOST_CHECK_EQUAL(inconsistent, 0);
+    BOOST_CHECK_EQUAL(shared.get().getIntvalue(), numUpdates - 1);
+}
+
+BOOST_AUTO_TEST_CASE(stressDynamic)
+{
+    zerobuf::SharedZerobuf<test::TestSchema> shared;
+    std::atomic<bool> running(true);
+    std::atomic<size_t> inconsistent(0);
+    std::vector<std::thread> readers;
+
+    // intvalue, the size and all values of intdynamic are always equal
+    for (size_t i = 0; i < numReaders; ++i)
+        readers.emplace_back([&] {
+            while (running)
+            {
+                std::vector<int32_t> values;
+                int32_t intValue = 0;
+                shared.read([&](const test::TestSchema& object) {
+                    intValue = object.getIntvalue();
+                    values = object.getIntdynamicVector();
+                });
+                if (values.size() != size_t(intValue))
+                    ++inconsistent;
+                for (const int32_t value : values)
+                    if (value != intValue)
+                        ++inconsistent;
+            }
+        });
+
+    test::TestSchema object;
+    for (int32_t i = 0; i < numUpdates / 10; ++i)
+    {
+        const int32_t size = i % 64;
+        object.setIntvalue(size);
+        object.setIntdynamic(std::vector<int32_t>(size_t(size), size));
+        shared.publish(object);
+    }
+    running = false;
+    for (auto& reader : readers)
+        reader.join();
+
+    BOOST_CHECK_EQUAL(inconsistent, 0);
+}
+
+BOOST_AUTO_TEST_CASE(stressDynamicSameSize)
+{
+    zerobuf::SharedZerobuf<test::TestSchema> shared;
+    std::atomic<bool> running(true);
+    std::atomic<size_t> inconsistent(0);
+    std::vector<std::thread> readers;
+
+    // the binary size stays the same, but the dynamic data changes
+    for (size_t i = 0; i < numReaders; ++i)
+        readers.emplace_back([&] {
+            while (running)
+            {
+                std::vector<int32_t> values;
+                std::string string;
+                int32_t intValue = 0;
+                shared.read([&](const test::TestSchema& object) {
+                    intValue = object.getIntvalue();
+                    values = object.getIntdynamicVector();
+                    string = object.getStringvalueString();
+                });
+                if (intValue == 0)
+                    continue; // initial value
+                if (values.size() != 16 ||
+                    string != std::string(8, char('a' + intValue % 26)))
+                {
+                    ++inconsistent;
+                }
+                for (const int32_t value : values)
+                    if (value != intValue)
+                        ++inconsistent;
+            }
+        });
+
+    test::TestSchema object;
+    for (int32_t i = 1; i < numUpdates / 10; ++i)
+    {
+        object.setIntvalue(i);
+        object.setIntdynamic(std::vector<int32_t>(16, i));
+        object.setStringvalue(std::string(8, char('a' + i % 26)));
+        shared.publish(object);
+    }
+    running = false;
+    for (auto& reader : readers)
+        reader.join();
+
+    BOOST_CHECK_EQUAL(inconsistent, 0);
+}
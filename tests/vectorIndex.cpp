@@ -0,0 +1,195 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE vectorIndex
+
+#include <boost/test/unit_test.hpp>
+#include <testschema/testSchema.h>
+
+namespace
+{
+typedef test::TestNested::KeyIndex KeyIndex;
+
+// compares the index with a linear scan for all keys and a missing one
+void checkIndex(const KeyIndex& index,
+                const zerobuf::Vector<test::TestNested>& nested)
+{
+    BOOST_CHECK_EQUAL(index.size(), nested.size());
+    for (size_t i = 0; i < nested.size(); ++i)
+    {
+        const int32_t key = nested[i].getIntvalue();
+        const size_t found = index.find(key);
+        BOOST_REQUIRE_LT(found, nested.size());
+        BOOST_CHECK_EQUAL(nested[found].getIntvalue(), key);
+    }
+    BOOST_CHECK_EQUAL(index.find(-1), nested.size());
+}
+}
+
+BOOST_AUTO_TEST_CASE(lookup)
+{
+    test::TestSchema object;
+    auto& nested = object.getNesteddynamic();
+    for (uint32_t i = 0; i < 1000; ++i)
+        nested.push_back(test::TestNested(int32_t((i * 37) % 1000), i));
+
+    const KeyIndex index(nested);
+    checkIndex(index, nested);
+    BOOST_CHECK_EQUAL(nested[index.find(37)].getUintvalue(), 1);
+    BOOST_CHECK_EQUAL(index.find(1000), nested.size());
+
+    test::TestSchema empty;
+    const KeyIndex emptyIndex(empty.getNesteddynamic());
+    BOOST_CHECK_EQUAL(emptyIndex.size(), 0);
+    BOOST_CHECK_EQUAL(emptyIndex.find(0), 0);
+}
+
+BOOST_AUTO_TEST_CASE(incrementalUpdates)
+{
+    test::TestSchema object;
+    auto& nested = object.getNesteddynamic();
+    KeyIndex index(nested);
+
+    for (uint32_t i = 0; i < 100; ++i)
+        nested.push_back(test::TestNested(int32_t(i * 3), i));
+    checkIndex(index, nested);
+
+    nested.resize(80);
+    checkIndex(index, nested);
+    BOOST_CHECK_EQUAL(index.find(90 * 3), nested.size());
+
+    nested.resize(90); // new elements are not initialized
+    for (size_t i = 80; i < 90; ++i)
+        nested[i].setIntvalue(int32_t(1000 + i));
+    index.update(85);
+    BOOST_CHECK_EQUAL(index.find(1085), 85);
+    for (size_t i = 80; i < 90; ++i)
+        index.update(i);
+    checkIndex(index, nested);
+
+    test::TestNested::insertSorted(nested, test::TestNested(4, 200));
+    checkIndex(index, nested);
+    BOOST_CHECK_EQUAL(nested[index.find(4)].getUintvalue(), 200);
+
+    test::TestNested::sortByKey(nested);
+    checkIndex(index, nested);
+
+    std::vector<int32_t> keys = test::TestNested::gatherIntvalue(nested);
+    for (int32_t& key : keys)
+        key = -key - 2;
+    test::TestNested::scatterIntvalue(nested, keys);
+    checkIndex(index, nested);
+    BOOST_CHECK_EQUAL(index.find(-2), 0);
+
+    nested.clear();
+    checkIndex(index, nested);
+}
+
+BOOST_AUTO_TEST_CASE(unobservedChanges)
+{
+    test::TestSchema object;
+    auto& nested = object.getNesteddynamic();
+    nested.push_back(test::TestNested(1, 1));
+    KeyIndex index(nested);
+
+    // the setter does not modify the indexed vector object
+    object.setNesteddynamic(
+        {test::TestNested(5, 5), test::TestNested(6, 6)});
+    BOOST_CHECK_THROW(index.find(5), std::runtime_error);
+    index.rebuild();
+    checkIndex(index, nested);
+    BOOST_CHECK_EQUAL(index.find(6), 1);
+
+    BOOST_CHECK_THROW(KeyIndex second(nested), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(replacedVector)
+{
+    test::TestSchema object;
+    auto& nested = object.getNesteddynamic();
+    for (uint32_t i = 0; i < 10; ++i)
+        nested.push_back(test::TestNested(int32_t(i), i));
+    KeyIndex index(nested);
+
+    // same size and layout, the content is replaced by the allocator
+    test::TestSchema other;
+    auto& otherNested = other.getNesteddynamic();
+    for (uint32_t i = 0; i < 10; ++i)
+        otherNested.push_back(test::TestNested(int32_t(i + 10), i));
+    object = other;
+    BOOST_CHECK_THROW(index.find(15), std::runtime_error);
+    index.update(0);
+    checkIndex(index, nested);
+    BOOST_CHECK_EQUAL(index.find(15), 5);
+
+    BOOST_CHECK(object.fromBinary(test::TestSchema().toBinary()));
+    BOOST_CHECK_THROW(index.find(15), std::runtime_error);
+    index.rebuild();
+    checkIndex(index, nested);
+
+    // move assignment rebinds the vector, which updates the index
+    object = std::move(other);
+    checkIndex(index, nested);
+    BOOST_CHECK_EQUAL(index.find(15), 5);
+}
+
+BOOST_AUTO_TEST_CASE(compositeAndBuiltinKeys)
+{
+    test::TestSchema object;
+    auto& nested = object.getNesteddynamic();
+    for (uint32_t i = 0; i < 100; ++i)
+        nested.push_back(test::TestNested(int32_t(i % 10), i / 10));
+
+    typedef zerobuf::PairKey<test::TestNested::IntvalueField,
+                             test::TestNested::UintvalueField>
+        CompositeKey;
+    const zerobuf::VectorIndex<test::TestNested, CompositeKey> index(nested);
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        const size_t found =
+            index.find(std::make_pair(int32_t(i % 10), i / 10));
+        BOOST_REQUIRE_LT(found, nested.size());
+        BOOST_CHECK_EQUAL(found, i);
+    }
+    BOOST_CHECK_EQUAL(index.find(std::make_pair(0, 10u)), nested.size());
+
+    auto& ints = object.getIntdynamic();
+    const zerobuf::VectorIndex<int32_t> intIndex(ints);
+    for (int32_t i = 0; i < 100; ++i)
+        ints.push_back(i * i);
+    BOOST_CHECK_EQUAL(intIndex.find(49), 7);
+    BOOST_CHECK_EQUAL(intIndex.find(50), ints.size());
+}
+
+BOOST_AUTO_TEST_CASE(serialization)
+{
+    test::TestSchema object;
+    auto& nested = object.getNesteddynamic();
+    for (uint32_t i = 0; i < 100; ++i)
+        nested.push_back(test::TestNested(int32_t(i * 7), i));
+
+    std::vector<uint8_t> binary;
+    {
+        const KeyIndex index(nested);
+        index.toBinary(binary);
+    }
+
+    // the receiver loads the index sent next to the object
+    test::TestSchema received(object);
+    KeyIndex index(received.getNesteddynamic(), binary.data(), binary.size());
+    checkIndex(index, received.getNesteddynamic());
+    BOOST_CHECK_EQUAL(index.find(70), 10);
+    BOOST_CHECK(index.fromBinary(binary.data(), binary.size()));
+
+    BOOST_CHECK(!index.fromBinary(binary.data(), binary.size() - 1));
+    std::vector<uint8_t> corrupt = binary;
+    corrupt[sizeof(uint64_t) * 2 + 4] ^= 0xff; // position of the first slot
+    BOOST_CHECK(!index.fromBinary(corrupt.data(), corrupt.size()));
+
+    // the index does not match the modified vector anymore
+    received.getNesteddynamic().push_back(test::TestNested(-5, 0));
+    BOOST_CHECK(!index.fromBinary(binary.data(), binary.size()));
+    checkIndex(index, received.getNesteddynamic());
+}
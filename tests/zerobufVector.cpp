@@ -49,3 +49,106 @@ BOOST_AUTO_TEST_CASE(const_iterate)
     for (const auto& nested : constObject.getNesteddynamic())
         BOOST_CHECK_EQUAL(nested.getIntvalue(), 1);
 }
+
+BOOST_AUTO_TEST_CASE(columns)
+{
+    test::TestSchema object;
+    auto& nested = object.getNesteddynamic();
+    for (int32_t i = 0; i < 37; ++i)
+        nested.push_back(test::TestNested(i, uint32_t(i * 2)));
+
+    const std::vector<int32_t>& ints = test::TestNested::gatherIntvalue(nested);
+    const std::vector<uint32_t>& uints =
+        test::TestNested::gatherUintvalue(nested);
+    BOOST_REQUIRE_EQUAL(ints.size(), 37);
+    BOOST_REQUIRE_EQUAL(uints.size(), 37);
+    for (size_t i = 0; i < 37; ++i)
+    {
+        BOOST_CHECK_EQUAL(ints[i], int32_t(i));
+        BOOST_CHECK_EQUAL(uints[i], i * 2);
+    }
+
+    std::vector<int32_t> negated(ints.size());
+    for (size_t i = 0; i < ints.size(); ++i)
+        negated[i] = -ints[i];
+    test::TestNested::scatterIntvalue(nested, negated);
+    for (size_t i = 0; i < 37; ++i)
+    {
+        BOOST_CHECK_EQUAL(nested[i].getIntvalue(), -int32_t(i));
+        BOOST_CHECK_EQUAL(nested[i].getUintvalue(), i * 2);
+    }
+
+    negated.pop_back();
+    BOOST_CHECK_THROW(test::TestNested::scatterIntvalue(nested, negated),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(columnKernels)
+{
+    // strided 8 byte fields exercise the 64 bit kernels
+    const size_t stride = 20;
+    const size_t count = 101;
+    std::vector<uint8_t> elements(stride * count, 0xff);
+    std::vector<uint64_t> column(count);
+    for (size_t i = 0; i < count; ++i)
+        column[i] = i * 0x100000001ull;
+
+    zerobuf::scatterColumn(column.data(), sizeof(uint64_t), count,
+                           elements.data() + 4, stride);
+    std::vector<uint64_t> result(count);
+    zerobuf::gatherColumn(elements.data() + 4, stride, sizeof(uint64_t), count,
+                          result.data());
+    BOOST_CHECK_EQUAL_COLLECTIONS(column.begin(), column.end(), result.begin(),
+                                  result.end());
+    BOOST_CHECK_EQUAL(elements[0], 0xff);
+    BOOST_CHECK_EQUAL(elements[12], 0xff);
+    BOOST_CHECK_EQUAL(elements[stride * count - 4], 0xff);
+}
+
+BOOST_AUTO_TEST_CASE(sortedByKey)
+{
+    test::TestSchema object;
+    auto& nested = object.getNesteddynamic();
+    BOOST_CHECK_EQUAL(test::TestNested::findByKey(nested, 0), 0);
+    test::TestNested::sortByKey(nested);
+
+    // keys 0..99 in a scrambled order, with the uint as insertion order
+    for (uint32_t i = 0; i < 100; ++i)
+        nested.push_back(test::TestNested(int32_t((i * 37) % 100), i));
+    nested.push_back(test::TestNested(42, 100)); // duplicate key
+    test::TestNested::sortByKey(nested);
+
+    for (size_t i = 1; i < nested.size(); ++i)
+        BOOST_CHECK_LE(nested[i - 1].getIntvalue(), nested[i].getIntvalue());
+    for (int32_t key = 0; key < 100; ++key)
+    {
+        const size_t index = test::TestNested::findByKey(nested, key);
+        BOOST_REQUIRE_LT(index, nested.size());
+        BOOST_CHECK_EQUAL(nested[index].getIntvalue(), key);
+    }
+
+    // equal keys keep their order, lookups return the first one
+    const size_t first = test::TestNested::findByKey(nested, 42);
+    BOOST_CHECK_EQUAL(nested[first].getUintvalue(), (42 * 73) % 100);
+    BOOST_CHECK_EQUAL(nested[first + 1].getUintvalue(), 100);
+
+    BOOST_CHECK_EQUAL(test::TestNested::findByKey(nested, -1), nested.size());
+    BOOST_CHECK_EQUAL(test::TestNested::findByKey(nested, 100), nested.size());
+
+    // insertion after all smaller or equal keys
+    BOOST_CHECK_EQUAL(test::TestNested::insertSorted(
+                          nested, test::TestNested(42, 101)),
+                      first + 2);
+    BOOST_CHECK_EQUAL(test::TestNested::insertSorted(
+                          nested, test::TestNested(-5, 102)),
+                      0);
+    BOOST_CHECK_EQUAL(test::TestNested::insertSorted(
+                          nested, test::TestNested(500, 103)),
+                      103);
+    BOOST_CHECK_EQUAL(nested.size(), 104);
+    BOOST_CHECK_EQUAL(nested[first + 3].getUintvalue(), 101);
+    BOOST_CHECK_EQUAL(nested[0].getUintvalue(), 102);
+    BOOST_CHECK_EQUAL(nested[103].getIntvalue(), 500);
+    for (size_t i = 1; i < nested.size(); ++i)
+        BOOST_CHECK_LE(nested[i - 1].getIntvalue(), nested[i].getIntvalue());
+}
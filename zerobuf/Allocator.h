@@ -30,8 +30,20 @@ public:
     {
         throw std::runtime_error("Compaction not implemented");
     }
+    virtual void setCompactionPolicy(const CompactionPolicy&)
+    {
+        throw std::runtime_error("Compaction not implemented");
+    }
+    virtual void flushCompaction() {} // run compaction deferred by the policy
     virtual bool isMovable() const { return false; } // allocation is moveable
     virtual bool isMutable() const { return true; }  // data is mutable
+    virtual bool isContiguous() const { return true; } // getData() has all
+    virtual size_t getAlignment() const { return 1; } // of dynamic elems
+    /** @return false if getData() allocates or copies the storage first. */
+    virtual bool isMaterialized() const { return true; }
+    /** @return a counter which changes when the data is replaced as a whole,
+     *          e.g., by copyBuffer(). */
+    virtual size_t getGeneration() const { return 0; }
                                                      /**
                                                       * Update allocation of the dynamic elem at index to have newSize bytes.
                                                       *
@@ -47,6 +59,12 @@ public:
         throw std::runtime_error("Dynamic allocation not implemented");
     }
 
+    /**
+     * Notify the allocator that the static section, including the dynamic
+     * headers, was overwritten outside of updateAllocation().
+     */
+    void notifyReset() { _notifyReset(); }
+
     template <class T>
     T* getItemPtr(const size_t offset)
     {
@@ -74,13 +92,13 @@ public:
     template <class T>
     T* getDynamic(const size_t index)
     {
-        return reinterpret_cast<T*>(getData() + _getOffset(index));
+        return reinterpret_cast<T*>(_getDynamicData(index));
     }
 
     template <class T>
     const T* getDynamic(const size_t index) const
     {
-        return reinterpret_cast<const T*>(getData() + _getOffset(index));
+        return reinterpret_cast<const T*>(_getDynamicData(index));
     }
 
     uint64_t getDynamicOffset(const size_t index) const
@@ -96,6 +114,19 @@ public:
     }
 
 protected:
+    virtual void _notifyReset() {}
+
+    /** @return the data of the dynamic elem, stored outside of getData() by
+     *          segmented allocators. */
+    virtual uint8_t* _getDynamicData(const size_t index)
+    {
+        return getData() + _getOffset(index);
+    }
+    virtual const uint8_t* _getDynamicData(const size_t index) const
+    {
+        return getData() + _getOffset(index);
+    }
+
     uint64_t& _getOffset(const size_t i)
     {
         _checkIndex(i);
@@ -133,6 +164,12 @@ protected:
                 " at " + std::to_string(offset) + " is within static section");
     }
 };
+
+inline void AllocatorDeleter::operator()(Allocator* allocator) const
+{
+    if (owner)
+        delete allocator;
+}
 }
 
 #endif
@@ -0,0 +1,95 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEROBUF_ARRAYVIEW_H
+#define ZEROBUF_ARRAYVIEW_H
+
+#include <zerobuf/types.h>
+
+#include <algorithm> // std::equal
+#include <stdexcept> // std::runtime_error
+#include <vector>
+
+namespace zerobuf
+{
+/**
+ * A non-owning, read-only view on a contiguous array.
+ *
+ * Returned by generated accessors for zero-copy access to dynamic members. The
+ * view is invalidated by any modification of the member it refers to.
+ *
+ * @param T element type
+ */
+template <class T>
+class ArrayView
+{
+public:
+    typedef T value_type;
+    typedef const T* const_iterator;
+    typedef const T* iterator;
+
+    /** Construct an empty view. */
+    ArrayView()
+        : _data(nullptr)
+        , _size(0)
+    {
+    }
+
+    /** Construct a view on size elements at data. */
+    ArrayView(const T* data_, const size_t size_)
+        : _data(data_)
+        , _size(size_)
+    {
+    }
+
+    /** Construct a view on the elements of a std::vector. */
+    template <class A>
+    ArrayView(const std::vector<T, A>& vector)
+        : _data(vector.data())
+        , _size(vector.size())
+    {
+    }
+
+    /** @return the pointer to the first element. */
+    const T* data() const { return _data; }
+    /** @return the number of elements in the view. */
+    size_t size() const { return _size; }
+    /** @return true if the view contains no elements. */
+    bool empty() const { return _size == 0; }
+    /** @return an iterator to the first element. */
+    const_iterator begin() const { return _data; }
+    /** @return an iterator to the past-the-end element. */
+    const_iterator end() const { return _data + _size; }
+    /** @return the element at the given index, unchecked. */
+    const T& operator[](const size_t index) const { return _data[index]; }
+    /** @return the element at the given index, bounds-checked. */
+    const T& at(const size_t index) const
+    {
+        if (index >= _size)
+            throw std::runtime_error("ArrayView out of bounds read");
+        return _data[index];
+    }
+
+    /** @return a copy of the elements. */
+    std::vector<T> toVector() const { return std::vector<T>(begin(), end()); }
+
+    /** @return true if both views have equal elements. */
+    bool operator==(const ArrayView& rhs) const
+    {
+        return _size == rhs._size && std::equal(begin(), end(), rhs.begin());
+    }
+
+    /** @return true if the views have different elements. */
+    bool operator!=(const ArrayView& rhs) const { return !(*this == rhs); }
+
+private:
+    const T* _data;
+    size_t _size;
+};
+
+/** A non-owning view on binary data. */
+typedef ArrayView<uint8_t> ByteView;
+}
+
+#endif
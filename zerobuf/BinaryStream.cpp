@@ -0,0 +1,215 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#include "BinaryStream.h"
+
+#include "Zerobuf.h"
+#include <zerobuf/version.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace zerobuf
+{
+namespace
+{
+const uint8_t _zeros[4096] = {};
+
+uint64_t& _header(std::vector<uint8_t>& data, const size_t index,
+                  const size_t field)
+{
+    return *reinterpret_cast<uint64_t*>(data.data() + 4 + index * 16 +
+                                        field * 8);
+}
+}
+
+BinaryStreamWriter::BinaryStreamWriter(const Zerobuf& zerobuf,
+                                       const size_t chunkSize)
+    : _chunkSize(chunkSize)
+    , _range(0)
+    , _offset(0)
+    , _size(0)
+{
+    if (chunkSize == 0)
+        throw std::runtime_error("Chunk size of binary stream is zero");
+
+    const size_t staticSize = zerobuf.getZerobufStaticSize();
+    if (staticSize == 0)
+        return;
+
+    const Allocator& allocator = zerobuf.getAllocator();
+    const uint8_t* data = allocator.getData();
+    _static.assign(data, data + staticSize);
+    _ranges.push_back(DynamicRange{_static.data(), staticSize});
+
+    const uint64_t alignment = allocator.getAlignment();
+    uint64_t end = staticSize;
+    for (size_t i = 0; i < zerobuf.getZerobufNumDynamics(); ++i)
+    {
+        const uint64_t size = allocator.getDynamicSize(i);
+        uint64_t offset = 0;
+        if (size > 0)
+        {
+            offset = (end + alignment - 1) & ~(alignment - 1);
+            for (uint64_t pad = offset - end; pad > 0;)
+            {
+                const size_t chunk = std::min(pad, uint64_t(sizeof(_zeros)));
+                _ranges.push_back(DynamicRange{_zeros, chunk});
+                pad -= chunk;
+            }
+            _ranges.push_back(
+                DynamicRange{allocator.getDynamic<uint8_t>(i), size_t(size)});
+            end = offset + size;
+        }
+        _header(_static, i, 0) = offset;
+        _header(_static, i, 1) = size;
+    }
+    _size = end;
+}
+
+BinaryStreamWriter::~BinaryStreamWriter()
+{
+}
+
+DynamicRange BinaryStreamWriter::next()
+{
+    while (_range < _ranges.size() && _offset == _ranges[_range].size)
+    {
+        ++_range;
+        _offset = 0;
+    }
+    if (_range == _ranges.size())
+        return DynamicRange{nullptr, 0};
+
+    const DynamicRange& range = _ranges[_range];
+    const size_t size =
+        size_t(std::min(uint64_t(_chunkSize), range.size - _offset));
+    const DynamicRange chunk{static_cast<const uint8_t*>(range.data) + _offset,
+                             size};
+    _offset += size;
+    return chunk;
+}
+
+BinaryStreamReader::BinaryStreamReader(Zerobuf& zerobuf, MemberHandler handler)
+    : _zerobuf(zerobuf)
+    , _handler(std::move(handler))
+    , _member(0)
+    , _position(0)
+    , _complete(zerobuf.getZerobufStaticSize() == 0)
+{
+    _static.reserve(zerobuf.getZerobufStaticSize());
+}
+
+BinaryStreamReader::~BinaryStreamReader()
+{
+}
+
+void BinaryStreamReader::read(const void* data, size_t size)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    const size_t staticSize = _zerobuf.getZerobufStaticSize();
+    if (_position < staticSize)
+    {
+        const size_t num = std::min(size, size_t(staticSize - _position));
+        _static.insert(_static.end(), bytes, bytes + num);
+        bytes += num;
+        size -= num;
+        _position += num;
+        if (_position < staticSize)
+            return;
+        _readStatic();
+    }
+
+    while (size > 0)
+    {
+        if (_complete)
+            throw std::runtime_error("Data after the end of zerobuf stream");
+
+        const Member& member = _members[_member];
+        if (_position < member.offset) // padding
+        {
+            const size_t num =
+                size_t(std::min(uint64_t(size), member.offset - _position));
+            bytes += num;
+            size -= num;
+            _position += num;
+            continue;
+        }
+
+        const uint64_t done = _position - member.offset;
+        const size_t num = size_t(std::min(uint64_t(size), member.size - done));
+        uint8_t* to =
+            _zerobuf.getAllocator().getDynamic<uint8_t>(member.index) + done;
+        ::memcpy(to, bytes, num);
+        bytes += num;
+        size -= num;
+        _position += num;
+
+        if (done + num == member.size)
+        {
+            ++_member;
+            if (_handler)
+                _handler(member.index);
+            _checkComplete();
+        }
+    }
+}
+
+void BinaryStreamReader::_readStatic()
+{
+    uint32_t version;
+    ::memcpy(&version, _static.data(), sizeof(version));
+    if (version != ZEROBUF_VERSION_ABI)
+        throw std::runtime_error("Version mismatch, got zerobuf v" +
+                                 std::to_string(version) + " running v" +
+                                 std::to_string(ZEROBUF_VERSION_ABI));
+
+    const size_t numDynamics = _zerobuf.getZerobufNumDynamics();
+    for (size_t i = 0; i < numDynamics; ++i)
+    {
+        const uint64_t offset = _header(_static, i, 0);
+        const uint64_t size = _header(_static, i, 1);
+        if (size == 0)
+            continue;
+        if (offset < _static.size() || offset + size < offset)
+            throw std::runtime_error("Invalid header of dynamic #" +
+                                     std::to_string(i) + " in zerobuf stream");
+        _members.push_back(Member{i, offset, size});
+    }
+    std::sort(_members.begin(), _members.end(),
+              [](const Member& lhs, const Member& rhs) {
+                  return lhs.offset < rhs.offset;
+              });
+    for (size_t i = 1; i < _members.size(); ++i)
+        if (_members[i].offset < _members[i - 1].offset + _members[i - 1].size)
+            throw std::runtime_error("Overlapping dynamic members in zerobuf "
+                                     "stream");
+
+    // static section without dynamics, which are allocated in their final size
+    for (size_t i = 0; i < numDynamics; ++i)
+        _header(_static, i, 0) = _header(_static, i, 1) = 0;
+    Allocator& allocator = _zerobuf.getAllocator();
+    allocator.copyBuffer(_static.data(), _static.size());
+    for (const Member& member : _members)
+        allocator.updateAllocation(member.index, false /*no copy*/,
+                                   member.size);
+    std::vector<uint8_t>().swap(_static);
+
+    if (_handler) // empty members are complete
+    {
+        for (size_t i = 0; i < numDynamics; ++i)
+            if (allocator.getDynamicSize(i) == 0)
+                _handler(i);
+    }
+    _checkComplete();
+}
+
+void BinaryStreamReader::_checkComplete()
+{
+    if (_member < _members.size())
+        return;
+    _complete = true;
+    _zerobuf.notifyChanged();
+}
+}
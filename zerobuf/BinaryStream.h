@@ -0,0 +1,131 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEROBUF_BINARYSTREAM_H
+#define ZEROBUF_BINARYSTREAM_H
+
+#include <zerobuf/api.h>
+#include <zerobuf/types.h>
+
+#include <functional>
+#include <vector>
+
+namespace zerobuf
+{
+/**
+ * Emits the binary of a zerobuf in chunks of bounded size.
+ *
+ * The stream consists of the static section, including the dynamic headers,
+ * followed by the dynamic members in the compact layout of the binary. The
+ * concatenated chunks are a valid binary zerobuf, readable with fromBinary()
+ * or incrementally with a BinaryStreamReader. Apart from the static section,
+ * the chunks reference the data of the zerobuf, which must not be modified
+ * while streaming. Example:
+ * @code
+ * zerobuf::BinaryStreamWriter writer( snapshot, 1 << 20 );
+ * for( zerobuf::DynamicRange chunk = writer.next(); chunk.size > 0;
+ *      chunk = writer.next( ))
+ * {
+ *     socket.send( chunk.data, chunk.size );
+ * }
+ * @endcode
+ */
+class BinaryStreamWriter
+{
+public:
+    /**
+     * @param zerobuf the object to stream
+     * @param chunkSize the maximum size of the emitted chunks
+     * @throw std::runtime_error if chunkSize is zero
+     */
+    ZEROBUF_API BinaryStreamWriter(const Zerobuf& zerobuf, size_t chunkSize);
+    ZEROBUF_API ~BinaryStreamWriter();
+
+    /** @return the next chunk of the stream, empty at its end. */
+    ZEROBUF_API DynamicRange next();
+
+    /** @return the total size of the stream in bytes. */
+    uint64_t getSize() const { return _size; }
+
+private:
+    BinaryStreamWriter(const BinaryStreamWriter&) = delete;
+    BinaryStreamWriter& operator=(const BinaryStreamWriter&) = delete;
+
+    const size_t _chunkSize;
+    std::vector<uint8_t> _static; // with the headers of the compact layout
+    std::vector<DynamicRange> _ranges;
+    size_t _range;     // current index in _ranges
+    uint64_t _offset;  // in the current range
+    uint64_t _size;
+};
+
+/**
+ * Rebuilds a zerobuf incrementally from a stream of binary chunks.
+ *
+ * Reads any valid binary zerobuf split into chunks of arbitrary size, e.g.,
+ * from a BinaryStreamWriter. Once the static section is complete, the dynamic
+ * members are allocated in the zerobuf with their final size and the data of
+ * the following chunks is written into them directly, without buffering the
+ * stream. The memory used is therefore bounded by the size of the zerobuf,
+ * which may use a SegmentedAllocator to avoid a contiguous allocation.
+ *
+ * Consumers are notified as each dynamic member completes, in the order of the
+ * stream. The zerobuf is notified with notifyChanged() once complete; Qt
+ * signals of individual members are not emitted.
+ */
+class BinaryStreamReader
+{
+public:
+    /** Called with the index of each completed dynamic member. */
+    typedef std::function<void(size_t index)> MemberHandler;
+
+    /**
+     * @param zerobuf the object receiving the stream, overwritten once the
+     *                static section has been read
+     * @param handler called for each completed dynamic member, may be empty
+     */
+    ZEROBUF_API explicit BinaryStreamReader(Zerobuf& zerobuf,
+                                            MemberHandler handler =
+                                                MemberHandler());
+    ZEROBUF_API ~BinaryStreamReader();
+
+    /**
+     * Read the next chunk of the stream.
+     *
+     * @throw std::runtime_error on a version mismatch, invalid headers or data
+     *        after the end of the stream
+     */
+    ZEROBUF_API void read(const void* data, size_t size);
+
+    /** @return true once all dynamic members have been read. */
+    bool isComplete() const { return _complete; }
+
+    /** @return the number of bytes read so far. */
+    uint64_t getPosition() const { return _position; }
+
+private:
+    BinaryStreamReader(const BinaryStreamReader&) = delete;
+    BinaryStreamReader& operator=(const BinaryStreamReader&) = delete;
+
+    struct Member
+    {
+        size_t index;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    Zerobuf& _zerobuf;
+    const MemberHandler _handler;
+    std::vector<uint8_t> _static;
+    std::vector<Member> _members; // in the order of their offset
+    size_t _member;               // the current one
+    uint64_t _position;
+    bool _complete;
+
+    void _readStatic();
+    void _checkComplete();
+};
+}
+
+#endif
@@ -5,6 +5,8 @@
 
 #include "ConstAllocator.h"
 
+#include <utility>
+
 namespace zerobuf
 {
 ConstAllocator::ConstAllocator(const uint8_t* data, size_t size)
@@ -14,6 +16,15 @@ ConstAllocator::ConstAllocator(const uint8_t* data, size_t size)
 {
 }
 
+ConstAllocator::ConstAllocator(std::shared_ptr<const void> data,
+                               const size_t size)
+    : Allocator()
+    , _data(reinterpret_cast<const uint8_t*>(data.get()))
+    , _size(size)
+    , _owner(std::move(data))
+{
+}
+
 ConstAllocator::~ConstAllocator()
 {
 }
@@ -17,6 +17,15 @@ class ConstAllocator : public Allocator
 public:
     ZEROBUF_API ConstAllocator(const uint8_t* data, size_t size);
 
+    /**
+     * Construct a read-only allocator sharing the ownership of the given data.
+     *
+     * The data is released with the last owner, e.g., after the zerobuf using
+     * this allocator is destroyed. A custom release callback is given as the
+     * deleter of the shared pointer.
+     */
+    ZEROBUF_API ConstAllocator(std::shared_ptr<const void> data, size_t size);
+
     ZEROBUF_API ~ConstAllocator();
 
     const uint8_t* getData() const final { return _data; }
@@ -45,6 +54,7 @@ private:
 
     const uint8_t* _data;
     const size_t _size;
+    const std::shared_ptr<const void> _owner; // may be empty
 };
 }
 
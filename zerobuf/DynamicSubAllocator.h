@@ -28,6 +28,7 @@ public:
     size_t getSize() const final { return _size; }
     ZEROBUF_API void copyBuffer(const void* data, size_t size) final;
     bool isMutable() const final { return _parent.isMutable(); }
+    bool isMaterialized() const final { return _parent.isMaterialized(); }
 private:
     A& _parent;
     const size_t _header;
@@ -0,0 +1,224 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#include "LazyAllocator.h"
+
+#include "NonMovingAllocator.h"
+#include <zerobuf/version.h>
+
+#include <cstring>
+
+namespace zerobuf
+{
+LazyAllocator::~LazyAllocator()
+{
+    delete _storage;
+}
+
+uint8_t* LazyAllocator::getData()
+{
+    if (_storage)
+        return _storage->getData();
+    if (!_inlineData)
+        return getStorage().getData();
+
+    if (_size == 0) // allocate an empty zerobuf inline
+    {
+        ::memset(_inlineData, 0, _staticSize);
+        if (_staticSize >= sizeof(uint32_t))
+        {
+            const uint32_t version = ZEROBUF_VERSION_ABI;
+            ::memcpy(_inlineData, &version, sizeof(version));
+        }
+        _size = _staticSize;
+    }
+    return _inlineData;
+}
+
+const uint8_t* LazyAllocator::getData() const
+{
+    const NonMovingAllocator* storage = _storage;
+    if (storage)
+        return storage->getData();
+    if (_size > 0)
+        return _inlineData;
+    return NonMovingBaseAllocator::_getEmptyImage(_staticSize, _alignment,
+                                                  true);
+}
+
+size_t LazyAllocator::getSize() const
+{
+    if (_storage)
+        return _storage->getSize();
+    return _size > 0 ? _size : _staticSize;
+}
+
+void LazyAllocator::copyBuffer(const void* data, const size_t size)
+{
+    if (!_inlineData || size > _inlineSize)
+    {
+        getStorage().copyBuffer(data, size);
+        return;
+    }
+
+    // back to the inline storage
+    ::memmove(_inlineData, data, size);
+    _size = uint32_t(size);
+    if (_storage)
+        _freeStorage();
+    ++_generation;
+}
+
+void LazyAllocator::compact(const float threshold)
+{
+    if (_storage)
+        _storage->compact(threshold);
+}
+
+void LazyAllocator::setCompactionPolicy(const CompactionPolicy& policy)
+{
+    getStorage().setCompactionPolicy(policy);
+}
+
+void LazyAllocator::flushCompaction()
+{
+    if (_storage)
+        _storage->flushCompaction();
+}
+
+bool LazyAllocator::isMaterialized() const
+{
+    return _storage ? _storage->isMaterialized() : _size > 0;
+}
+
+size_t LazyAllocator::getGeneration() const
+{
+    return _generation + (_storage ? _storage->getGeneration() : 0);
+}
+
+uint8_t* LazyAllocator::updateAllocation(const size_t index, const bool copy,
+                                         const size_t size)
+{
+    return getStorage().updateAllocation(index, copy, size);
+}
+
+NonMovingAllocator& LazyAllocator::getStorage()
+{
+    if (!_storage)
+    {
+        std::unique_ptr<NonMovingAllocator> storage(new NonMovingAllocator);
+        storage->reset(_staticSize, _numDynamic, _alignment);
+        if (_size > 0) // spill the inline data
+            storage->copyBuffer(_inlineData, _size);
+        _size = 0;
+        _setStorage(storage.release());
+    }
+    return *_storage;
+}
+
+void LazyAllocator::reset(const size_t staticSize, const size_t numDynamic,
+                          const size_t alignment)
+{
+    _staticSize = uint32_t(staticSize);
+    _numDynamic = uint32_t(numDynamic);
+    _alignment = uint32_t(alignment);
+    _size = 0;
+    ++_generation;
+    if (!_storage)
+        return;
+
+    if (_inlineData)
+        _freeStorage();
+    else // keep the storage object for the next modification
+        _storage->reset(staticSize, numDynamic, alignment);
+}
+
+void LazyAllocator::reset(const uint8_t* image, const size_t staticSize,
+                          const size_t numDynamic, const size_t alignment)
+{
+    reset(staticSize, numDynamic, alignment);
+    if (_inlineData && staticSize <= _inlineSize)
+    {
+        ::memcpy(_inlineData, image, staticSize);
+        _size = uint32_t(staticSize);
+    }
+    else
+        getStorage().reset(image, staticSize, numDynamic, alignment);
+}
+
+void LazyAllocator::reset(const uint8_t* image, const DynamicRange* dynamics,
+                          const size_t staticSize, const size_t numDynamic,
+                          const size_t alignment)
+{
+    reset(staticSize, numDynamic, alignment);
+    getStorage().reset(image, dynamics, staticSize, numDynamic, alignment);
+}
+
+void LazyAllocator::moveFrom(LazyAllocator& rhs)
+{
+    if (this == &rhs)
+        return;
+
+    reset(rhs._staticSize, rhs._numDynamic, rhs._alignment);
+    if (rhs._storage)
+    {
+        if (_storage) // reuse the storage object, rhs keeps its lazy one
+            _storage->moveFrom(*rhs._storage);
+        else // hand over, rhs creates a new storage when modified
+        {
+            _setStorage(rhs._storage);
+            rhs._setStorage(nullptr);
+        }
+    }
+    else if (rhs._size > 0) // inline data can't be taken over, copy
+    {
+        copyBuffer(rhs._inlineData, rhs._size);
+        rhs._size = 0;
+        ++rhs._generation;
+    }
+}
+
+std::shared_ptr<const void> LazyAllocator::share() const
+{
+    if (_storage)
+        return _storage->share();
+
+    if (_size == 0) // the empty image is never freed
+        return std::shared_ptr<const void>(getData(), [](const void*) {});
+
+    // the inline data is owned by the zerobuf object, share a copy
+    uint8_t* const buffer = new uint8_t[_size + _alignment];
+    uint8_t* const data =
+        buffer + (_alignment - reinterpret_cast<uintptr_t>(buffer) %
+                                   _alignment) %
+                     _alignment;
+    ::memcpy(data, _inlineData, _size);
+    return std::shared_ptr<const void>(data, [buffer](const void*) {
+        delete[] buffer;
+    });
+}
+
+void LazyAllocator::_notifyReset()
+{
+    if (_storage)
+        _storage->notifyReset();
+    else
+        ++_generation;
+}
+
+void LazyAllocator::_setStorage(NonMovingAllocator* storage)
+{
+    // the generation keeps increasing when the storage is replaced
+    const size_t generation = getGeneration() + 1;
+    _storage = storage;
+    _generation = generation - (storage ? storage->getGeneration() : 0);
+}
+
+void LazyAllocator::_freeStorage()
+{
+    NonMovingAllocator* storage = _storage;
+    _setStorage(nullptr);
+    delete storage;
+}
+}
@@ -0,0 +1,141 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEROBUF_LAZYALLOCATOR_H
+#define ZEROBUF_LAZYALLOCATOR_H
+
+#include <zerobuf/Allocator.h> // base class
+#include <zerobuf/api.h>
+
+#include <cstddef> // std::max_align_t
+#include <memory>  // std::shared_ptr
+
+namespace zerobuf
+{
+/**
+ * The own storage of a zerobuf, a NonMovingAllocator kept out of line.
+ *
+ * Moves hand over the pointer to the storage. The moved-from allocator
+ * creates a new storage on its next modifying access and reads an empty
+ * image until then. Generated classes bind the sub-allocators of their
+ * members to this allocator, whose address does not change.
+ *
+ * An allocator with inline storage keeps the data in the given buffer while
+ * it fits, without creating a NonMovingAllocator, and spills to one
+ * otherwise.
+ */
+class LazyAllocator : public Allocator
+{
+public:
+    /** Construct a lazy allocator without storage and static section. */
+    LazyAllocator()
+        : LazyAllocator(nullptr, 0)
+    {
+    }
+
+    /**
+     * Construct a lazy allocator with inline storage.
+     *
+     * @param inlineData the buffer, aligned to the alignment of all layouts
+     *                   used with this allocator, has to outlive it
+     * @param inlineSize the size of the buffer
+     */
+    LazyAllocator(uint8_t* inlineData, const size_t inlineSize)
+        : _storage(nullptr)
+        , _inlineData(inlineData)
+        , _generation(0)
+        , _staticSize(0)
+        , _numDynamic(0)
+        , _alignment(1)
+        , _inlineSize(uint32_t(inlineSize))
+        , _size(0)
+    {
+    }
+
+    ZEROBUF_API ~LazyAllocator();
+
+    ZEROBUF_API uint8_t* getData() final;
+    ZEROBUF_API const uint8_t* getData() const final;
+    ZEROBUF_API size_t getSize() const final;
+    ZEROBUF_API void copyBuffer(const void* data, size_t size) final;
+    ZEROBUF_API void compact(float threshold) final;
+    ZEROBUF_API void setCompactionPolicy(const CompactionPolicy& policy) final;
+    ZEROBUF_API void flushCompaction() final;
+    bool isMovable() const final { return true; }
+    size_t getAlignment() const final { return _alignment; }
+    ZEROBUF_API bool isMaterialized() const final;
+    ZEROBUF_API size_t getGeneration() const final;
+    ZEROBUF_API uint8_t* updateAllocation(size_t index, bool copy,
+                                          size_t size) final;
+
+    /** @return the storage, created from the inline data if needed. */
+    ZEROBUF_API NonMovingAllocator& getStorage();
+
+    /** Free the data and become lazy with the given layout. */
+    ZEROBUF_API void reset(size_t staticSize, size_t numDynamic,
+                           size_t alignment = 1);
+
+    /** @sa NonMovingAllocator::reset() */
+    ZEROBUF_API void reset(const uint8_t* image, size_t staticSize,
+                           size_t numDynamic, size_t alignment = 1);
+
+    /** @sa NonMovingAllocator::reset() */
+    ZEROBUF_API void reset(const uint8_t* image, const DynamicRange* dynamics,
+                           size_t staticSize, size_t numDynamic,
+                           size_t alignment = 1);
+
+    /**
+     * Take over the data of rhs, which becomes lazy. The storage of rhs is
+     * handed over if this allocator has none, inline data is copied.
+     */
+    ZEROBUF_API void moveFrom(LazyAllocator& rhs);
+
+    /**
+     * @return the owner of the data for read-only snapshots.
+     * @sa NonMovingAllocator::share(), inline data is shared as a copy.
+     */
+    ZEROBUF_API std::shared_ptr<const void> share() const;
+
+private:
+    LazyAllocator(const LazyAllocator&) = delete;
+    LazyAllocator& operator=(const LazyAllocator&) = delete;
+
+    NonMovingAllocator* _storage; // nullptr while lazy or inline
+    uint8_t* const _inlineData;   // not owned, nullptr if none
+    size_t _generation;           // added to the one of _storage
+
+    // compact, as each zerobuf embeds its allocator
+    uint32_t _staticSize;
+    uint32_t _numDynamic;
+    uint32_t _alignment;
+    const uint32_t _inlineSize;
+    uint32_t _size; // of the inline data, 0 if not used
+
+    void _notifyReset() final;
+    void _setStorage(NonMovingAllocator* storage);
+    void _freeStorage();
+};
+
+/**
+ * Inline storage for the LazyAllocator of a small zerobuf.
+ *
+ * Used as a private base class of generated zerobufs, so that the storage is
+ * constructed before the zerobuf base class.
+ *
+ * @param Size the size of the storage in bytes
+ * @param Alignment the alignment of the storage
+ */
+template <size_t Size, size_t Alignment = alignof(std::max_align_t)>
+class InlineStorage
+{
+protected:
+    InlineStorage() {}
+    InlineStorage(const InlineStorage&) {} // storage belongs to the allocator
+    InlineStorage& operator=(const InlineStorage&) { return *this; }
+
+    alignas(Alignment) uint8_t _inlineData[Size];
+};
+}
+
+#endif
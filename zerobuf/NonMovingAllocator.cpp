@@ -5,35 +5,261 @@
  */
 
 #include "NonMovingAllocator.h"
+
+#include "ConstAllocator.h"
 #include <zerobuf/version.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstring>
+#include <new>
 #include <stdlib.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 
 namespace zerobuf
 {
+namespace
+{
+uint8_t* _allocAligned(const size_t alignment, const size_t size)
+{
+#ifdef _WIN32
+    void* ptr = ::_aligned_malloc(size ? size : 1, alignment);
+#else
+    void* ptr = nullptr;
+    if (::posix_memalign(&ptr, alignment, size ? size : 1) != 0)
+        ptr = nullptr;
+#endif
+    if (!ptr)
+        throw std::bad_alloc();
+    return (uint8_t*)ptr;
+}
+
+void _freeAligned(uint8_t* ptr)
+{
+#ifdef _WIN32
+    ::_aligned_free(ptr);
+#else
+    ::free(ptr);
+#endif
+}
+
+// releases shared data unless the allocator took back its ownership
+struct SharedDeleter
+{
+    BufferDeleter deleter; // of an adopted buffer
+    bool overaligned;
+    bool owner;
+
+    void operator()(const void* data)
+    {
+        uint8_t* ptr = static_cast<uint8_t*>(const_cast<void*>(data));
+        if (!owner)
+            return;
+        if (deleter)
+            deleter(ptr);
+        else if (overaligned)
+            _freeAligned(ptr);
+        else
+            ::free(ptr);
+    }
+};
+}
+
 NonMovingAllocator::NonMovingAllocator(const size_t staticSize,
-                                       const size_t numDynamic)
-    : NonMovingBaseAllocator(staticSize, numDynamic)
-    , _data((uint8_t*)::calloc(1, staticSize))
+                                       const size_t numDynamic,
+                                       const size_t alignment)
+    : NonMovingBaseAllocator(staticSize, numDynamic, alignment)
+    , _data(nullptr)
     , _size(staticSize)
+    , _overaligned(alignment > alignof(std::max_align_t))
 {
+    if (_overaligned)
+    {
+        _data = _allocate(staticSize);
+        ::memset(_data, 0, staticSize);
+    }
+    else
+        _data = (uint8_t*)::calloc(1, staticSize);
+}
+
+NonMovingAllocator::NonMovingAllocator(const uint8_t* image,
+                                       const size_t staticSize,
+                                       const size_t numDynamic,
+                                       const size_t alignment)
+    : NonMovingBaseAllocator(staticSize, numDynamic, alignment)
+    , _data(nullptr)
+    , _size(staticSize)
+    , _overaligned(alignment > alignof(std::max_align_t))
+{
+    _data = _allocate(staticSize);
+    ::memcpy(_data, image, staticSize);
+}
+
+NonMovingAllocator::NonMovingAllocator(uint8_t* data, const size_t size,
+                                       BufferDeleter deleter,
+                                       const size_t staticSize,
+                                       const size_t numDynamic,
+                                       const size_t alignment)
+    : NonMovingAllocator()
+{
+    _setLayout(staticSize, numDynamic, alignment);
+    _overaligned = alignment > alignof(std::max_align_t);
+    _size = staticSize;
+    adopt(data, size, std::move(deleter));
 }
 
 NonMovingAllocator::~NonMovingAllocator()
 {
-    ::free(_data);
+    if (_data)
+        _free();
+}
+
+void NonMovingAllocator::reset(const size_t staticSize,
+                               const size_t numDynamic, const size_t alignment)
+{
+    _free();
+    _setLayout(staticSize, numDynamic, alignment);
+    _nextGeneration();
+    _size = staticSize;
+    _overaligned = alignment > alignof(std::max_align_t);
+}
+
+void NonMovingAllocator::reset(const uint8_t* image, const size_t staticSize,
+                               const size_t numDynamic, const size_t alignment)
+{
+    reset(staticSize, numDynamic, alignment);
+    _data = _allocate(staticSize);
+    ::memcpy(_data, image, staticSize);
+}
+
+void NonMovingAllocator::reset(const uint8_t* image,
+                               const DynamicRange* dynamics,
+                               const size_t staticSize,
+                               const size_t numDynamic, const size_t alignment)
+{
+    reset(staticSize, numDynamic, alignment);
+
+    uint64_t size = staticSize;
+    for (size_t i = 0; i < numDynamic; ++i)
+        if (dynamics[i].size > 0)
+            size = _align(size) + dynamics[i].size;
+
+    _data = _allocate(size);
+    _size = size;
+    ::memcpy(_data, image, staticSize);
+
+    uint64_t end = staticSize;
+    for (size_t i = 0; i < numDynamic; ++i)
+    {
+        const DynamicRange& dynamic = dynamics[i];
+        uint64_t header[2] = {0, 0}; // offset, size
+        if (dynamic.size > 0)
+        {
+            const uint64_t offset = _align(end);
+            ::memset(_data + end, 0, offset - end);
+            if (dynamic.data)
+                ::memcpy(_data + offset, dynamic.data, dynamic.size);
+            else
+                ::memset(_data + offset, 0, dynamic.size);
+            header[0] = offset;
+            header[1] = dynamic.size;
+            end = offset + dynamic.size;
+        }
+        ::memcpy(_data + 4 + i * 16, header, sizeof(header));
+    }
+}
+
+void NonMovingAllocator::adopt(uint8_t* data, const size_t size,
+                               BufferDeleter deleter)
+{
+    if (size < _getStaticSize())
+        throw std::runtime_error("Adopted zerobuf buffer is too small");
+    if (reinterpret_cast<uintptr_t>(data) % getAlignment() != 0)
+        throw std::runtime_error("Adopted zerobuf buffer is not aligned");
+    ConstAllocator(data, size).check(_getNumDynamic());
+
+    // own storage of overaligned allocators is not released with free()
+    if (!deleter && _overaligned)
+        deleter = [](uint8_t* ptr) { ::free(ptr); };
+
+    _free();
+    _data = data;
+    _size = size;
+    _deleter = std::move(deleter);
+    _invalidateUsage();
+    _nextGeneration();
+}
+
+void NonMovingAllocator::moveFrom(NonMovingAllocator& rhs)
+{
+    if (this == &rhs)
+        return;
+
+    reset(rhs._getStaticSize(), rhs._getNumDynamic(), rhs.getAlignment());
+    if (_getCompactionPolicy().highWatermark <= 0.f) // e.g., move ctor
+        setCompactionPolicy(rhs._getCompactionPolicy());
+    rhs._invalidateUsage();
+    rhs._nextGeneration();
+    std::swap(_data, rhs._data);
+    std::swap(_size, rhs._size);
+    std::swap(_deleter, rhs._deleter);
+    std::swap(_shared, rhs._shared);
+}
+
+std::shared_ptr<const void> NonMovingAllocator::share() const
+{
+    if (!_data) // the empty image is never freed
+        return std::shared_ptr<const void>(_getEmptyImage(_size, true),
+                                           [](const void*) {});
+
+    // concurrent const callers race to install the owner, the loser disowns
+    // its candidate; the allocator keeps its deleter until it unshares
+    std::shared_ptr<const void> shared = std::atomic_load(&_shared);
+    if (shared)
+        return shared;
+
+    std::shared_ptr<const void> candidate(
+        _data, SharedDeleter{_deleter, _overaligned, true});
+    if (std::atomic_compare_exchange_strong(&_shared, &shared, candidate))
+        return candidate;
+
+    std::get_deleter<SharedDeleter>(candidate)->owner = false;
+    return shared;
 }
 
 void NonMovingAllocator::copyBuffer(const void* data, size_t size)
 {
-    _resize(size);
+    if (_shared) // no need to copy the shared data
+        _free();
+    if (_data)
+        _resize(size);
+    else // no need to initialize the lazy storage
+    {
+        _data = _allocate(size);
+        _size = size;
+    }
     ::memcpy(_data, data, size);
+    _invalidateUsage();
+    _nextGeneration();
 }
 
 void NonMovingAllocator::_resize(const size_t size)
 {
-    _data = (uint8_t*)::realloc(_data, size);
+    if (!_data)
+        _materialize();
+    if (_overaligned || _deleter || _shared)
+    {
+        // no (aligned) realloc or shared data, copy to new memory
+        uint8_t* data = _allocate(size);
+        ::memcpy(data, _data, std::min(size, _size));
+        _free();
+        _data = data;
+    }
+    else
+        _data = (uint8_t*)::realloc(_data, size);
     if (size > _size)
     {
 // realloc does not guarantee that additional memory is zero-filled
@@ -45,4 +271,65 @@ void NonMovingAllocator::_resize(const size_t size)
     }
     _size = size;
 }
+
+uint8_t* NonMovingAllocator::_allocate(const size_t size) const
+{
+    if (_overaligned)
+        return _allocAligned(getAlignment(), size);
+
+    uint8_t* data = (uint8_t*)::malloc(size ? size : 1);
+    if (!data)
+        throw std::bad_alloc();
+    return data;
+}
+
+void NonMovingAllocator::_free()
+{
+    if (_shared) // released by the last snapshot
+    {
+        _shared.reset();
+        _deleter = BufferDeleter();
+    }
+    else if (_deleter)
+    {
+        if (_data)
+            _deleter(_data);
+        _deleter = BufferDeleter();
+    }
+    else if (_overaligned)
+        _freeAligned(_data);
+    else
+        ::free(_data);
+    _data = nullptr;
+}
+
+void NonMovingAllocator::_unshare()
+{
+    if (_shared.use_count() > 1) // snapshots are alive, modify a copy
+    {
+        uint8_t* data = _allocate(_size);
+        ::memcpy(data, _data, _size);
+        _shared.reset();
+        _deleter = BufferDeleter();
+        _data = data;
+        return;
+    }
+
+    // all snapshots are gone, take back the ownership of the data
+    std::atomic_thread_fence(std::memory_order_acquire);
+    std::get_deleter<SharedDeleter>(_shared)->owner = false;
+    _shared.reset();
+}
+
+uint8_t* NonMovingAllocator::_materialize()
+{
+    _data = _allocate(_size);
+    ::memset(_data, 0, _size);
+    if (_size >= sizeof(uint32_t))
+    {
+        const uint32_t version = ZEROBUF_VERSION_ABI;
+        ::memcpy(_data, &version, sizeof(version));
+    }
+    return _data;
+}
 }
@@ -10,28 +10,130 @@
 #include <zerobuf/NonMovingBaseAllocator.h> // base class
 #include <zerobuf/api.h>
 
+#include <memory> // std::shared_ptr
+
 namespace zerobuf
 {
-/** A zerobuf root allocator which does not move existing fields */
+/**
+ * A zerobuf root allocator which does not move existing fields.
+ *
+ * The storage of a lazy allocator is allocated on first modifying access, as
+ * an empty zerobuf of the static size. Const access reads a shared empty image
+ * without allocating.
+ */
 class NonMovingAllocator : public NonMovingBaseAllocator
 {
 public:
-    ZEROBUF_API NonMovingAllocator(size_t staticSize, size_t numDynamic);
+    ZEROBUF_API NonMovingAllocator(size_t staticSize, size_t numDynamic,
+                                   size_t alignment = 1);
+
+    /** Construct with the static section initialized from the given image. */
+    ZEROBUF_API NonMovingAllocator(const uint8_t* image, size_t staticSize,
+                                   size_t numDynamic, size_t alignment = 1);
+
+    /**
+     * Construct an allocator taking over the given buffer without copying it.
+     *
+     * @param data the zerobuf binary, aligned to the given alignment
+     * @param size the size of the binary
+     * @param deleter releases data, ::free() is used if empty
+     * @throw std::runtime_error if the buffer is invalid, in which case the
+     *        caller keeps its ownership
+     */
+    ZEROBUF_API NonMovingAllocator(uint8_t* data, size_t size,
+                                   BufferDeleter deleter, size_t staticSize,
+                                   size_t numDynamic, size_t alignment = 1);
+
+    /** Construct a lazy allocator without storage and static section. */
+    NonMovingAllocator()
+        : _data(nullptr)
+        , _size(0)
+        , _overaligned(false)
+    {
+    }
     ZEROBUF_API ~NonMovingAllocator();
 
-    uint8_t* getData() final { return _data; }
-    const uint8_t* getData() const final { return _data; }
+    uint8_t* getData() final
+    {
+        if (_shared)
+            _unshare();
+        return _data ? _data : _materialize();
+    }
+    const uint8_t* getData() const final
+    {
+        return _data ? _data : _getEmptyImage(_size, true);
+    }
     size_t getSize() const final { return _size; }
     ZEROBUF_API void copyBuffer(const void* data, size_t size) final;
     bool isMovable() const final { return true; }
+    bool isMaterialized() const final { return _data && !_shared; }
+
+    /** Free the storage and become a lazy allocator of the given layout. */
+    ZEROBUF_API void reset(size_t staticSize, size_t numDynamic,
+                           size_t alignment = 1);
+
+    /** Reset with the static section initialized from the given image. */
+    ZEROBUF_API void reset(const uint8_t* image, size_t staticSize,
+                           size_t numDynamic, size_t alignment = 1);
+
+    /**
+     * Reset to a compact allocation of the static image followed by the given
+     * dynamic ranges, which are copied in one pass without reallocation.
+     *
+     * @param image the static section, without the dynamic headers
+     * @param dynamics the data of each dynamic member
+     */
+    ZEROBUF_API void reset(const uint8_t* image, const DynamicRange* dynamics,
+                           size_t staticSize, size_t numDynamic,
+                           size_t alignment = 1);
+
+    /**
+     * Replace the storage with the given buffer without copying it.
+     *
+     * The dynamic headers of the buffer are validated before it is adopted.
+     *
+     * @param data the zerobuf binary, aligned to the allocator alignment
+     * @param size the size of the binary
+     * @param deleter releases data, ::free() is used if empty
+     * @throw std::runtime_error if the buffer is invalid, in which case the
+     *        caller keeps its ownership
+     */
+    ZEROBUF_API void adopt(uint8_t* data, size_t size, BufferDeleter deleter);
+
+    /**
+     * Take over the storage of rhs without copying it. rhs becomes a lazy
+     * allocator of the same layout.
+     */
+    ZEROBUF_API void moveFrom(NonMovingAllocator& rhs);
+
+    /**
+     * Share the storage with read-only snapshots.
+     *
+     * The returned pointer owns the current data. While any snapshot owns it,
+     * the next modifying access copies the data first; otherwise the
+     * allocator takes the ownership back without copying. Concurrent calls
+     * are thread-safe, unlike concurrent modifications.
+     *
+     * @return the owner of the data, of getSize() bytes.
+     */
+    ZEROBUF_API std::shared_ptr<const void> share() const;
+
 private:
     NonMovingAllocator(const NonMovingAllocator&) = delete;
     NonMovingAllocator& operator=(const NonMovingAllocator&) = delete;
 
-    uint8_t* _data;
+    uint8_t* _data; // nullptr if not yet allocated
     size_t _size;
+    bool _overaligned; // alignment exceeds the one of malloc
+    BufferDeleter _deleter; // of an adopted buffer, empty for own storage
+    // owns _data while shared, only accessed atomically by share()
+    mutable std::shared_ptr<const void> _shared;
 
     void _resize(size_t newSize) final;
+    uint8_t* _allocate(size_t size) const;
+    void _free();
+    ZEROBUF_API uint8_t* _materialize();
+    ZEROBUF_API void _unshare();
 };
 }
 #endif
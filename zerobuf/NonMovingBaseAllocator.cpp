@@ -4,25 +4,42 @@
  */
 
 #include "NonMovingBaseAllocator.h"
+#include <zerobuf/version.h>
 
 #include <algorithm>
 #include <cassert>
-#include <map>
+#include <mutex>
 #include <string.h>
 
 namespace zerobuf
 {
 NonMovingBaseAllocator::NonMovingBaseAllocator(const size_t staticSize,
-                                               const size_t numDynamic)
-    : _staticSize(staticSize)
-    , _numDynamic(numDynamic)
+                                               const size_t numDynamic,
+                                               const size_t alignment)
+    : _generation(0)
+    , _used(0)
+    , _usageValid(false)
+    , _compacting(false)
 {
+    _setLayout(staticSize, numDynamic, alignment);
 }
 
 NonMovingBaseAllocator::~NonMovingBaseAllocator()
 {
 }
 
+void NonMovingBaseAllocator::_setLayout(const size_t staticSize,
+                                        const size_t numDynamic,
+                                        const size_t alignment)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+        throw std::runtime_error("Allocator alignment must be a power of two");
+    _staticSize = staticSize;
+    _numDynamic = numDynamic;
+    _alignment = alignment;
+    _invalidateUsage();
+}
+
 uint8_t* NonMovingBaseAllocator::_moveAllocation(const size_t index,
                                                  const bool copy,
                                                  const size_t newOffset,
@@ -44,6 +61,32 @@ uint8_t* NonMovingBaseAllocator::_moveAllocation(const size_t index,
 uint8_t* NonMovingBaseAllocator::updateAllocation(const size_t index,
                                                   const bool copy,
                                                   const size_t newSize)
+{
+    if (_policy.highWatermark <= 0.f)
+        return _updateAllocation(index, copy, newSize);
+
+    _updateUsage();
+    const uint64_t oldSize = _getSize(index);
+    _used = _used + _align(newSize) - _align(oldSize);
+    if (_policy.deferred)
+        return _updateAllocation(index, copy, newSize);
+
+    // compact before growing, keeping the returned pointer valid
+    if (newSize > oldSize)
+    {
+        _compactAutomatically();
+        return _updateAllocation(index, copy, newSize);
+    }
+
+    // compact after shrinking to reclaim the space released by it
+    _updateAllocation(index, copy, newSize);
+    _compactAutomatically();
+    return newSize > 0 ? getData() + _getOffset(index) : nullptr;
+}
+
+uint8_t* NonMovingBaseAllocator::_updateAllocation(const size_t index,
+                                                   const bool copy,
+                                                   const size_t newSize)
 {
     uint64_t& oldOffset = _getOffset(index);
     uint64_t& oldSize = _getSize(index);
@@ -76,30 +119,36 @@ uint8_t* NonMovingBaseAllocator::updateAllocation(const size_t index,
         }
     }
 
-    // Check for a big enough hole
-    //-- record allocations
-    typedef std::map<size_t, size_t> ArrayMap; // offset -> size
-    ArrayMap arrays;                           // sort arrays by position
-    for (size_t i = 0; i < _numDynamic; ++i)
+    // Check for a big enough hole, visiting the other allocations in the
+    // order of their offset; does not allocate for the sorting
+    uint64_t start = _align(_staticSize);
+    uint64_t previous = 0;
+    while (true)
     {
-        const uint64_t offset = _getOffset(i);
-        if (i != index && offset >= _staticSize)
-            arrays[offset] = _getSize(i);
-    }
+        size_t next = _numDynamic;
+        for (size_t i = 0; i < _numDynamic; ++i)
+        {
+            const uint64_t offset = _getOffset(i);
+            if (i != index && offset >= _staticSize && offset > previous &&
+                (next == _numDynamic || offset < _getOffset(next)))
+            {
+                next = i;
+            }
+        }
+        if (next == _numDynamic)
+            break;
 
-    //-- find hole
-    uint64_t start = _staticSize;
-    for (auto i = arrays.cbegin(); i != arrays.cend(); ++i)
-    {
-        assert(i->first >= start);
-        if (i->first - start >= newSize)
+        const uint64_t offset = _getOffset(next);
+        assert(offset >= start);
+        if (offset - start >= newSize)
             return _moveAllocation(index, copy, start, newSize);
 
-        start = i->first + i->second;
+        start = _align(offset + _getSize(next));
+        previous = offset;
     }
 
     //-- check for space after last allocation
-    if (getSize() - start >= newSize)
+    if (start <= getSize() && getSize() - start >= newSize)
         return _moveAllocation(index, copy, start, newSize);
 
     // realloc space at the end
@@ -115,12 +164,13 @@ uint8_t* NonMovingBaseAllocator::updateAllocation(const size_t index,
 
 void NonMovingBaseAllocator::compact(const float threshold)
 {
+    const uint64_t dynamicStart = _align(_staticSize);
     uint64_t dynamicSize = 0;
     for (size_t i = 0; i < _numDynamic; ++i)
         if (_getOffset(i) > 0)
-            dynamicSize += _getSize(i);
+            dynamicSize = _align(dynamicSize) + _getSize(i);
 
-    const uint64_t minSize = _staticSize + dynamicSize;
+    const uint64_t minSize = dynamicStart + dynamicSize;
     if (float(getSize() - minSize) / float(minSize) < threshold)
         return;
 
@@ -135,13 +185,136 @@ void NonMovingBaseAllocator::compact(const float threshold)
             continue;
 
         const uint64_t size = _getSize(i);
-        const uint64_t newOffset = iter - buffer.get() + _staticSize;
+        uint8_t* const aligned = buffer.get() + _align(iter - buffer.get());
+        ::memset(iter, 0, aligned - iter);
+        iter = aligned;
+        const uint64_t newOffset = iter - buffer.get() + dynamicStart;
         ::memcpy(iter, getData() + offset, size);
         iter += size;
         offset = newOffset;
     }
 
     _resize(minSize);
-    ::memcpy(getData() + _staticSize, buffer.get(), dynamicSize);
+    ::memcpy(getData() + dynamicStart, buffer.get(), dynamicSize);
+}
+
+const uint8_t* NonMovingBaseAllocator::_getEmptyImage(const size_t size,
+                                                      const size_t alignment,
+                                                      const bool versioned)
+{
+    struct Image
+    {
+        uint8_t* data;
+        size_t size;
+        size_t alignment;
+    };
+    static std::mutex mutex;
+    static Image images[2] = {{nullptr, 0, 1}, {nullptr, 0, 1}};
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Image& image = images[versioned ? 1 : 0];
+    if (image.data && image.size >= size && image.alignment >= alignment)
+        return image.data;
+
+    // grow by replacing the image, previous ones stay valid for their readers
+    const size_t newSize = std::max(std::max(size, image.size * 2), size_t(64));
+    const size_t newAlignment = std::max(image.alignment, alignment);
+    uint8_t* data = new uint8_t[newSize + newAlignment];
+    data += (newAlignment - reinterpret_cast<uintptr_t>(data) % newAlignment) %
+            newAlignment;
+    ::memset(data, 0, newSize);
+    if (versioned)
+    {
+        const uint32_t version = ZEROBUF_VERSION_ABI;
+        ::memcpy(data, &version, sizeof(version));
+    }
+    image = Image{data, newSize, newAlignment};
+    return data;
+}
+
+void NonMovingBaseAllocator::setCompactionPolicy(const CompactionPolicy& policy)
+{
+    _policy = policy;
+    _invalidateUsage();
+}
+
+void NonMovingBaseAllocator::flushCompaction()
+{
+    if (_policy.highWatermark > 0.f && _policy.deferred)
+    {
+        _updateUsage();
+        if (_needsCompaction())
+            _compactStep(0);
+    }
+}
+
+void NonMovingBaseAllocator::_updateUsage()
+{
+    if (_usageValid)
+        return;
+
+    // rescan once after external changes
+    _used = 0;
+    for (size_t i = 0; i < _numDynamic; ++i)
+        _used += _align(_getSize(i));
+    _usageValid = true;
+}
+
+void NonMovingBaseAllocator::_compactAutomatically()
+{
+    if (_compacting || _needsCompaction())
+        _compacting = !_compactStep(_policy.budget);
+}
+
+bool NonMovingBaseAllocator::_needsCompaction() const
+{
+    const uint64_t minSize = _align(_staticSize) + _used;
+    const uint64_t size = getSize();
+    return size > minSize &&
+           float(size - minSize) > _policy.highWatermark * float(_used);
+}
+
+bool NonMovingBaseAllocator::_compactStep(const size_t budget)
+{
+    // move the allocations to the front in the order of their offset; does
+    // not allocate for the sorting
+    uint64_t start = _align(_staticSize);
+    uint64_t previous = 0;
+    size_t moved = 0;
+    while (true)
+    {
+        size_t next = _numDynamic;
+        for (size_t i = 0; i < _numDynamic; ++i)
+        {
+            const uint64_t offset = _getOffset(i);
+            if (offset >= _staticSize && offset > previous &&
+                (next == _numDynamic || offset < _getOffset(next)))
+            {
+                next = i;
+            }
+        }
+        if (next == _numDynamic)
+            break;
+
+        uint64_t& offset = _getOffset(next);
+        const uint64_t size = _getSize(next);
+        if (offset != start)
+        {
+            if (budget > 0 && moved > 0 && moved + size > budget)
+                return false; // continue in the next step
+            uint8_t* data = getData();
+            ::memmove(data + start, data + offset, size);
+            offset = start;
+            moved += size;
+        }
+        previous = start;
+        start = _align(start + size);
+    }
+
+    // release the unused memory, keeping the reserve for further growth
+    const uint64_t reserve = uint64_t(_policy.lowWatermark * float(_used));
+    if (getSize() > start + reserve)
+        _resize(start + reserve);
+    return true;
 }
 }
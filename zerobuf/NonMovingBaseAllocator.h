@@ -12,30 +12,110 @@
 
 namespace zerobuf
 {
-/** Allocator base class which does not move existing fields */
+/**
+ * Allocator base class which does not move existing fields.
+ *
+ * Dynamic elements are placed at offsets which are a multiple of the given
+ * alignment. The data of the allocator has to be aligned accordingly.
+ */
 class NonMovingBaseAllocator : public Allocator
 {
 public:
-    ZEROBUF_API NonMovingBaseAllocator(size_t staticSize, size_t numDynamic);
+    ZEROBUF_API NonMovingBaseAllocator(size_t staticSize, size_t numDynamic,
+                                       size_t alignment = 1);
 
     ZEROBUF_API virtual ~NonMovingBaseAllocator();
 
     ZEROBUF_API uint8_t* updateAllocation(size_t index, bool copy,
                                           size_t size) final;
     ZEROBUF_API void compact(float threshold) final;
+    size_t getAlignment() const final { return _alignment; }
+    size_t getGeneration() const override { return _generation; }
+
+    /**
+     * Compact automatically according to the given policy.
+     *
+     * Tracks the used memory in updateAllocation() and compacts before an
+     * allocation once the policy triggers, or in flushCompaction() if the
+     * policy is deferred.
+     */
+    ZEROBUF_API void setCompactionPolicy(const CompactionPolicy& policy) final;
+    ZEROBUF_API void flushCompaction() final;
 
 protected:
+    NonMovingBaseAllocator()
+        : _staticSize(0)
+        , _numDynamic(0)
+        , _alignment(1)
+        , _generation(0)
+        , _used(0)
+        , _usageValid(false)
+        , _compacting(false)
+    {
+    }
+
     virtual void _resize(size_t newSize) = 0;
+    size_t _getStaticSize() const { return _staticSize; }
+    size_t _getNumDynamic() const { return _numDynamic; }
+    ZEROBUF_API void _setLayout(size_t staticSize, size_t numDynamic,
+                                size_t alignment);
+    uint64_t _align(uint64_t offset) const
+    {
+        return (offset + _alignment - 1) & ~uint64_t(_alignment - 1);
+    }
+
+    /** Rescan the used memory on the next allocation, after the data or the
+     *  layout changed outside of updateAllocation(). */
+    void _invalidateUsage()
+    {
+        _usageValid = false;
+        _compacting = false;
+    }
+    const CompactionPolicy& _getCompactionPolicy() const { return _policy; }
+    void _notifyReset() final
+    {
+        _invalidateUsage();
+        _nextGeneration();
+    }
+    void _nextGeneration() { ++_generation; }
+
+    /**
+     * @return a read-only, zero-filled buffer of at least the given size and
+     *         of the allocator or the given alignment, for const access to
+     *         storage which is not allocated yet. Never freed.
+     * @param versioned write the version header into the buffer
+     */
+    const uint8_t* _getEmptyImage(const size_t size, const bool versioned) const
+    {
+        return _getEmptyImage(size, _alignment, versioned);
+    }
+    ZEROBUF_API static const uint8_t* _getEmptyImage(size_t size,
+                                                     size_t alignment,
+                                                     bool versioned);
 
 private:
+    friend class LazyAllocator; // uses _getEmptyImage()
+
     NonMovingBaseAllocator(const NonMovingBaseAllocator&) = delete;
     NonMovingBaseAllocator& operator=(const NonMovingBaseAllocator&) = delete;
 
     size_t _staticSize;
     size_t _numDynamic;
+    size_t _alignment;
+    size_t _generation;
+
+    CompactionPolicy _policy;
+    uint64_t _used; // aligned size of all dynamic elems, tracked by policy
+    bool _usageValid;
+    bool _compacting; // budgeted compaction in progress
 
     uint8_t* _moveAllocation(size_t index, bool copy, size_t newOffset,
                              size_t newSize);
+    uint8_t* _updateAllocation(size_t index, bool copy, size_t newSize);
+    void _updateUsage();
+    void _compactAutomatically();
+    bool _needsCompaction() const;
+    bool _compactStep(size_t budget);
 };
 }
 #endif
@@ -30,9 +30,10 @@ template <class A>
 NonMovingSubAllocatorBase<A>::NonMovingSubAllocatorBase(A& parent,
                                                         const size_t index,
                                                         const size_t numDynamic,
-                                                        const size_t staticSize)
-    : NonMovingBaseAllocator(staticSize, numDynamic)
-    , _parent(parent)
+                                                        const size_t staticSize,
+                                                        const size_t alignment)
+    : NonMovingBaseAllocator(staticSize, numDynamic, alignment)
+    , _parent(&parent)
     , _index(index)
 {
     _initializeAllocation(parent, index, staticSize);
@@ -46,7 +47,8 @@ NonMovingSubAllocatorBase<A>::~NonMovingSubAllocatorBase()
 template <class A>
 uint8_t* NonMovingSubAllocatorBase<A>::getData()
 {
-    return _parent.getData() + _parent.getDynamicOffset(_index);
+    _getOffset();
+    return _parent->template getDynamic<uint8_t>(_index);
 }
 
 template <>
@@ -58,22 +60,27 @@ uint8_t* NonMovingSubAllocatorBase<const Allocator>::getData()
 template <class A>
 const uint8_t* NonMovingSubAllocatorBase<A>::getData() const
 {
-    return const_cast<const A&>(_parent).getData() +
-           _parent.getDynamicOffset(_index);
+    const A& parent = *_parent;
+    if (parent.getDynamicOffset(_index) == 0) // not allocated in the parent
+        return _getEmptyImage(_getStaticSize(), false);
+    return parent.template getDynamic<uint8_t>(_index);
 }
 
 template <class A>
 size_t NonMovingSubAllocatorBase<A>::getSize() const
 {
-    return _parent.getDynamicSize(_index);
+    if (_parent->getDynamicOffset(_index) == 0)
+        return _getStaticSize();
+    return _parent->getDynamicSize(_index);
 }
 
 template <class A>
 void NonMovingSubAllocatorBase<A>::copyBuffer(const void* data,
                                               const size_t size)
 {
-    void* to = _parent.updateAllocation(_index, false /*no copy*/, size);
+    void* to = _parent->updateAllocation(_index, false /*no copy*/, size);
     ::memcpy(to, data, size);
+    _nextGeneration();
 }
 
 template <>
@@ -86,7 +93,7 @@ void NonMovingSubAllocatorBase<const Allocator>::copyBuffer(const void*,
 template <class A>
 void NonMovingSubAllocatorBase<A>::_resize(const size_t newSize)
 {
-    _parent.updateAllocation(_index, true /*copy*/, newSize);
+    _parent->updateAllocation(_index, true /*copy*/, newSize);
 }
 
 template <>
@@ -95,6 +102,17 @@ void NonMovingSubAllocatorBase<const Allocator>::_resize(const size_t)
     throw std::runtime_error("Non-const access on const allocator");
 }
 
+template <class A>
+uint64_t NonMovingSubAllocatorBase<A>::_getOffset()
+{
+    // the parent may have been moved from and allocated again since
+    const uint64_t offset = _parent->getDynamicOffset(_index);
+    if (offset != 0 || !_parent->isMutable())
+        return offset;
+    _initializeAllocation(*_parent, _index, _getStaticSize());
+    return _parent->getDynamicOffset(_index);
+}
+
 template class NonMovingSubAllocatorBase<Allocator>;
 template class NonMovingSubAllocatorBase<const Allocator>;
 }
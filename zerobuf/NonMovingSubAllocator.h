@@ -18,18 +18,37 @@ class NonMovingSubAllocatorBase : public NonMovingBaseAllocator
 {
 public:
     ZEROBUF_API NonMovingSubAllocatorBase(A& parent, size_t index,
-                                          size_t numDynamic, size_t staticSize);
+                                          size_t numDynamic, size_t staticSize,
+                                          size_t alignment = 1);
     ZEROBUF_API ~NonMovingSubAllocatorBase();
 
     ZEROBUF_API uint8_t* getData() final;
     ZEROBUF_API const uint8_t* getData() const final;
     ZEROBUF_API size_t getSize() const final;
     ZEROBUF_API void copyBuffer(const void* data, size_t size) final;
-    bool isMutable() const final { return _parent.isMutable(); }
+    bool isMutable() const final { return _parent->isMutable(); }
+    bool isMaterialized() const final
+    {
+        return _parent->getDynamicOffset(_index) != 0 &&
+               _parent->isMaterialized();
+    }
+    size_t getGeneration() const final
+    {
+        return NonMovingBaseAllocator::getGeneration() +
+               _parent->getGeneration();
+    }
+    /**
+     * Rebind to a new parent, used by generated classes after a move. The
+     * static section is allocated in the new parent on first modifying
+     * access, const access reads an empty image until then.
+     */
+    void reset(A& parent) { _parent = &parent; }
 private:
-    A& _parent;
+    A* _parent;
     const size_t _index;
 
+    uint64_t _getOffset();
+
     NonMovingSubAllocatorBase(const NonMovingSubAllocatorBase<A>&) = delete;
     NonMovingSubAllocatorBase<A>& operator=(
         const NonMovingSubAllocatorBase<A>&) = delete;
@@ -0,0 +1,183 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEROBUF_POOL_H
+#define ZEROBUF_POOL_H
+
+#include <zerobuf/types.h>
+
+#include <memory> // std::unique_ptr
+#include <mutex>
+#include <vector>
+
+namespace zerobuf
+{
+/**
+ * A per-type pool recycling generated zerobuf objects.
+ *
+ * Released objects are reset to their default values using resetToDefaults()
+ * and keep their storage, so that acquiring a recycled object does neither
+ * construct nor allocate. Each thread caches up to cacheSize objects without
+ * locking. Objects exceeding the thread cache are moved in batches to a shared
+ * list of up to sharedSize objects, from where other threads refill their
+ * caches; objects exceeding the shared list are deleted.
+ *
+ * Objects must own their storage, i.e., must not be a view or a member of
+ * another zerobuf when released. Example:
+ * @code
+ * zerobuf::Pool< Foo >::Ptr foo = zerobuf::Pool< Foo >::acquire();
+ * foo->setBar( 42 );
+ * publish( *foo );
+ * // foo is reset and returned to the pool when going out of scope
+ * @endcode
+ *
+ * @param T the generated zerobuf class
+ */
+template <class T>
+class Pool
+{
+public:
+    /** The maximum number of objects cached per thread. */
+    static const size_t cacheSize = 64;
+
+    /** The maximum number of objects in the shared overflow list. */
+    static const size_t sharedSize = 4096;
+
+    /** Returns objects to the pool instead of deleting them. */
+    struct Recycler
+    {
+        void operator()(T* object) const { Pool::release(object); }
+    };
+
+    /** An object owned by the caller until it is returned to the pool. */
+    typedef std::unique_ptr<T, Recycler> Ptr;
+
+    /** @return an object with default values, recycled if possible. */
+    static Ptr acquire()
+    {
+        Cache& cache = _cache();
+        if (cache.objects.empty())
+            _shared().take(cache.objects, cacheSize / 2);
+        if (cache.objects.empty())
+            return Ptr(new T);
+
+        T* object = cache.objects.back();
+        cache.objects.pop_back();
+        return Ptr(object);
+    }
+
+    /** Reset the given object to its default values and keep it for reuse. */
+    static void release(T* object)
+    {
+        if (!object)
+            return;
+
+        object->resetToDefaults();
+        Cache& cache = _cache();
+        if (cache.objects.size() >= cacheSize)
+            _shared().give(cache.objects, cacheSize / 2);
+        cache.objects.push_back(object);
+    }
+
+    /** Delete the objects cached by the calling thread and the shared list. */
+    static void clear()
+    {
+        Cache& cache = _cache();
+        for (T* object : cache.objects)
+            delete object;
+        cache.objects.clear();
+        _shared().clear();
+    }
+
+    /** @return the number of objects cached by the calling thread. */
+    static size_t getNumCached() { return _cache().objects.size(); }
+
+    /** @return the number of objects in the shared overflow list. */
+    static size_t getNumShared() { return _shared().size(); }
+
+private:
+    Pool() = delete;
+
+    class Shared
+    {
+    public:
+        Shared() { _objects.reserve(sharedSize); }
+        ~Shared() { clear(); }
+
+        void take(std::vector<T*>& objects, const size_t num)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            while (!_objects.empty() && objects.size() < num)
+            {
+                objects.push_back(_objects.back());
+                _objects.pop_back();
+            }
+        }
+
+        void give(std::vector<T*>& objects, const size_t num)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (size_t i = 0; i < num && !objects.empty(); ++i)
+            {
+                if (_objects.size() < sharedSize)
+                    _objects.push_back(objects.back());
+                else
+                    delete objects.back();
+                objects.pop_back();
+            }
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (T* object : _objects)
+                delete object;
+            _objects.clear();
+        }
+
+        size_t size()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _objects.size();
+        }
+
+    private:
+        std::mutex _mutex;
+        std::vector<T*> _objects;
+    };
+
+    struct Cache
+    {
+        Cache()
+        {
+            _shared(); // constructed first, destroyed after the caches
+            objects.reserve(cacheSize);
+        }
+
+        // hand cached objects to the other threads on thread exit
+        ~Cache() { _shared().give(objects, objects.size()); }
+
+        std::vector<T*> objects;
+    };
+
+    static Shared& _shared()
+    {
+        static Shared shared;
+        return shared;
+    }
+
+    static Cache& _cache()
+    {
+        static thread_local Cache cache;
+        return cache;
+    }
+};
+
+template <class T>
+const size_t Pool<T>::cacheSize;
+template <class T>
+const size_t Pool<T>::sharedSize;
+}
+
+#endif
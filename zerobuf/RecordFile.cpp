@@ -0,0 +1,497 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#include "RecordFile.h"
+
+#include "Zerobuf.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace zerobuf
+{
+namespace
+{
+const uint32_t recordMagic = 0x5a425243;  // 'ZBRC'
+const uint32_t indexMagic = 0x5a425249;   // 'ZBRI'
+const uint32_t indexVersion = 2;
+const size_t indexHeaderSize = 16;        // magic, version, reserved
+const size_t indexEntrySize = 16;         // offset, timestamp
+const size_t writeBufferSize = 1 << 20;
+const size_t recordAlignment = 64;        // largest zerobufCxx.py --align
+
+struct RecordHeader
+{
+    uint32_t magic;
+    uint32_t checksum;
+    uint64_t size;
+    uint64_t timestamp;
+};
+static_assert(sizeof(RecordHeader) == 24, "Unexpected record header size");
+
+/** @return the offset of the next record header after the given end. */
+uint64_t _nextRecord(const uint64_t end)
+{
+    // align the payload, following the header, for aligned zerobuf types
+    const uint64_t payload = end + sizeof(RecordHeader) + recordAlignment - 1;
+    return (payload & ~uint64_t(recordAlignment - 1)) - sizeof(RecordHeader);
+}
+
+// FNV-1a over size, timestamp and payload
+uint32_t _checksum(const RecordHeader& header, const void* data,
+                   const size_t size)
+{
+    uint32_t hash = 2166136261u;
+    const auto update = [&hash](const uint8_t* ptr, const size_t num) {
+        for (size_t i = 0; i < num; ++i)
+            hash = (hash ^ ptr[i]) * 16777619u;
+    };
+    update(reinterpret_cast<const uint8_t*>(&header.size),
+           sizeof(header.size) + sizeof(header.timestamp));
+    update(reinterpret_cast<const uint8_t*>(data), size);
+    return hash;
+}
+
+std::string _error(const std::string& what, const std::string& filename)
+{
+    return what + " " + filename + ": " + ::strerror(errno);
+}
+
+/**
+ * @return the end offset of the valid record at offset, or 0 if there is no
+ *         complete and intact record at offset.
+ */
+uint64_t _validate(const uint8_t* data, const uint64_t size,
+                   const uint64_t offset)
+{
+    if (offset + sizeof(RecordHeader) > size ||
+        _nextRecord(offset) != offset)
+    {
+        return 0;
+    }
+
+    RecordHeader header;
+    ::memcpy(&header, data + offset, sizeof(header));
+    if (header.magic != recordMagic ||
+        header.size > size - offset - sizeof(RecordHeader))
+    {
+        return 0;
+    }
+
+    const uint64_t end = offset + sizeof(RecordHeader) + header.size;
+    const uint8_t* payload = data + offset + sizeof(RecordHeader);
+    if (_checksum(header, payload, header.size) != header.checksum)
+        return 0;
+    return end;
+}
+
+/**
+ * Scan the valid records following the record end at offset, appending their
+ * offsets and timestamps to entries.
+ *
+ * @return the end offset of the last valid record.
+ */
+uint64_t _scan(const uint8_t* data, const uint64_t size, uint64_t offset,
+               uint64_t lastTimestamp, std::vector<uint64_t>& entries)
+{
+    for (;;)
+    {
+        const uint64_t record = _nextRecord(offset);
+        const uint64_t end = _validate(data, size, record);
+        if (end == 0)
+            return offset;
+
+        const uint64_t timestamp = reinterpret_cast<const RecordHeader*>(
+                                       data + record)->timestamp;
+        if (timestamp < lastTimestamp)
+            return offset;
+
+        entries.push_back(record);
+        entries.push_back(timestamp);
+        lastTimestamp = timestamp;
+        offset = end;
+    }
+}
+
+/**
+ * Determine the number of usable entries in a mapped index file.
+ *
+ * @return the number of entries and sets dataEnd to the end of the last
+ *         indexed record.
+ */
+size_t _checkIndex(const uint8_t* index, const size_t indexSize,
+                   const uint8_t* data, const uint64_t dataSize,
+                   uint64_t& dataEnd)
+{
+    dataEnd = 0;
+    if (!index || indexSize < indexHeaderSize)
+        return 0;
+
+    const uint32_t* header = reinterpret_cast<const uint32_t*>(index);
+    if (header[0] != indexMagic || header[1] != indexVersion)
+        return 0;
+
+    const size_t numEntries = (indexSize - indexHeaderSize) / indexEntrySize;
+    if (numEntries == 0)
+        return 0;
+
+    const uint64_t* entries =
+        reinterpret_cast<const uint64_t*>(index + indexHeaderSize);
+    dataEnd = _validate(data, dataSize, entries[(numEntries - 1) * 2]);
+    return dataEnd == 0 ? 0 : numEntries;
+}
+
+void _writeAll(const int fd, const void* data, size_t size, uint64_t offset,
+               const char* what)
+{
+    const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data);
+    while (size > 0)
+    {
+        const ssize_t written = ::pwrite(fd, ptr, size, off_t(offset));
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(std::string("Write to record ") + what +
+                                     " failed: " + ::strerror(errno));
+        }
+        ptr += written;
+        offset += uint64_t(written);
+        size -= size_t(written);
+    }
+}
+
+const uint8_t* _map(const int fd, const size_t size)
+{
+    if (size == 0)
+        return nullptr;
+    void* ptr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    return ptr == MAP_FAILED ? nullptr : reinterpret_cast<const uint8_t*>(ptr);
+}
+
+void _unmap(const void* ptr, const size_t size)
+{
+    if (ptr)
+        ::munmap(const_cast<void*>(ptr), size);
+}
+
+/** Read-only mapping of a file, unmapped on destruction. */
+struct Mapping
+{
+    Mapping(const int fd, const size_t size_)
+        : data(_map(fd, size_))
+        , size(size_)
+    {
+    }
+    ~Mapping() { _unmap(data, size); }
+
+    const uint8_t* const data;
+    const size_t size;
+};
+
+size_t _getFileSize(const int fd)
+{
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+        return 0;
+    return size_t(info.st_size);
+}
+}
+
+RecordFileWriter::RecordFileWriter(const std::string& filename,
+                                   const size_t indexInterval)
+    : _fd(::open(filename.c_str(), O_RDWR | O_CREAT, 0644))
+    , _indexFd(-1)
+    , _indexInterval(std::max(indexInterval, size_t(1)))
+    , _numRecords(0)
+    , _fileSize(0)
+    , _lastTimestamp(0)
+{
+    if (_fd < 0)
+        throw std::runtime_error(_error("Can't open record file", filename));
+
+    const std::string indexName = filename + ".idx";
+    _indexFd = ::open(indexName.c_str(), O_RDWR | O_CREAT, 0644);
+    if (_indexFd < 0)
+    {
+        ::close(_fd);
+        throw std::runtime_error(_error("Can't open record index", indexName));
+    }
+
+    try
+    {
+        _recover(filename);
+        _buffer.reserve(writeBufferSize);
+    }
+    catch (...)
+    {
+        ::close(_fd);
+        ::close(_indexFd);
+        throw;
+    }
+}
+
+RecordFileWriter::~RecordFileWriter()
+{
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+    }
+    ::close(_fd);
+    ::close(_indexFd);
+}
+
+size_t RecordFileWriter::append(const Zerobuf& zerobuf,
+                                const uint64_t timestamp)
+{
+    const Data& data = zerobuf.toBinary();
+    return append(data.ptr.get(), data.size, timestamp);
+}
+
+size_t RecordFileWriter::append(const void* data, const size_t size,
+                                const uint64_t timestamp)
+{
+    if (timestamp < _lastTimestamp)
+        throw std::runtime_error("Record timestamp " +
+                                 std::to_string(timestamp) +
+                                 " is older than last record timestamp " +
+                                 std::to_string(_lastTimestamp));
+
+    RecordHeader header = {recordMagic, 0, size, timestamp};
+    header.checksum = _checksum(header, data, size);
+
+    const uint64_t offset = _nextRecord(_fileSize);
+    const size_t padding = size_t(offset - _fileSize);
+    const size_t recordSize = padding + sizeof(header) + size;
+    static const uint8_t zeros[recordAlignment] = {0};
+
+    if (_buffer.size() + recordSize > writeBufferSize)
+        _writeBuffer();
+
+    if (recordSize > writeBufferSize)
+    {
+        // large records are written directly without buffer copy
+        _writeAll(_fd, zeros, padding, _fileSize, "file");
+        _writeAll(_fd, &header, sizeof(header), offset, "file");
+        _writeAll(_fd, data, size, offset + sizeof(header), "file");
+    }
+    else
+    {
+        const uint8_t* headerPtr = reinterpret_cast<const uint8_t*>(&header);
+        const uint8_t* dataPtr = reinterpret_cast<const uint8_t*>(data);
+        _buffer.insert(_buffer.end(), zeros, zeros + padding);
+        _buffer.insert(_buffer.end(), headerPtr, headerPtr + sizeof(header));
+        _buffer.insert(_buffer.end(), dataPtr, dataPtr + size);
+    }
+
+    _fileSize += recordSize;
+    _lastTimestamp = timestamp;
+    _pendingIndex.push_back(offset);
+    _pendingIndex.push_back(timestamp);
+    ++_numRecords;
+
+    if (_pendingIndex.size() / 2 >= _indexInterval)
+        flush();
+    return _numRecords - 1;
+}
+
+void RecordFileWriter::flush(const bool sync)
+{
+    _writeBuffer();
+    if (sync)
+#ifdef __APPLE__
+        ::fsync(_fd);
+#else
+        ::fdatasync(_fd);
+#endif
+
+    // index entries are written after the data they reference
+    _writeIndex();
+    if (sync)
+#ifdef __APPLE__
+        ::fsync(_indexFd);
+#else
+        ::fdatasync(_indexFd);
+#endif
+}
+
+void RecordFileWriter::_recover(const std::string& filename)
+{
+    // recover from the existing index and the unindexed tail
+    size_t numIndexed = 0;
+    {
+        const Mapping data(_fd, _getFileSize(_fd));
+        const Mapping index(_indexFd, _getFileSize(_indexFd));
+        if (data.size > 0 && !data.data)
+            throw std::runtime_error(_error("Can't map record file", filename));
+
+        uint64_t dataEnd = 0;
+        numIndexed = _checkIndex(index.data, index.size, data.data, data.size,
+                                 dataEnd);
+        if (numIndexed > 0)
+        {
+            _lastTimestamp = reinterpret_cast<const uint64_t*>(
+                index.data + indexHeaderSize)[numIndexed * 2 - 1];
+        }
+        _fileSize = _scan(data.data, data.size, dataEnd, _lastTimestamp,
+                          _pendingIndex);
+        _numRecords = numIndexed + _pendingIndex.size() / 2;
+        if (!_pendingIndex.empty())
+            _lastTimestamp = _pendingIndex.back();
+    }
+
+    // drop partial records and index entries, rewrite the index header
+    const uint32_t header[4] = {indexMagic, indexVersion, 0, 0};
+    if (::ftruncate(_fd, off_t(_fileSize)) != 0 ||
+        ::ftruncate(_indexFd,
+                    off_t(indexHeaderSize + numIndexed * indexEntrySize)) != 0)
+    {
+        throw std::runtime_error(_error("Can't truncate record file",
+                                        filename));
+    }
+    _writeAll(_indexFd, header, sizeof(header), 0, "index");
+    _writeIndex();
+}
+
+void RecordFileWriter::_writeBuffer()
+{
+    if (_buffer.empty())
+        return;
+    _writeAll(_fd, _buffer.data(), _buffer.size(), _fileSize - _buffer.size(),
+              "file");
+    _buffer.clear();
+}
+
+void RecordFileWriter::_writeIndex()
+{
+    if (_pendingIndex.empty())
+        return;
+
+    const size_t numIndexed = _numRecords - _pendingIndex.size() / 2;
+    _writeAll(_indexFd, _pendingIndex.data(),
+              _pendingIndex.size() * sizeof(uint64_t),
+              indexHeaderSize + numIndexed * indexEntrySize, "index");
+    _pendingIndex.clear();
+}
+
+RecordFileReader::RecordFileReader(const std::string& filename)
+    : _data(nullptr)
+    , _size(0)
+    , _index(nullptr)
+    , _indexSize(0)
+    , _numIndexed(0)
+{
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error(_error("Can't open record file", filename));
+
+    _size = _getFileSize(fd);
+    _data = _map(fd, _size);
+    ::close(fd);
+    if (_size > 0 && !_data)
+        throw std::runtime_error(_error("Can't map record file", filename));
+
+    const std::string indexName = filename + ".idx";
+    const int indexFd = ::open(indexName.c_str(), O_RDONLY);
+    const uint8_t* index = nullptr;
+    if (indexFd >= 0)
+    {
+        _indexSize = _getFileSize(indexFd);
+        index = _map(indexFd, _indexSize);
+        ::close(indexFd);
+    }
+
+    uint64_t dataEnd = 0;
+    _numIndexed = _checkIndex(index, _indexSize, _data, _size, dataEnd);
+    if (index)
+        _index = reinterpret_cast<const uint64_t*>(index + indexHeaderSize);
+
+    const uint64_t lastTimestamp =
+        _numIndexed > 0 ? _index[_numIndexed * 2 - 1] : 0;
+    _scan(_data, _size, dataEnd, lastTimestamp, _tail);
+}
+
+RecordFileReader::~RecordFileReader()
+{
+    _unmap(_data, _size);
+    if (_index)
+        _unmap(reinterpret_cast<const uint8_t*>(_index) - indexHeaderSize,
+               _indexSize);
+}
+
+const void* RecordFileReader::getData(const size_t record) const
+{
+    return _data + _getOffset(record) + sizeof(RecordHeader);
+}
+
+size_t RecordFileReader::getSize(const size_t record) const
+{
+    return reinterpret_cast<const RecordHeader*>(_data + _getOffset(record))
+        ->size;
+}
+
+uint64_t RecordFileReader::getTimestamp(const size_t record) const
+{
+    return reinterpret_cast<const RecordHeader*>(_data + _getOffset(record))
+        ->timestamp;
+}
+
+size_t RecordFileReader::findRecord(const uint64_t timestamp) const
+{
+    const auto timestampAt = [this](const size_t i) {
+        return i < _numIndexed ? _index[i * 2 + 1]
+                               : _tail[(i - _numIndexed) * 2 + 1];
+    };
+
+    size_t first = 0;
+    size_t count = getNumRecords();
+    while (count > 0)
+    {
+        const size_t step = count / 2;
+        const size_t i = first + step;
+        if (timestampAt(i) < timestamp)
+        {
+            first = i + 1;
+            count -= step + 1;
+        }
+        else
+            count = step;
+    }
+    return first;
+}
+
+uint64_t RecordFileReader::_getOffset(const size_t record) const
+{
+    uint64_t offset = 0;
+    if (record < _numIndexed)
+    {
+        // only the last indexed record was validated on open
+        offset = _index[record * 2];
+        if (offset >= _size || _nextRecord(offset) != offset ||
+            sizeof(RecordHeader) > _size - offset ||
+            reinterpret_cast<const RecordHeader*>(_data + offset)->size >
+                _size - offset - sizeof(RecordHeader))
+        {
+            throw std::runtime_error("Invalid index entry for record " +
+                                     std::to_string(record));
+        }
+        return offset;
+    }
+
+    const size_t tailIndex = record - _numIndexed;
+    if (tailIndex * 2 >= _tail.size())
+        throw std::runtime_error("Record " + std::to_string(record) +
+                                 " out of range, have " +
+                                 std::to_string(getNumRecords()));
+    return _tail[tailIndex * 2];
+}
+}
@@ -0,0 +1,155 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEROBUF_RECORDFILE_H
+#define ZEROBUF_RECORDFILE_H
+
+#include <zerobuf/api.h>
+#include <zerobuf/types.h>
+
+#include <string>
+#include <vector>
+
+namespace zerobuf
+{
+/**
+ * Writes zerobuf records to an append-only file.
+ *
+ * Each record is stored as a small header (magic, checksum, size, timestamp)
+ * followed by the binary zerobuf. Records are padded to place the binary
+ * zerobufs at 64 byte boundaries, the largest alignment of generated types.
+ * Record offsets and timestamps are appended to a separate index file
+ * ("<filename>.idx") every indexInterval records and on flush(). Timestamps
+ * must be monotonically increasing to allow binary search by time in
+ * RecordFileReader.
+ *
+ * Opening an existing file appends to it. Records written after the last index
+ * flush are recovered by scanning the tail of the data file; a partially
+ * written record left by a crash is truncated.
+ *
+ * Not thread safe.
+ */
+class RecordFileWriter
+{
+public:
+    /**
+     * Open or create a record file for appending.
+     *
+     * @param filename the data file name
+     * @param indexInterval number of records after which the index is flushed
+     * @throw std::runtime_error if the file can't be opened
+     */
+    ZEROBUF_API explicit RecordFileWriter(const std::string& filename,
+                                          size_t indexInterval = 4096);
+
+    /** Flush pending records and the index, and close the file. */
+    ZEROBUF_API ~RecordFileWriter();
+
+    /**
+     * Append a zerobuf as a new record.
+     *
+     * @param zerobuf the object to record
+     * @param timestamp the record timestamp, not smaller than the last one
+     * @return the record number
+     * @throw std::runtime_error if the timestamp is out of order or the write
+     *        failed
+     */
+    ZEROBUF_API size_t append(const Zerobuf& zerobuf, uint64_t timestamp);
+
+    /** Append binary zerobuf data as a new record. @sa append() */
+    ZEROBUF_API size_t append(const void* data, size_t size,
+                              uint64_t timestamp);
+
+    /**
+     * Write all pending records and index entries to the file.
+     *
+     * @param sync also force the data to the storage device (fdatasync)
+     */
+    ZEROBUF_API void flush(bool sync = false);
+
+    /** @return the number of records in the file. */
+    size_t getNumRecords() const { return _numRecords; }
+
+private:
+    RecordFileWriter(const RecordFileWriter&) = delete;
+    RecordFileWriter& operator=(const RecordFileWriter&) = delete;
+
+    int _fd;
+    int _indexFd;
+    const size_t _indexInterval;
+    size_t _numRecords;
+    uint64_t _fileSize; // including not yet written _buffer
+    uint64_t _lastTimestamp;
+    std::vector<uint8_t> _buffer;
+    std::vector<uint64_t> _pendingIndex; // (offset, timestamp) pairs
+
+    void _recover(const std::string& filename);
+    void _writeBuffer();
+    void _writeIndex();
+};
+
+/**
+ * Gives read-only, random access to the records of a record file.
+ *
+ * The data and index files are memory-mapped; accessing a record by number is
+ * O(1) and returns a view on the mapped memory. Records not covered by the
+ * index are recovered by scanning the tail of the data file. The reader sees
+ * the records present when it was opened.
+ */
+class RecordFileReader
+{
+public:
+    /**
+     * Open and map a record file.
+     *
+     * @param filename the data file name
+     * @throw std::runtime_error if the file can't be opened or mapped
+     */
+    ZEROBUF_API explicit RecordFileReader(const std::string& filename);
+    ZEROBUF_API ~RecordFileReader();
+
+    /** @return the number of readable records. */
+    size_t getNumRecords() const { return _numIndexed + _tail.size() / 2; }
+
+    /** @return the binary data of the given record. */
+    ZEROBUF_API const void* getData(size_t record) const;
+
+    /** @return the size in bytes of the given record. */
+    ZEROBUF_API size_t getSize(size_t record) const;
+
+    /** @return the timestamp of the given record. */
+    ZEROBUF_API uint64_t getTimestamp(size_t record) const;
+
+    /**
+     * @return the first record with a timestamp not smaller than the given
+     *         one, or getNumRecords() if there is none.
+     */
+    ZEROBUF_API size_t findRecord(uint64_t timestamp) const;
+
+    /**
+     * @return a read-only object of type T on the data of the given record,
+     *         valid for the lifetime of this reader.
+     */
+    template <class T>
+    std::unique_ptr<const T> get(const size_t record) const
+    {
+        return T::create(getData(record), getSize(record));
+    }
+
+private:
+    RecordFileReader(const RecordFileReader&) = delete;
+    RecordFileReader& operator=(const RecordFileReader&) = delete;
+
+    const uint8_t* _data;
+    size_t _size;
+    const uint64_t* _index; // (offset, timestamp) pairs
+    size_t _indexSize;
+    size_t _numIndexed;
+    std::vector<uint64_t> _tail; // (offset, timestamp) pairs not in _index
+
+    uint64_t _getOffset(size_t record) const;
+};
+}
+
+#endif
@@ -0,0 +1,220 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#include "SegmentedAllocator.h"
+
+#include "ConstAllocator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace zerobuf
+{
+namespace
+{
+uint8_t* _allocate(const size_t alignment, const size_t size)
+{
+    void* ptr = nullptr;
+    if (alignment <= alignof(std::max_align_t))
+        ptr = ::malloc(size ? size : 1);
+    else
+    {
+#ifdef _WIN32
+        ptr = ::_aligned_malloc(size ? size : 1, alignment);
+#else
+        if (::posix_memalign(&ptr, alignment, size ? size : 1) != 0)
+            ptr = nullptr;
+#endif
+    }
+    if (!ptr)
+        throw std::bad_alloc();
+    return (uint8_t*)ptr;
+}
+
+void _free(const size_t alignment, uint8_t* ptr)
+{
+#ifdef _WIN32
+    if (alignment > alignof(std::max_align_t))
+    {
+        ::_aligned_free(ptr);
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+    ::free(ptr);
+}
+
+uint64_t& _header(uint8_t* data, const size_t index, const size_t field)
+{
+    return *reinterpret_cast<uint64_t*>(data + 4 + index * 16 + field * 8);
+}
+}
+
+SegmentedAllocator::SegmentedAllocator(const size_t staticSize,
+                                       const size_t numDynamic,
+                                       const size_t alignment)
+    : _data(nullptr)
+    , _staticSize(staticSize)
+    , _size(staticSize)
+    , _alignment(alignment)
+    , _segments(numDynamic, Segment{nullptr, 0})
+    , _generation(0)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+        throw std::runtime_error("Allocator alignment must be a power of two");
+    if (staticSize < 4 + numDynamic * 16)
+        throw std::runtime_error("Static size too small for dynamic headers");
+
+    _data = _allocate(_alignment, staticSize);
+    ::memset(_data, 0, staticSize);
+}
+
+SegmentedAllocator::~SegmentedAllocator()
+{
+    for (const Segment& segment : _segments)
+        if (segment.data)
+            _free(_alignment, segment.data);
+    _free(_alignment, _data);
+}
+
+void SegmentedAllocator::copyBuffer(const void* data, const size_t size)
+{
+    if (size < _staticSize)
+        throw std::runtime_error("Binary too small for static section");
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    ConstAllocator(bytes, size).check(_segments.size());
+
+    ::memcpy(_data, bytes, _staticSize);
+    for (size_t i = 0; i < _segments.size(); ++i)
+    {
+        const uint64_t offset = _header(_data, i, 0);
+        const uint64_t dynamicSize = _header(_data, i, 1);
+        if (dynamicSize == 0)
+            continue;
+
+        Segment& segment = _segments[i];
+        if (dynamicSize > segment.capacity)
+            _reserve(segment, dynamicSize, 0);
+        ::memcpy(segment.data, bytes + offset, dynamicSize);
+    }
+    _updateOffsets();
+    ++_generation;
+}
+
+uint8_t* SegmentedAllocator::updateAllocation(const size_t index,
+                                              const bool copy,
+                                              const size_t newSize)
+{
+    if (index >= _segments.size())
+        throw std::runtime_error("Dynamic #" + std::to_string(index) +
+                                 " out of range");
+
+    Segment& segment = _segments[index];
+    uint64_t& size = _header(_data, index, 1);
+    const size_t used = copy ? std::min(size_t(size), segment.capacity) : 0;
+
+    if (newSize > segment.capacity) // grow geometrically
+        _reserve(segment, std::max(newSize, segment.capacity * 3 / 2), used);
+    if (newSize > used) // like fresh allocations of contiguous allocators
+        ::memset(segment.data + used, 0, newSize - used);
+
+    size = newSize;
+    _updateOffsets();
+    return newSize > 0 ? segment.data : nullptr;
+}
+
+void SegmentedAllocator::compact(const float threshold)
+{
+    for (size_t i = 0; i < _segments.size(); ++i)
+    {
+        Segment& segment = _segments[i];
+        const size_t size = _header(_data, i, 1);
+        if (segment.capacity == 0 ||
+            float(segment.capacity - size) / float(size + 1) < threshold)
+        {
+            continue;
+        }
+
+        if (size == 0)
+        {
+            _free(_alignment, segment.data);
+            segment = Segment{nullptr, 0};
+        }
+        else
+            _reserve(segment, size, size);
+    }
+    _updateOffsets();
+}
+
+size_t SegmentedAllocator::getCapacity(const size_t index) const
+{
+    return _segments.at(index).capacity;
+}
+
+uint8_t* SegmentedAllocator::_getDynamicData(const size_t index)
+{
+    _getOffset(index);
+    uint8_t* data = _segments.at(index).data;
+    return data ? data : _data;
+}
+
+const uint8_t* SegmentedAllocator::_getDynamicData(const size_t index) const
+{
+    _getOffset(index);
+    const uint8_t* data = _segments.at(index).data;
+    return data ? data : _data;
+}
+
+void SegmentedAllocator::_reserve(Segment& segment, const size_t capacity,
+                                  const size_t used)
+{
+    // leave the segment untouched if the allocation throws
+    uint8_t* data = nullptr;
+    if (used > 0 && segment.data && _alignment <= alignof(std::max_align_t))
+    {
+        // realloc of large segments remaps pages instead of copying
+        data = (uint8_t*)::realloc(segment.data, capacity ? capacity : 1);
+        if (!data)
+            throw std::bad_alloc();
+    }
+    else
+    {
+        data = _allocate(_alignment, capacity);
+        if (segment.data)
+        {
+            ::memcpy(data, segment.data, std::min(used, capacity));
+            _free(_alignment, segment.data);
+        }
+    }
+    segment.data = data;
+    segment.capacity = capacity;
+}
+
+void SegmentedAllocator::_updateOffsets()
+{
+    // lay out the members compactly in the serialized binary
+    uint64_t end = _staticSize;
+    for (size_t i = 0; i < _segments.size(); ++i)
+    {
+        const uint64_t size = _header(_data, i, 1);
+        uint64_t& offset = _header(_data, i, 0);
+        if (size == 0)
+        {
+            offset = 0;
+            continue;
+        }
+        offset = (end + _alignment - 1) & ~uint64_t(_alignment - 1);
+        end = offset + size;
+    }
+    _size = end;
+}
+}
@@ -0,0 +1,82 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEROBUF_SEGMENTEDALLOCATOR_H
+#define ZEROBUF_SEGMENTEDALLOCATOR_H
+
+#include <zerobuf/Allocator.h> // base class
+#include <zerobuf/api.h>
+
+#include <vector>
+
+namespace zerobuf
+{
+/**
+ * A zerobuf root allocator storing each dynamic member in a separate segment.
+ *
+ * Growing a dynamic member only reallocates its own segment, with a geometric
+ * growth of its capacity, instead of the whole zerobuf. This avoids copying
+ * large, incrementally growing payloads and needs no contiguous memory for all
+ * members. getData() only contains the static section; the dynamic headers
+ * hold the offsets of the members in the serialized, compact binary.
+ *
+ * Zerobuf::toBinarySegments() returns the binary as a scatter-gather list,
+ * whereas Zerobuf::toBinary() has to assemble a contiguous copy. Example:
+ * @code
+ * Volume volume( zerobuf::AllocatorPtr( new zerobuf::SegmentedAllocator(
+ *     Volume::ZEROBUF_STATIC_SIZE(), Volume::ZEROBUF_NUM_DYNAMICS( ))));
+ * @endcode
+ */
+class SegmentedAllocator : public Allocator
+{
+public:
+    ZEROBUF_API SegmentedAllocator(size_t staticSize, size_t numDynamic,
+                                   size_t alignment = 1);
+    ZEROBUF_API ~SegmentedAllocator();
+
+    uint8_t* getData() final { return _data; }
+    const uint8_t* getData() const final { return _data; }
+    size_t getSize() const final { return _size; }
+    ZEROBUF_API void copyBuffer(const void* data, size_t size) final;
+    ZEROBUF_API uint8_t* updateAllocation(size_t index, bool copy,
+                                          size_t newSize) final;
+
+    /** Release unused capacity of the segments exceeding the threshold. */
+    ZEROBUF_API void compact(float threshold) final;
+    bool isMovable() const final { return true; }
+    bool isContiguous() const final { return false; }
+    size_t getAlignment() const final { return _alignment; }
+    size_t getGeneration() const final { return _generation; }
+
+    /** @return the allocated capacity of the dynamic member at index. */
+    ZEROBUF_API size_t getCapacity(size_t index) const;
+
+protected:
+    void _notifyReset() final { ++_generation; }
+    ZEROBUF_API uint8_t* _getDynamicData(size_t index) final;
+    ZEROBUF_API const uint8_t* _getDynamicData(size_t index) const final;
+
+private:
+    SegmentedAllocator(const SegmentedAllocator&) = delete;
+    SegmentedAllocator& operator=(const SegmentedAllocator&) = delete;
+
+    struct Segment
+    {
+        uint8_t* data;
+        size_t capacity;
+    };
+
+    uint8_t* _data; // static section
+    const size_t _staticSize;
+    size_t _size; // of the serialized binary
+    const size_t _alignment;
+    std::vector<Segment> _segments;
+    size_t _generation;
+
+    void _reserve(Segment& segment, size_t capacity, size_t used);
+    void _updateOffsets();
+};
+}
+
+#endif
@@ -0,0 +1,231 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEROBUF_SHAREDZEROBUF_H
+#define ZEROBUF_SHAREDZEROBUF_H
+
+#include <zerobuf/ConstAllocator.h> // used inline
+#include <zerobuf/Zerobuf.h>        // used inline
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace zerobuf
+{
+/**
+ * Publishes consistent snapshots of a zerobuf from one writer thread to many
+ * reader threads.
+ *
+ * The data is kept in two binary slots. An update which only modifies static
+ * members, i.e. which leaves the dynamic headers and all dynamic data
+ * unchanged, is copied in place into the active slot under a sequence lock.
+ * Any other update is written to the inactive slot, which is then atomically
+ * made active; the writer waits until all readers have left the inactive slot
+ * before reusing it.
+ *
+ * Readers access the published data without a copy through a ConstAllocator
+ * view, and retry transparently if an in-place update happened concurrently.
+ * They are lock-free, but not wait-free: they never take a lock and never
+ * block the writer of in-place updates, but retry without bound while such
+ * updates keep coming.
+ *
+ * @param T the generated zerobuf type
+ */
+template <class T>
+class SharedZerobuf
+{
+public:
+    /** Construct a shared zerobuf publishing a default-constructed T. */
+    SharedZerobuf()
+        : SharedZerobuf(T())
+    {
+    }
+
+    /** Construct a shared zerobuf publishing the given value. */
+    explicit SharedZerobuf(const T& value)
+        : _active(0)
+        , _version(0)
+    {
+        publish(value);
+    }
+
+    /**
+     * Publish a new value. Must only be called from one thread at a time.
+     *
+     * @param value the new value to publish
+     */
+    void publish(const T& value)
+    {
+        const Data& data = value.toBinary();
+        const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data.ptr.get());
+        const unsigned active = _active.load(std::memory_order_relaxed);
+        Slot& current = _slots[active];
+        const size_t staticSize = value.getZerobufStaticSize();
+        const size_t headerSize = 4 + 16 * value.getZerobufNumDynamics();
+
+        if (_version > 0 &&
+            _hasSameDynamics(current, ptr, data.size, staticSize, headerSize))
+        {
+            // in-place update of the static members under sequence lock
+            current.sequence.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            ::memcpy(current.data(), ptr, 4); // version
+            ::memcpy(current.data() + headerSize, ptr + headerSize,
+                     staticSize - headerSize);
+            current.sequence.fetch_add(1, std::memory_order_release);
+        }
+        else
+        {
+            // double buffer: wait for readers to leave the inactive slot. The
+            // seq_cst accesses to _active and readers order the store of
+            // _active before this load against the increment of readers
+            // before the reload of _active in read().
+            Slot& next = _slots[1 - active];
+            while (next.readers.load(std::memory_order_seq_cst) > 0)
+                std::this_thread::yield();
+
+            next.sequence.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            next.resize(data.size);
+            ::memcpy(next.data(), ptr, data.size);
+            next.sequence.fetch_add(1, std::memory_order_release);
+            _active.store(1 - active, std::memory_order_seq_cst);
+        }
+        _version.fetch_add(1, std::memory_order_release);
+    }
+
+    /**
+     * Call the given function with a consistent, read-only view on the last
+     * published value.
+     *
+     * The function may be called more than once if the value is updated
+     * concurrently. The view is validated before each call, but static members
+     * may be modified during all but the last call. The function must
+     * therefore only read or copy from the view, and must not keep references
+     * to it.
+     *
+     * @param func the function to call with a const T&
+     */
+    template <class F>
+    void read(const F& func) const
+    {
+        for (;;)
+        {
+            const unsigned active = _active.load(std::memory_order_seq_cst);
+            const Slot& slot = _slots[active];
+            slot.readers.fetch_add(1, std::memory_order_seq_cst);
+            const uint64_t sequence =
+                slot.sequence.load(std::memory_order_acquire);
+
+            if ((sequence & 1) ||
+                _active.load(std::memory_order_seq_cst) != active)
+            {
+                slot.readers.fetch_sub(1, std::memory_order_release);
+                continue;
+            }
+
+            bool valid = true;
+            try
+            {
+                ConstAllocator allocator(slot.data(), slot.size);
+                const T view(AllocatorPtr(&allocator, AllocatorDeleter(false)));
+
+                // don't call user code on data modified during the setup
+                if (_isValid(slot, sequence))
+                    func(view);
+                else
+                    valid = false;
+            }
+            catch (...)
+            {
+                // inconsistent data may fail the allocator checks
+                if (_isValid(slot, sequence))
+                {
+                    slot.readers.fetch_sub(1, std::memory_order_release);
+                    throw;
+                }
+                valid = false;
+            }
+
+            valid = valid && _isValid(slot, sequence);
+            slot.readers.fetch_sub(1, std::memory_order_release);
+            if (valid)
+                return;
+        }
+    }
+
+    /** @return a copy of the last published value. */
+    T get() const
+    {
+        T copy;
+        read([&copy](const T& value) { copy = value; });
+        return copy;
+    }
+
+    /** @return the number of values published so far. */
+    uint64_t getVersion() const
+    {
+        return _version.load(std::memory_order_acquire);
+    }
+
+private:
+    SharedZerobuf(const SharedZerobuf&) = delete;
+    SharedZerobuf& operator=(const SharedZerobuf&) = delete;
+
+    struct Slot
+    {
+        Slot()
+            : readers(0)
+            , sequence(0)
+            , size(0)
+        {
+        }
+
+        uint8_t* data() { return reinterpret_cast<uint8_t*>(buffer.data()); }
+        const uint8_t* data() const
+        {
+            return reinterpret_cast<const uint8_t*>(buffer.data());
+        }
+        void resize(const size_t newSize)
+        {
+            buffer.resize((newSize + 7) / 8); // 8 byte aligned storage
+            size = newSize;
+        }
+
+        mutable std::atomic<uint32_t> readers;
+        std::atomic<uint64_t> sequence; // odd while being written
+        std::vector<uint64_t> buffer;
+        size_t size;
+    };
+
+    Slot _slots[2];
+    std::atomic<unsigned> _active;
+    std::atomic<uint64_t> _version;
+
+    /** @return true if the update only changes static members of the slot. */
+    static bool _hasSameDynamics(const Slot& slot, const uint8_t* data,
+                                 const size_t size, const size_t staticSize,
+                                 const size_t headerSize)
+    {
+        // the dynamic data is only compared if the layout is unchanged
+        if (size != slot.size ||
+            ::memcmp(slot.data() + 4, data + 4, headerSize - 4) != 0)
+        {
+            return false;
+        }
+        return ::memcmp(slot.data() + staticSize, data + staticSize,
+                        size - staticSize) == 0;
+    }
+
+    static bool _isValid(const Slot& slot, const uint64_t sequence)
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == sequence;
+    }
+};
+}
+
+#endif
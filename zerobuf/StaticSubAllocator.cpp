@@ -15,7 +15,7 @@ template <class A>
 StaticSubAllocatorBase<A>::StaticSubAllocatorBase(A& parent,
                                                   const size_t offset,
                                                   const size_t size)
-    : _parent(parent)
+    : _parent(&parent)
     , _offset(offset)
     , _size(size)
 {
@@ -29,7 +29,7 @@ StaticSubAllocatorBase<A>::~StaticSubAllocatorBase()
 template <class A>
 uint8_t* StaticSubAllocatorBase<A>::getData()
 {
-    return _parent.getData() + _offset;
+    return _parent->getData() + _offset;
 }
 
 template <>
@@ -41,7 +41,7 @@ uint8_t* StaticSubAllocatorBase<const Allocator>::getData()
 template <class A>
 const uint8_t* StaticSubAllocatorBase<A>::getData() const
 {
-    return const_cast<const A&>(_parent).getData() + _offset;
+    return const_cast<const A&>(*_parent).getData() + _offset;
 }
 
 template <class A>
@@ -23,9 +23,12 @@ public:
     ZEROBUF_API const uint8_t* getData() const final;
     size_t getSize() const final { return _size; }
     ZEROBUF_API void copyBuffer(const void* data, size_t size) final;
-    bool isMutable() const final { return _parent.isMutable(); }
+    bool isMutable() const final { return _parent->isMutable(); }
+    bool isMaterialized() const final { return _parent->isMaterialized(); }
+    /** Rebind to a new parent, used by generated classes after a move. */
+    void reset(A& parent) { _parent = &parent; }
 private:
-    A& _parent;
+    A* _parent;
     const size_t _offset;
     const size_t _size;
 
@@ -0,0 +1,133 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEROBUF_STRINGVIEW_H
+#define ZEROBUF_STRINGVIEW_H
+
+#include <zerobuf/types.h>
+
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace zerobuf
+{
+#if __cplusplus >= 201703L
+/** A non-owning, read-only view on a string; std::string_view if available. */
+typedef std::string_view StringView;
+#else
+/**
+ * A non-owning, read-only view on a string.
+ *
+ * Implements the commonly used subset of C++17's std::string_view, which is
+ * used instead when available. The viewed string does not need to be
+ * null-terminated.
+ */
+class StringView
+{
+public:
+    typedef char value_type;
+    typedef const char* const_iterator;
+    typedef const char* iterator;
+    static const size_t npos = size_t(-1);
+
+    /** Construct an empty view. */
+    StringView()
+        : _data(nullptr)
+        , _size(0)
+    {
+    }
+
+    /** Construct a view on size characters at data. */
+    StringView(const char* data_, const size_t size_)
+        : _data(data_)
+        , _size(size_)
+    {
+    }
+
+    /** Construct a view on a null-terminated string. */
+    StringView(const char* string)
+        : _data(string)
+        , _size(::strlen(string))
+    {
+    }
+
+    /** Construct a view on a std::string. */
+    StringView(const std::string& string)
+        : _data(string.data())
+        , _size(string.size())
+    {
+    }
+
+    /** @return a copy of the viewed characters. */
+    explicit operator std::string() const { return std::string(_data, _size); }
+
+    /** @return the pointer to the first character, not null-terminated. */
+    const char* data() const { return _data; }
+    /** @return the number of characters in the view. */
+    size_t size() const { return _size; }
+    /** @return the number of characters in the view. */
+    size_t length() const { return _size; }
+    /** @return true if the view contains no characters. */
+    bool empty() const { return _size == 0; }
+    /** @return an iterator to the first character. */
+    const_iterator begin() const { return _data; }
+    /** @return an iterator to the past-the-end character. */
+    const_iterator end() const { return _data + _size; }
+    /** @return the character at the given index, unchecked. */
+    char operator[](const size_t index) const { return _data[index]; }
+
+    /** @return a view on count characters starting at pos. */
+    StringView substr(const size_t pos, size_t count = npos) const
+    {
+        if (pos > _size)
+            throw std::out_of_range("StringView::substr position out of range");
+        if (count > _size - pos)
+            count = _size - pos;
+        return StringView(_data + pos, count);
+    }
+
+    /** @return <0, 0 or >0 if this view sorts before, equal or after rhs. */
+    int compare(const StringView& rhs) const
+    {
+        const size_t size_ = _size < rhs._size ? _size : rhs._size;
+        const int result = size_ > 0 ? ::memcmp(_data, rhs._data, size_) : 0;
+        if (result != 0)
+            return result;
+        return _size < rhs._size ? -1 : (_size > rhs._size ? 1 : 0);
+    }
+
+private:
+    const char* _data;
+    size_t _size;
+};
+
+inline bool operator==(const StringView& lhs, const StringView& rhs)
+{
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+inline bool operator!=(const StringView& lhs, const StringView& rhs)
+{
+    return !(lhs == rhs);
+}
+
+inline bool operator<(const StringView& lhs, const StringView& rhs)
+{
+    return lhs.compare(rhs) < 0;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const StringView& string)
+{
+    return os.write(string.data(), string.size());
+}
+#endif
+}
+
+#endif
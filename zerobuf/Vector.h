@@ -8,14 +8,32 @@
 
 #include <zerobuf/DynamicSubAllocator.h> // used inline
 #include <zerobuf/Zerobuf.h>             // sfinae type
+#include <zerobuf/columns.h>             // used inline
 #include <zerobuf/json.h>                // used inline
 
+#include <algorithm> // std::sort
 #include <cstring>   // memcmp
+#include <memory>    // std::unique_ptr
 #include <stdexcept> // std::runtime_error
 #include <typeinfo>  // typeid
+#include <utility>   // std::pair
+#include <vector>    // member
 
 namespace zerobuf
 {
+/** @internal Receives the changes made through the methods of a Vector. */
+class VectorObserver
+{
+public:
+    virtual ~VectorObserver() {}
+
+    /**
+     * Called after the elements starting at first have changed, including a
+     * change of the vector size.
+     */
+    virtual void notifyVectorChanged(size_t first) = 0;
+};
+
 /**
  * STL-like vector abstraction for dynamic arrays in a zerobuf.
  *
@@ -144,11 +162,75 @@ public:
     void push_back(const typename std::enable_if<
                    std::is_base_of<Zerobuf, Q>::value, Q>::type&);
 
+    /**
+     * Copy one field of all Zerobuf elements into a contiguous column.
+     *
+     * @param offset the byte offset of the field in an element
+     * @param column output array for size() values
+     */
+    template <class F, class Q = T>
+    void gather(size_t offset, F* column,
+                const typename std::enable_if<
+                    std::is_base_of<Zerobuf, Q>::value, Q>::type* = nullptr)
+        const;
+
+    /**
+     * Copy a contiguous column into one field of all Zerobuf elements.
+     *
+     * @param offset the byte offset of the field in an element
+     * @param column input array of size() values
+     */
+    template <class F, class Q = T>
+    void scatter(size_t offset, const F* column,
+                 const typename std::enable_if<
+                     std::is_base_of<Zerobuf, Q>::value, Q>::type* = nullptr);
+
+    /**
+     * Sort the Zerobuf elements by a key field, keeping the order of elements
+     * with equal keys.
+     *
+     * @param offset the byte offset of the key field in an element
+     */
+    template <class F, class Q = T>
+    void sortBy(size_t offset,
+                const typename std::enable_if<
+                    std::is_base_of<Zerobuf, Q>::value, Q>::type* = nullptr);
+
+    /**
+     * Find a Zerobuf element by a key field using a binary search over the
+     * element storage. The vector has to be sorted by the key field.
+     *
+     * @param offset the byte offset of the key field in an element
+     * @param key the key to look up
+     * @return the index of the first element with the key, or size() if no
+     *         element has the key.
+     */
+    template <class F, class Q = T>
+    size_t findSorted(size_t offset, const F& key,
+                      const typename std::enable_if<
+                          std::is_base_of<Zerobuf, Q>::value, Q>::type* =
+                          nullptr) const;
+
+    /**
+     * Insert a Zerobuf element after all elements with a smaller or equal key,
+     * keeping a vector sorted by the key field sorted.
+     *
+     * @param offset the byte offset of the key field in an element
+     * @param value the element to insert
+     * @return the index of the inserted element.
+     */
+    template <class F, class Q = T>
+    size_t insertSorted(
+        size_t offset,
+        const typename std::enable_if<std::is_base_of<Zerobuf, Q>::value,
+                                      Q>::type& value);
+
     /** @internal */
     void reset(Allocator& alloc)
     {
         _alloc = &alloc;
         _zerobufs.clear();
+        _notifyChanged(0);
     }
 
     /** Remove unused memory from vector and all members. */
@@ -221,6 +303,10 @@ private:
     Allocator* _alloc;
     const size_t _index;
     mutable std::vector<T> _zerobufs;
+    mutable VectorObserver* _observer; // the VectorIndex of this vector
+
+    template <class, class>
+    friend class VectorIndex;
 
     Vector() = delete;
     Vector(const Vector& rhs) = delete;
@@ -228,6 +314,24 @@ private:
 
     size_t _getSize() const { return _alloc->getDynamicSize(_index); }
     void copyBuffer(uint8_t* data, size_t size);
+    void _notifyChanged(const size_t first)
+    {
+        if (_observer)
+            _observer->notifyVectorChanged(first);
+    }
+
+    template <class F>
+    static F _loadField(const uint8_t* ptr)
+    {
+        F value; // elements are not aligned
+        ::memcpy(&value, ptr, sizeof(F));
+        return value;
+    }
+
+    template <class F>
+    size_t _lowerBound(size_t offset, const F& key) const;
+    template <class F>
+    size_t _upperBound(size_t offset, const F& key) const;
 
     template <class Q = T>
     size_t _getElementSize(
@@ -251,6 +355,7 @@ template <class T>
 inline Vector<T>::Vector(Allocator& alloc, const size_t index)
     : _alloc(&alloc)
     , _index(index)
+    , _observer(nullptr)
 {
 }
 
@@ -259,13 +364,16 @@ inline void Vector<T>::clear()
 {
     _alloc->updateAllocation(_index, false, 0);
     _zerobufs.clear();
+    _notifyChanged(0);
 }
 
 template <class T>
 inline void Vector<T>::resize(const size_t size_)
 {
+    const size_t oldSize = size();
     _alloc->updateAllocation(_index, true /*copy*/,
                              size_ * _getElementSize<T>());
+    _notifyChanged(std::min(oldSize, size_));
 }
 
 template <class T>
@@ -379,6 +487,7 @@ inline void Vector<T>::push_back(
     T* newPtr = reinterpret_cast<T*>(
         _alloc->updateAllocation(_index, true /*copy*/, size_ + sizeof(T)));
     newPtr[size_ / _getElementSize<T>()] = value;
+    _notifyChanged(size_ / _getElementSize<T>());
 }
 
 template <class T>
@@ -392,6 +501,162 @@ inline void Vector<T>::push_back(
     uint8_t* newPtr =
         _alloc->updateAllocation(_index, true /*copy*/, size_ + zerobuf.size);
     ::memcpy(newPtr + size_, zerobuf.ptr.get(), zerobuf.size);
+    _notifyChanged(size_ / _getElementSize<T>());
+}
+
+template <class T>
+template <class F, class Q>
+inline void Vector<T>::gather(
+    const size_t offset, F* column,
+    const typename std::enable_if<std::is_base_of<Zerobuf, Q>::value, Q>::type*)
+    const
+{
+    const size_t size_ = size();
+    if (size_ == 0)
+        return;
+    if (offset + sizeof(F) > _getElementSize<T>())
+        throw std::runtime_error("Column field exceeds element size");
+
+    const Allocator* alloc = _alloc;
+    gatherColumn(alloc->template getDynamic<uint8_t>(_index) + offset,
+                 _getElementSize<T>(), sizeof(F), size_, column);
+}
+
+template <class T>
+template <class F, class Q>
+inline void Vector<T>::scatter(
+    const size_t offset, const F* column,
+    const typename std::enable_if<std::is_base_of<Zerobuf, Q>::value, Q>::type*)
+{
+    const size_t size_ = size();
+    if (size_ == 0)
+        return;
+    if (offset + sizeof(F) > _getElementSize<T>())
+        throw std::runtime_error("Column field exceeds element size");
+
+    scatterColumn(column, sizeof(F), size_,
+                  _alloc->template getDynamic<uint8_t>(_index) + offset,
+                  _getElementSize<T>());
+    _notifyChanged(0);
+}
+
+template <class T>
+template <class F, class Q>
+inline void Vector<T>::sortBy(
+    const size_t offset,
+    const typename std::enable_if<std::is_base_of<Zerobuf, Q>::value, Q>::type*)
+{
+    const size_t size_ = size();
+    const size_t stride = _getElementSize<T>();
+    if (offset + sizeof(F) > stride)
+        throw std::runtime_error("Key field exceeds element size");
+
+    uint8_t* data = _alloc->template getDynamic<uint8_t>(_index);
+    std::vector<std::pair<F, size_t>> keys; // the index keeps the order
+    keys.reserve(size_);
+    for (size_t i = 0; i < size_; ++i)
+        keys.emplace_back(_loadField<F>(data + i * stride + offset), i);
+    if (std::is_sorted(keys.begin(), keys.end()))
+        return;
+    std::sort(keys.begin(), keys.end());
+
+    std::unique_ptr<uint8_t[]> sorted(new uint8_t[size_ * stride]);
+    for (size_t i = 0; i < size_; ++i)
+        ::memcpy(sorted.get() + i * stride, data + keys[i].second * stride,
+                 stride);
+    ::memcpy(data, sorted.get(), size_ * stride);
+    _notifyChanged(0);
+}
+
+template <class T>
+template <class F, class Q>
+inline size_t Vector<T>::findSorted(
+    const size_t offset, const F& key,
+    const typename std::enable_if<std::is_base_of<Zerobuf, Q>::value, Q>::type*)
+    const
+{
+    const size_t size_ = size();
+    const size_t stride = _getElementSize<T>();
+    if (offset + sizeof(F) > stride)
+        throw std::runtime_error("Key field exceeds element size");
+
+    const size_t index = _lowerBound(offset, key);
+    const Allocator* alloc = _alloc;
+    const uint8_t* data = alloc->template getDynamic<uint8_t>(_index) + offset;
+    if (index < size_ && !(key < _loadField<F>(data + index * stride)))
+        return index;
+    return size_;
+}
+
+template <class T>
+template <class F, class Q>
+inline size_t Vector<T>::insertSorted(
+    const size_t offset,
+    const typename std::enable_if<std::is_base_of<Zerobuf, Q>::value, Q>::type&
+        value)
+{
+    const size_t stride = _getElementSize<T>();
+    if (offset + sizeof(F) > stride)
+        throw std::runtime_error("Key field exceeds element size");
+
+    const zerobuf::Data& zerobuf = value.toBinary();
+    const uint8_t* element = static_cast<const uint8_t*>(zerobuf.ptr.get());
+    const size_t index = _upperBound(offset, _loadField<F>(element + offset));
+
+    const size_t size_ = _getSize();
+    uint8_t* newPtr =
+        _alloc->updateAllocation(_index, true /*copy*/, size_ + stride);
+    ::memmove(newPtr + (index + 1) * stride, newPtr + index * stride,
+              size_ - index * stride);
+    ::memcpy(newPtr + index * stride, element, stride);
+    _notifyChanged(index);
+    return index;
+}
+
+template <class T>
+template <class F>
+inline size_t Vector<T>::_lowerBound(const size_t offset, const F& key) const
+{
+    const size_t stride = _getElementSize<T>();
+    const Allocator* alloc = _alloc;
+    const uint8_t* data = alloc->template getDynamic<uint8_t>(_index) + offset;
+    size_t first = 0;
+    size_t count = size();
+    while (count > 0)
+    {
+        const size_t step = count / 2;
+        if (_loadField<F>(data + (first + step) * stride) < key)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+            count = step;
+    }
+    return first;
+}
+
+template <class T>
+template <class F>
+inline size_t Vector<T>::_upperBound(const size_t offset, const F& key) const
+{
+    const size_t stride = _getElementSize<T>();
+    const Allocator* alloc = _alloc;
+    const uint8_t* data = alloc->template getDynamic<uint8_t>(_index) + offset;
+    size_t first = 0;
+    size_t count = size();
+    while (count > 0)
+    {
+        const size_t step = count / 2;
+        if (!(key < _loadField<F>(data + (first + step) * stride)))
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+            count = step;
+    }
+    return first;
 }
 
 template <class T>
@@ -404,6 +669,7 @@ inline void Vector<T>::fromJSON(
     _alloc->updateAllocation(_index, false, size_ * _getElementSize<T>());
     for (size_t i = 0; i < size_; ++i)
         zerobuf::fromJSON(getJSONField(json, i), (*this)[i]);
+    _notifyChanged(0);
 }
 
 template <class T>
@@ -417,8 +683,8 @@ inline void Vector<T>::fromJSON(
         _alloc->updateAllocation(_index, false /*no copy*/, size_ * sizeof(T)));
 
     for (size_t i = 0; i < size_; ++i)
-        array[i] = string_to_enum<T>(
-            zerobuf::fromJSON<std::string>(getJSONField(json, i)));
+        array[i] = enumFromJSON<T>(getJSONField(json, i));
+    _notifyChanged(0);
 }
 
 template <class T>
@@ -433,6 +699,7 @@ inline void Vector<T>::fromJSON(
 
     for (size_t i = 0; i < size_; ++i)
         array[i] = zerobuf::fromJSON<T>(getJSONField(json, i));
+    _notifyChanged(0);
 }
 
 template <class T>
@@ -448,6 +715,7 @@ inline void Vector<T>::fromJSON(
 
     for (size_t i = 0; i < size_; ++i)
         array[i] = zerobuf::fromJSON<T>(getJSONField(json, i));
+    _notifyChanged(0);
 }
 
 template <class T>
@@ -529,6 +797,7 @@ inline void Vector<T>::copyBuffer(uint8_t* data_, size_t size_)
 {
     void* to = _alloc->updateAllocation(_index, false /*no copy*/, size_);
     ::memcpy(to, data_, size_);
+    _notifyChanged(0);
 }
 
 template <class T>
@@ -540,7 +809,7 @@ inline std::ostream& operator<<(std::ostream& os, const Vector<T>& vector)
 template <>
 inline std::ostream& operator<<(std::ostream& os, const Vector<char>& string)
 {
-    return os << string.data();
+    return os.write(string.data(), string.size());
 }
 }
 
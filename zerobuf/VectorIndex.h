@@ -0,0 +1,462 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEROBUF_VECTORINDEX_H
+#define ZEROBUF_VECTORINDEX_H
+
+#include <zerobuf/Vector.h> // member
+
+#include <algorithm>   // std::min
+#include <cstdint>
+#include <cstring>     // memcpy
+#include <functional>  // std::hash
+#include <limits>      // std::numeric_limits
+#include <stdexcept>   // std::runtime_error
+#include <type_traits> // std::enable_if
+#include <utility>     // std::pair
+#include <vector>      // member
+
+namespace zerobuf
+{
+/**
+ * Key functor reading a scalar field from the storage of a vector element.
+ *
+ * Generated tables declare one for each scalar member, e.g.,
+ * Table::IntvalueField.
+ *
+ * @param F the type of the field
+ * @param offset the byte offset of the field in an element
+ */
+template <class F, size_t offset>
+struct FieldKey
+{
+    typedef F value_type;
+
+    F operator()(const uint8_t* element) const
+    {
+        F value; // elements are not aligned
+        ::memcpy(&value, element + offset, sizeof(F));
+        return value;
+    }
+};
+
+/** Key functor combining the keys of two other key functors into a pair. */
+template <class K1, class K2>
+struct PairKey
+{
+    typedef std::pair<typename K1::value_type, typename K2::value_type>
+        value_type;
+
+    value_type operator()(const uint8_t* element) const
+    {
+        return value_type(K1()(element), K2()(element));
+    }
+};
+
+/** @cond IGNORE hash mixing functions of the VectorIndex */
+namespace detail
+{
+inline uint32_t mixHash(uint32_t hash)
+{
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    return hash ^ (hash >> 16);
+}
+
+inline uint32_t mixHash(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    return uint32_t(hash ^ (hash >> 32));
+}
+}
+/** @endcond */
+
+/**
+ * The hash function of the VectorIndex for a key type.
+ *
+ * Scalar keys use branch-free integer mixing, which allows the compiler to
+ * vectorize the hashing of all keys in VectorIndex::rebuild(). Other keys
+ * use std::hash; specialize this template for custom key types.
+ */
+template <class K, class Enable = void>
+struct KeyHash
+{
+    uint32_t operator()(const K& key) const
+    {
+        return detail::mixHash(uint64_t(std::hash<K>()(key)));
+    }
+};
+
+/** @cond IGNORE */
+template <class K>
+struct KeyHash<K, typename std::enable_if<(std::is_integral<K>::value ||
+                                           std::is_enum<K>::value) &&
+                                          sizeof(K) <= 4>::type>
+{
+    uint32_t operator()(const K& key) const
+    {
+        return detail::mixHash(uint32_t(key));
+    }
+};
+
+template <class K>
+struct KeyHash<K, typename std::enable_if<(std::is_integral<K>::value ||
+                                           std::is_enum<K>::value) &&
+                                          sizeof(K) == 8>::type>
+{
+    uint32_t operator()(const K& key) const
+    {
+        return detail::mixHash(uint64_t(key));
+    }
+};
+
+template <class A, class B>
+struct KeyHash<std::pair<A, B>>
+{
+    uint32_t operator()(const std::pair<A, B>& key) const
+    {
+        const uint32_t first = KeyHash<A>()(key.first);
+        return detail::mixHash(first * 0x9e3779b1u ^ KeyHash<B>()(key.second));
+    }
+};
+/** @endcond */
+
+/**
+ * Hash index over the elements of a Vector for lookups by key in constant
+ * time.
+ *
+ * The index is a side structure holding the positions of the elements in an
+ * open-addressing hash table; the keys are read from the element storage on
+ * lookup. It is maintained incrementally on changes through the methods of
+ * the vector, e.g., push_back(), resize(), insertSorted() or the generated
+ * scatter functions. Changes made through the elements, the setters of the
+ * owning object or by updating the owning object from binary or JSON need an
+ * explicit update() or rebuild(). Lookups detect a changed size and a
+ * replaced vector content, e.g., after assigning the owning object.
+ *
+ * A vector has at most one index, which must be destroyed before the vector.
+ * Not thread-safe.
+ *
+ * @param T the element type of the vector
+ * @param KeyFn the functor returning the key of the element at the given
+ *              storage, e.g., FieldKey or PairKey
+ */
+template <class T, class KeyFn = FieldKey<T, 0>>
+class VectorIndex : public VectorObserver
+{
+public:
+    typedef typename std::decay<decltype(std::declval<const KeyFn&>()(
+        std::declval<const uint8_t*>()))>::type key_type;
+
+    /**
+     * Construct and build the index of the given vector.
+     *
+     * @throw std::runtime_error if the vector already has an index.
+     */
+    explicit VectorIndex(const Vector<T>& vector, KeyFn keyFn = KeyFn())
+        : _vector(vector)
+        , _keyFn(keyFn)
+        , _mask(0)
+        , _count(0)
+        , _generation(0)
+    {
+        if (_vector._observer)
+            throw std::runtime_error("Vector already has an index");
+        rebuild();
+        _vector._observer = this;
+    }
+
+    /**
+     * Construct the index of the given vector from the binary written by
+     * toBinary(), or build it if the binary does not match the vector.
+     *
+     * @throw std::runtime_error if the vector already has an index.
+     */
+    VectorIndex(const Vector<T>& vector, const void* data, const size_t size,
+                KeyFn keyFn = KeyFn())
+        : _vector(vector)
+        , _keyFn(keyFn)
+        , _mask(0)
+        , _count(0)
+        , _generation(0)
+    {
+        if (_vector._observer)
+            throw std::runtime_error("Vector already has an index");
+        if (!fromBinary(data, size))
+            rebuild();
+        _vector._observer = this;
+    }
+
+    ~VectorIndex() { _vector._observer = nullptr; }
+
+    /**
+     * Find an element by key.
+     *
+     * @return the index of an element with the key, or vector.size() if no
+     *         element has the key.
+     * @throw std::runtime_error if the vector was resized or replaced
+     *        without updating the index.
+     */
+    size_t find(const key_type& key) const
+    {
+        const size_t size = _vector.size();
+        if (size != _slotOf.size() || _getGeneration() != _generation)
+            throw std::runtime_error("Vector changed without updating index");
+        if (size == 0)
+            return size;
+
+        const uint8_t* data = _getData();
+        const size_t stride = _vector._getElementSize();
+        const uint32_t hash = KeyHash<key_type>()(key);
+        for (size_t slot = hash & _mask;; slot = (slot + 1) & _mask)
+        {
+            const Slot& entry = _slots[slot];
+            if (entry.position == 0)
+                return size;
+            if (entry.hash == hash &&
+                _keyFn(data + (entry.position - 1) * stride) == key)
+            {
+                return entry.position - 1;
+            }
+        }
+    }
+
+    /**
+     * Build the index of all elements in bulk.
+     *
+     * All keys are read first and then hashed in one pass, which the compiler
+     * vectorizes for scalar keys.
+     */
+    void rebuild()
+    {
+        const size_t size = _vector.size();
+        if (size >= std::numeric_limits<uint32_t>::max())
+            throw std::runtime_error("Vector too large for an index");
+
+        _allocate(size);
+        _slotOf.resize(size);
+        _generation = _getGeneration();
+        const uint8_t* data = _getData();
+        const size_t stride = _vector._getElementSize();
+        std::vector<key_type> keys(size);
+        for (size_t i = 0; i < size; ++i)
+            keys[i] = _keyFn(data + i * stride);
+
+        std::vector<uint32_t> hashes(size);
+        const KeyHash<key_type> hashFn;
+        for (size_t i = 0; i < size; ++i)
+            hashes[i] = hashFn(keys[i]);
+
+        for (size_t i = 0; i < size; ++i)
+            _insert(hashes[i], i);
+    }
+
+    /**
+     * Update the index after the element at the given index was modified in
+     * place.
+     */
+    void update(const size_t index)
+    {
+        if (index >= _slotOf.size() || _slotOf.size() != _vector.size() ||
+            _getGeneration() != _generation)
+        {
+            rebuild();
+            return;
+        }
+        _erase(_slotOf[index]);
+        _insert(_hashAt(index), index);
+    }
+
+    /** @return the number of indexed elements. */
+    size_t size() const { return _slotOf.size(); }
+
+    /**
+     * Write the index to be stored or sent next to the vector.
+     *
+     * @param out replaced by the binary of the index, may be reused between
+     *            calls to avoid allocations.
+     */
+    void toBinary(std::vector<uint8_t>& out) const
+    {
+        const uint64_t header[2] = {_slotOf.size(), _slots.size()};
+        out.resize(sizeof(header) + _slots.size() * sizeof(Slot));
+        ::memcpy(out.data(), header, sizeof(header));
+        if (!_slots.empty())
+            ::memcpy(out.data() + sizeof(header), _slots.data(),
+                     _slots.size() * sizeof(Slot));
+    }
+
+    /**
+     * Load the index from the binary written by toBinary() for the current
+     * content of the vector, instead of rebuilding it.
+     *
+     * Only the structure of the binary is validated, not the keys; the index
+     * has to be written for the same vector content and key functor.
+     *
+     * @return true on success, false if the binary is invalid or was written
+     *         for a vector of a different size. The index is unchanged on
+     *         failure.
+     */
+    bool fromBinary(const void* data, const size_t size)
+    {
+        uint64_t header[2]; // number of elements, capacity
+        if (size < sizeof(header))
+            return false;
+        ::memcpy(header, data, sizeof(header));
+
+        const uint64_t numElements = header[0];
+        const uint64_t capacity = header[1];
+        if (numElements != _vector.size() || capacity < 2 * numElements ||
+            (capacity & (capacity - 1)) != 0 ||
+            (size - sizeof(header)) % sizeof(Slot) != 0 ||
+            (size - sizeof(header)) / sizeof(Slot) != capacity)
+        {
+            return false;
+        }
+
+        std::vector<Slot> table(capacity);
+        if (capacity > 0)
+            ::memcpy(table.data(), static_cast<const uint8_t*>(data) +
+                                       sizeof(header),
+                     capacity * sizeof(Slot));
+
+        const uint32_t unused = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> slotOf(numElements, unused);
+        size_t count = 0;
+        for (size_t slot = 0; slot < capacity; ++slot)
+        {
+            const uint32_t position = table[slot].position;
+            if (position == 0)
+                continue;
+            if (position > numElements || slotOf[position - 1] != unused)
+                return false;
+            slotOf[position - 1] = uint32_t(slot);
+            ++count;
+        }
+        if (count != numElements)
+            return false;
+
+        _slots.swap(table);
+        _slotOf.swap(slotOf);
+        _generation = _getGeneration();
+        _mask = capacity > 0 ? capacity - 1 : 0;
+        _count = count;
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        uint32_t hash;
+        uint32_t position; // element index + 1, 0 if empty
+    };
+
+    const Vector<T>& _vector;
+    const KeyFn _keyFn;
+    std::vector<Slot> _slots;      // capacity is a power of two
+    std::vector<uint32_t> _slotOf; // slot of each indexed element
+    size_t _mask;
+    size_t _count;      // number of used slots
+    size_t _generation; // of the vector allocator when last indexed
+
+    VectorIndex(const VectorIndex&) = delete;
+    VectorIndex& operator=(const VectorIndex&) = delete;
+
+    void notifyVectorChanged(const size_t first) final
+    {
+        const size_t oldSize = _slotOf.size();
+        const size_t size = _vector.size();
+        const size_t begin = std::min(first, std::min(oldSize, size));
+        // re-indexing more than half of the elements is faster in bulk
+        if (begin == 0 || (oldSize - begin) + (size - begin) > size / 2 ||
+            _getGeneration() != _generation)
+        {
+            rebuild();
+            return;
+        }
+
+        for (size_t i = oldSize; i > begin; --i)
+            _erase(_slotOf[i - 1]);
+        _slotOf.resize(size);
+        for (size_t i = begin; i < size; ++i)
+        {
+            if (2 * (_count + 1) > _slots.size())
+                _grow();
+            _insert(_hashAt(i), i);
+        }
+    }
+
+    size_t _getGeneration() const { return _vector._alloc->getGeneration(); }
+
+    const uint8_t* _getData() const
+    {
+        return reinterpret_cast<const uint8_t*>(_vector.data());
+    }
+
+    uint32_t _hashAt(const size_t index) const
+    {
+        const uint8_t* element =
+            _getData() + index * _vector._getElementSize();
+        return KeyHash<key_type>()(_keyFn(element));
+    }
+
+    // keeps the load factor at or below one half
+    void _allocate(const size_t size)
+    {
+        size_t capacity = 16;
+        while (capacity < 2 * size)
+            capacity *= 2;
+        _slots.assign(capacity, Slot{0, 0});
+        _mask = capacity - 1;
+        _count = 0;
+    }
+
+    void _grow()
+    {
+        std::vector<Slot> table;
+        table.swap(_slots);
+        _allocate(table.size()); // doubles the capacity
+        for (const Slot& slot : table)
+            if (slot.position != 0)
+                _insert(slot.hash, slot.position - 1);
+    }
+
+    void _insert(const uint32_t hash, const size_t index)
+    {
+        size_t slot = hash & _mask;
+        while (_slots[slot].position != 0)
+            slot = (slot + 1) & _mask;
+        _slots[slot] = Slot{hash, uint32_t(index + 1)};
+        _slotOf[index] = uint32_t(slot);
+        ++_count;
+    }
+
+    // removes the entry of a slot, moving the following entries of its probe
+    // sequence back instead of leaving a tombstone
+    void _erase(size_t hole)
+    {
+        for (size_t next = (hole + 1) & _mask; _slots[next].position != 0;
+             next = (next + 1) & _mask)
+        {
+            const size_t home = _slots[next].hash & _mask;
+            if (((next - home) & _mask) >= ((next - hole) & _mask))
+            {
+                _slots[hole] = _slots[next];
+                _slotOf[_slots[hole].position - 1] = uint32_t(hole);
+                hole = next;
+            }
+        }
+        _slots[hole] = Slot{0, 0};
+        --_count;
+    }
+};
+}
+
+#endif
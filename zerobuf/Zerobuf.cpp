@@ -5,17 +5,66 @@
 
 #include "Zerobuf.h"
 
+#include "ConstAllocator.h"
 #include "NonMovingAllocator.h"
 #include "NonMovingSubAllocator.h"
 #include "StaticSubAllocator.h"
 #include "jsoncpp/json/json.h"
 #include <zerobuf/version.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 
 namespace zerobuf
 {
+namespace
+{
+const uint8_t _zeros[4096] = {};
+
+void _appendPadding(std::vector<DynamicRange>& segments, size_t size)
+{
+    while (size > 0)
+    {
+        const size_t chunk = std::min(size, sizeof(_zeros));
+        segments.push_back(DynamicRange{_zeros, chunk});
+        size -= chunk;
+    }
+}
+
+uint64_t _align(const uint64_t offset, const size_t alignment)
+{
+    return (offset + alignment - 1) & ~uint64_t(alignment - 1);
+}
+
+bool _isZero(const uint8_t* data, const size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        if (data[i] != 0)
+            return false;
+    return true;
+}
+
+bool _checkVersion(const void* data, const size_t size)
+{
+    if (size < 4)
+    {
+        std::cerr << "zerobuf too small" << std::endl;
+        return false;
+    }
+
+    const uint32_t version = *reinterpret_cast<const uint32_t*>(data);
+    if (version != ZEROBUF_VERSION_ABI)
+    {
+        std::cerr << "Version mismatch, got zerobuf v" << version
+                  << " running v" << ZEROBUF_VERSION_ABI << std::endl;
+        return false;
+    }
+    return true;
+}
+}
+
 Zerobuf::Zerobuf(AllocatorPtr alloc)
     : _allocator(std::move(alloc))
 {
@@ -27,19 +76,62 @@ Zerobuf::Zerobuf(AllocatorPtr alloc)
     }
 }
 
+Zerobuf::Zerobuf(const uint8_t* image, const size_t staticSize,
+                 const size_t numDynamic, const size_t alignment)
+{
+    _storage.reset(image, staticSize, numDynamic, alignment);
+    _useStorage();
+}
+
+Zerobuf::Zerobuf(const uint8_t* image, const DynamicRange* dynamics,
+                 const size_t staticSize, const size_t numDynamic,
+                 const size_t alignment)
+{
+    _storage.reset(image, dynamics, staticSize, numDynamic, alignment);
+    _useStorage();
+}
+
+Zerobuf::Zerobuf(uint8_t* inlineData, const size_t inlineSize,
+                 const uint8_t* image, const size_t staticSize,
+                 const size_t numDynamic, const size_t alignment)
+    : _storage(inlineData, inlineSize)
+{
+    _storage.reset(image, staticSize, numDynamic, alignment);
+    _useStorage();
+}
+
 Zerobuf::Zerobuf(Zerobuf&& rhs)
 {
-    _allocator = std::move(rhs._allocator);
-    rhs._allocator.reset(new NonMovingAllocator(rhs.getZerobufStaticSize(),
-                                                rhs.getZerobufNumDynamics()));
-    uint32_t& version = rhs._allocator->getItem<uint32_t>(0);
-    version = ZEROBUF_VERSION_ABI;
+    _moveConstruct(rhs);
+}
+
+Zerobuf::Zerobuf(Zerobuf&& rhs, uint8_t* inlineData, const size_t inlineSize)
+    : _storage(inlineData, inlineSize)
+{
+    _moveConstruct(rhs);
 }
 
 Zerobuf::~Zerobuf()
 {
 }
 
+void Zerobuf::_moveConstruct(Zerobuf& rhs)
+{
+    if (!rhs._allocator)
+        return;
+
+    if (rhs.hasEmbeddedAllocator())
+    {
+        // embedded allocators stay with their parent - need to copy
+        _storage.reset(rhs.getZerobufStaticSize(), rhs.getZerobufNumDynamics(),
+                       rhs._allocator->getAlignment());
+        _useStorage();
+        _copyFrom(rhs);
+        return;
+    }
+    _moveFrom(rhs);
+}
+
 Zerobuf& Zerobuf::operator=(const Zerobuf& rhs)
 {
     if (this == &rhs || !_allocator || !rhs._allocator)
@@ -48,8 +140,7 @@ Zerobuf& Zerobuf::operator=(const Zerobuf& rhs)
     if (getTypeIdentifier() != rhs.getTypeIdentifier())
         throw std::runtime_error("Can't assign Zerobuf of a different type");
 
-    _allocator->copyBuffer(rhs._allocator->getData(),
-                           rhs._allocator->getSize());
+    _copyFrom(rhs);
     notifyChanged();
     return *this;
 }
@@ -63,41 +154,79 @@ Zerobuf& Zerobuf::operator=(Zerobuf&& rhs)
         throw std::runtime_error("Can't assign Zerobuf of a different type");
 
     if (_allocator->isMovable() && rhs._allocator->isMovable())
-        _allocator = std::move(rhs._allocator);
+        _moveFrom(rhs);
     else // Sub allocator data can't be moved - need to copy
-        _allocator->copyBuffer(rhs._allocator->getData(),
-                               rhs._allocator->getSize());
-
-    rhs._allocator.reset(new NonMovingAllocator(rhs.getZerobufStaticSize(),
-                                                rhs.getZerobufNumDynamics()));
+    {
+        _copyFrom(rhs);
+
+        // embedded allocators stay with their parent
+        if (!rhs.hasEmbeddedAllocator())
+        {
+            rhs._storage.reset(rhs.getZerobufStaticSize(),
+                               rhs.getZerobufNumDynamics(),
+                               rhs._allocator->getAlignment());
+            rhs._useStorage();
+        }
+    }
     notifyChanged();
     return *this;
 }
 
+bool Zerobuf::adoptBinary(uint8_t* data, const size_t size,
+                          BufferDeleter deleter)
+{
+    if (!_allocator)
+        throw std::runtime_error("Can't copy data into empty Zerobuf object");
+    if (!_allocator->isMutable())
+        throw std::runtime_error("Can't adopt data into read-only Zerobuf");
+    if (!_checkVersion(data, size))
+        return false;
+
+    // only the own storage takes over buffers, custom allocators are kept
+    if (_allocator.get() == &_storage &&
+        reinterpret_cast<uintptr_t>(data) % _storage.getAlignment() == 0)
+    {
+        _storage.getStorage().adopt(data, size, std::move(deleter));
+    }
+    else
+    {
+        // can't take over the buffer, copy and release it after success
+        if (size < getZerobufStaticSize())
+            throw std::runtime_error("Adopted zerobuf buffer is too small");
+        ConstAllocator(data, size).check(getZerobufNumDynamics());
+        _allocator->copyBuffer(data, size);
+        if (deleter)
+            deleter(data);
+        else
+            ::free(data);
+    }
+    notifyChanged();
+    return true;
+}
+
 void Zerobuf::compact(const float threshold)
 {
     if (_allocator && getZerobufNumDynamics() > 0)
         _allocator->compact(threshold);
 }
 
+void Zerobuf::setCompactionPolicy(const CompactionPolicy& policy)
+{
+    if (!_allocator)
+        return;
+    if (hasEmbeddedAllocator())
+        throw std::runtime_error(
+            "Compaction policy of embedded zerobufs is set by their parent");
+    _allocator->setCompactionPolicy(policy);
+}
+
 bool Zerobuf::_fromBinary(const void* data, const size_t size)
 {
     if (!_allocator)
         throw std::runtime_error("Can't copy data into empty Zerobuf object");
 
-    if (size < 4)
-    {
-        std::cerr << "zerobuf too small" << std::endl;
-        return false;
-    }
-
-    const uint32_t version = *reinterpret_cast<const uint32_t*>(data);
-    if (version != ZEROBUF_VERSION_ABI)
-    {
-        std::cerr << "Version mismatch, got zerobuf v" << version
-                  << " running v" << ZEROBUF_VERSION_ABI << std::endl;
+    if (!_checkVersion(data, size))
         return false;
-    }
 
     _allocator->copyBuffer(data, size);
     notifyChanged();
@@ -109,13 +238,184 @@ Data Zerobuf::_toBinary() const
     if (!_allocator)
         return Data();
 
+    _allocator->flushCompaction();
+    const Allocator& allocator = *_allocator; // may be a ConstAllocator
     Data data;
-    data.ptr =
-        std::shared_ptr<const void>(_allocator->getData(), [](const void*) {});
-    data.size = _allocator->getSize();
+    data.size = allocator.getSize();
+    if (allocator.isContiguous())
+    {
+        data.ptr = std::shared_ptr<const void>(allocator.getData(),
+                                               [](const void*) {});
+        return data;
+    }
+
+    // assemble a contiguous copy of the segments
+    std::shared_ptr<uint8_t> buffer(new uint8_t[data.size],
+                                    std::default_delete<uint8_t[]>());
+    uint8_t* iter = buffer.get();
+    for (const DynamicRange& segment : toBinarySegments())
+    {
+        ::memcpy(iter, segment.data, segment.size);
+        iter += segment.size;
+    }
+    data.ptr = buffer;
     return data;
 }
 
+Data Zerobuf::_freeze() const
+{
+    Data data;
+    if (!_allocator)
+        return data;
+
+    if (_allocator.get() == &_storage)
+    {
+        data.ptr = _storage.share();
+        data.size = _storage.getSize();
+        return data;
+    }
+
+    const Data& binary = toBinary();
+    std::shared_ptr<uint8_t> copy(new uint8_t[binary.size],
+                                  std::default_delete<uint8_t[]>());
+    ::memcpy(copy.get(), binary.ptr.get(), binary.size);
+    data.ptr = copy;
+    data.size = binary.size;
+    return data;
+}
+
+std::vector<DynamicRange> Zerobuf::toBinarySegments() const
+{
+    std::vector<DynamicRange> segments;
+    if (!_allocator)
+        return segments;
+
+    _allocator->flushCompaction();
+    const Allocator& allocator = *_allocator;
+    if (allocator.isContiguous())
+    {
+        segments.push_back(
+            DynamicRange{allocator.getData(), allocator.getSize()});
+        return segments;
+    }
+
+    // static section, followed by the dynamic members in the binary order
+    std::vector<size_t> members;
+    for (size_t i = 0; i < getZerobufNumDynamics(); ++i)
+        if (allocator.getDynamicSize(i) > 0)
+            members.push_back(i);
+    std::sort(members.begin(), members.end(),
+              [&allocator](const size_t lhs, const size_t rhs) {
+                  return allocator.getDynamicOffset(lhs) <
+                         allocator.getDynamicOffset(rhs);
+              });
+
+    uint64_t end = getZerobufStaticSize();
+    segments.push_back(DynamicRange{allocator.getData(), size_t(end)});
+    for (const size_t i : members)
+    {
+        const uint64_t offset = allocator.getDynamicOffset(i);
+        const size_t size = allocator.getDynamicSize(i);
+        _appendPadding(segments, offset - end);
+        segments.push_back(
+            DynamicRange{allocator.getDynamic<uint8_t>(i), size});
+        end = offset + size;
+    }
+    _appendPadding(segments, allocator.getSize() - end);
+    return segments;
+}
+
+void Zerobuf::canonicalize()
+{
+    if (!_allocator || isCanonical())
+        return;
+
+    std::vector<uint8_t> buffer;
+    toCanonicalBinary(buffer);
+    _allocator->copyBuffer(buffer.data(), buffer.size());
+}
+
+bool Zerobuf::isCanonical() const
+{
+    if (!_allocator)
+        return true;
+
+    const Allocator& allocator = *_allocator;
+    const size_t alignment = allocator.getAlignment();
+    uint64_t end = getZerobufStaticSize();
+    for (size_t i = 0; i < getZerobufNumDynamics(); ++i)
+    {
+        const uint64_t offset = allocator.getDynamicOffset(i);
+        const uint64_t size = allocator.getDynamicSize(i);
+        if (size == 0)
+        {
+            if (offset != 0)
+                return false;
+            continue;
+        }
+
+        if (offset != _align(end, alignment))
+            return false;
+        // padding of non-contiguous allocators is not stored
+        if (allocator.isContiguous() &&
+            !_isZero(allocator.getData() + end, offset - end))
+        {
+            return false;
+        }
+        const Zerobuf* nested = _getNestedZerobuf(i);
+        if (nested && !nested->isCanonical())
+            return false;
+        end = offset + size;
+    }
+    return allocator.getSize() == end;
+}
+
+void Zerobuf::toCanonicalBinary(std::vector<uint8_t>& out) const
+{
+    out.clear();
+    if (_allocator)
+    {
+        out.reserve(_allocator->getSize());
+        _appendCanonical(out);
+    }
+}
+
+void Zerobuf::_appendCanonical(std::vector<uint8_t>& out) const
+{
+    const Allocator& allocator = *_allocator;
+    const size_t alignment = allocator.getAlignment();
+    const size_t base = out.size();
+    const uint8_t* data = allocator.getData();
+    out.insert(out.end(), data, data + getZerobufStaticSize());
+
+    for (size_t i = 0; i < getZerobufNumDynamics(); ++i)
+    {
+        uint64_t header[2] = {0, 0}; // offset, size
+        const size_t size = allocator.getDynamicSize(i);
+        if (size > 0)
+        {
+            const uint64_t offset = _align(out.size() - base, alignment);
+            out.resize(base + offset, 0);
+            const Zerobuf* nested = _getNestedZerobuf(i);
+            if (nested)
+                nested->_appendCanonical(out);
+            else
+            {
+                const uint8_t* dynamic = allocator.getDynamic<uint8_t>(i);
+                out.insert(out.end(), dynamic, dynamic + size);
+            }
+            header[0] = offset;
+            header[1] = out.size() - base - offset;
+        }
+        ::memcpy(out.data() + base + 4 + i * 16, header, sizeof(header));
+    }
+}
+
+const Zerobuf* Zerobuf::_getNestedZerobuf(size_t) const
+{
+    return nullptr;
+}
+
 bool Zerobuf::_fromJSON(const std::string& string)
 {
     if (!_allocator)
@@ -187,6 +487,48 @@ void Zerobuf::reset(AllocatorPtr allocator)
     _allocator.swap(allocator);
 }
 
+bool Zerobuf::hasEmbeddedAllocator() const
+{
+    return _allocator && !_allocator.get_deleter().owner &&
+           _allocator.get() != &_storage;
+}
+
+void Zerobuf::_useStorage()
+{
+    if (_allocator.get() != &_storage)
+        _allocator = AllocatorPtr(&_storage, AllocatorDeleter(false));
+}
+
+void Zerobuf::_copyFrom(const Zerobuf& rhs)
+{
+    const Allocator& from = *rhs._allocator; // rhs may be a ConstAllocator
+    if (from.isContiguous())
+        _allocator->copyBuffer(from.getData(), from.getSize());
+    else
+    {
+        const Data data = rhs._toBinary();
+        _allocator->copyBuffer(data.ptr.get(), data.size);
+    }
+}
+
+void Zerobuf::_moveFrom(Zerobuf& rhs)
+{
+    // rhs keeps a lazy allocator, allocated only once it is accessed again
+    if (rhs._allocator.get() == &rhs._storage)
+        _storage.moveFrom(rhs._storage);
+    else
+    {
+        const size_t alignment = rhs._allocator->getAlignment();
+        _allocator = std::move(rhs._allocator);
+        _storage.reset(0, 0); // free unused own storage
+        rhs._storage.reset(rhs.getZerobufStaticSize(),
+                           rhs.getZerobufNumDynamics(), alignment);
+        rhs._useStorage();
+        return;
+    }
+    _useStorage();
+}
+
 Allocator& Zerobuf::getAllocator()
 {
     if (!_allocator)
@@ -203,6 +545,36 @@ const Allocator& Zerobuf::getAllocator() const
     return *_allocator;
 }
 
+bool Zerobuf::_hasChanged(const void* data, const size_t size,
+                          const size_t offset, const size_t length) const
+{
+    if (offset + length > size)
+        return true;
+
+    const uint8_t* newData = reinterpret_cast<const uint8_t*>(data);
+    return ::memcmp(getAllocator().getData() + offset, newData + offset,
+                    length) != 0;
+}
+
+bool Zerobuf::_hasDynamicChanged(const void* data, const size_t size,
+                                 const size_t index) const
+{
+    const size_t headerOffset = 4 + index * 16;
+    if (headerOffset + 16 > size)
+        return true;
+
+    const uint8_t* newData = reinterpret_cast<const uint8_t*>(data);
+    uint64_t header[2]; // offset, size
+    ::memcpy(header, newData + headerOffset, sizeof(header));
+
+    const Allocator& allocator = getAllocator();
+    const uint64_t oldSize = allocator.getDynamicSize(index);
+    if (header[1] != oldSize || header[0] > size || oldSize > size - header[0])
+        return true;
+    return ::memcmp(allocator.getDynamic<uint8_t>(index), newData + header[0],
+                    oldSize) != 0;
+}
+
 void Zerobuf::_copyZerobufArray(const void* data, const size_t size,
                                 const size_t arrayNum)
 {
@@ -10,10 +10,13 @@
 #include <servus/serializable.h> // base class
 #include <servus/uint128_t.h>    // used inline in operator <<
 #include <zerobuf/Allocator.h>   // MSVC needs it for std::unique_ptr
+#include <zerobuf/LazyAllocator.h> // member
 #include <zerobuf/api.h>
 #include <zerobuf/json.h> // friend
 #include <zerobuf/types.h>
 
+#include <vector>
+
 namespace zerobuf
 {
 /**
@@ -46,13 +49,32 @@ public:
      */
     ZEROBUF_API virtual void compact(float threshold = 0.1f);
 
+    /**
+     * Compact this object automatically according to the given policy.
+     *
+     * The policy is kept on assignment and taken over by move construction.
+     * Members of this object are compacted as part of it. A deferred
+     * compaction modifies the buffer in toBinary(), which is then not
+     * thread-safe anymore.
+     *
+     * @throw std::runtime_error if this object is a member of another zerobuf
+     *        or does not support compaction.
+     */
+    ZEROBUF_API void setCompactionPolicy(const CompactionPolicy& policy);
+
     /** Assignment operator. */
     ZEROBUF_API Zerobuf& operator=(const Zerobuf& rhs);
 
-    /** Move ctor. */
+    /**
+     * Move ctor. Does not allocate; rhs is allocated again on its next
+     * access. Copies the data of embedded sub-objects.
+     */
     ZEROBUF_API Zerobuf(Zerobuf&& rhs);
 
-    /** Move operator. May copy data if zerobuf is not movable */
+    /**
+     * Move operator. Does not allocate, but may copy data if zerobuf is not
+     * movable.
+     */
     ZEROBUF_API Zerobuf& operator=(Zerobuf&& rhs);
 
     /** @return true if both objects contain the same data */
@@ -61,6 +83,65 @@ public:
     /** @return true if both objects contain different data */
     ZEROBUF_API bool operator!=(const Zerobuf& rhs) const;
 
+    /**
+     * Take over a binary zerobuf buffer without copying it.
+     *
+     * The buffer is validated and then used as the storage of this object,
+     * unless this object is a member of another zerobuf, uses a custom
+     * allocator or the buffer does not have the alignment of this object; in
+     * that case the data is copied and the buffer is released after the copy
+     * succeeded. Does not emit Qt signals.
+     *
+     * @param data the zerobuf binary
+     * @param size the size of the binary
+     * @param deleter releases data, ::free() is used if empty
+     * @return true on success, false on a version mismatch. The caller keeps
+     *         the ownership of data if false is returned or an exception is
+     *         thrown.
+     * @throw std::runtime_error if the buffer is invalid or this object is
+     *        read-only.
+     */
+    ZEROBUF_API bool adoptBinary(uint8_t* data, size_t size,
+                                 BufferDeleter deleter = BufferDeleter());
+
+    /**
+     * @return the binary of this object as a scatter-gather list of ranges.
+     *
+     * The list contains a single range unless the allocator stores the
+     * dynamic members separately, e.g., the SegmentedAllocator, in which case
+     * toBinary() has to assemble a copy. The ranges are layout-compatible with
+     * struct iovec and valid until this object is modified.
+     */
+    ZEROBUF_API std::vector<DynamicRange> toBinarySegments() const;
+
+    /**
+     * Rewrite this object into its canonical binary layout.
+     *
+     * The canonical layout holds the dynamic members in schema order at the
+     * next aligned offset after the previous member, without holes and with
+     * zeroed padding, recursively for nested tables. Logically equal objects
+     * have the same canonical binary, which can be hashed and compared
+     * bytewise. Does not emit Qt signals.
+     *
+     * @throw std::runtime_error if this object is read-only and not canonical.
+     */
+    ZEROBUF_API void canonicalize();
+
+    /**
+     * @return true if the binary of this object is in the canonical layout.
+     *         Does not allocate. @sa canonicalize()
+     */
+    ZEROBUF_API bool isCanonical() const;
+
+    /**
+     * Write the canonical binary of this object without modifying it.
+     *
+     * @param out replaced by the canonical binary, may be reused between
+     *            calls to avoid allocations.
+     * @sa canonicalize()
+     */
+    ZEROBUF_API void toCanonicalBinary(std::vector<uint8_t>& out) const;
+
     /** @internal */
     ZEROBUF_API void reset(AllocatorPtr allocator);
 
@@ -71,11 +152,70 @@ protected:
     ZEROBUF_API explicit Zerobuf(AllocatorPtr alloc); // takes ownership of
                                                       // alloc
 
+    /** Construct with own storage initialized from the given static image. */
+    ZEROBUF_API Zerobuf(const uint8_t* image, size_t staticSize,
+                        size_t numDynamic, size_t alignment = 1);
+
+    /**
+     * Construct with own storage holding the given static image and dynamic
+     * members in a single, compact allocation. Used by generated builders.
+     */
+    ZEROBUF_API Zerobuf(const uint8_t* image, const DynamicRange* dynamics,
+                        size_t staticSize, size_t numDynamic,
+                        size_t alignment = 1);
+
+    /**
+     * Construct with own storage in the given inline buffer, initialized from
+     * the given static image. Data exceeding the buffer spills to the heap.
+     * Used by generated classes of small, static-only tables.
+     */
+    ZEROBUF_API Zerobuf(uint8_t* inlineData, size_t inlineSize,
+                        const uint8_t* image, size_t staticSize,
+                        size_t numDynamic, size_t alignment = 1);
+
+    /** Move ctor of objects with inline storage, copies inline data of rhs. */
+    ZEROBUF_API Zerobuf(Zerobuf&& rhs, uint8_t* inlineData, size_t inlineSize);
+
     /** Called if any data in this object has changed. */
     ZEROBUF_API virtual void notifyChanged() {}
     // used by generated ZeroBuf objects
     ZEROBUF_API const Allocator& getAllocator() const;
     ZEROBUF_API Allocator& getAllocator();
+    /** @return true if the allocator is embedded in a parent object. */
+    ZEROBUF_API bool hasEmbeddedAllocator() const;
+
+    /**
+     * Share the data of this object with an immutable snapshot, used by the
+     * generated freeze().
+     *
+     * Objects using their own storage share it and copy it on their next
+     * modification while the snapshot is alive. Views and members of other
+     * zerobufs share a copy.
+     *
+     * @return the binary of the snapshot, owned by the returned data.
+     */
+    ZEROBUF_API Data _freeze() const;
+
+    /**
+     * @return the object of the nested table stored in the given dynamic
+     *         member, or nullptr for other members. Overridden by generated
+     *         tables with nested dynamic tables.
+     */
+    ZEROBUF_API virtual const Zerobuf* _getNestedZerobuf(size_t index) const;
+
+    /**
+     * @return true if the static range at offset differs between this object
+     *         and the given binary data, used by generated _fromBinary().
+     */
+    ZEROBUF_API bool _hasChanged(const void* data, size_t size, size_t offset,
+                                 size_t length) const;
+
+    /**
+     * @return true if the dynamic member at index differs in size or content
+     *         between this object and the given binary data.
+     */
+    ZEROBUF_API bool _hasDynamicChanged(const void* data, size_t size,
+                                        size_t index) const;
 
     ZEROBUF_API void _copyZerobufArray(const void* data, size_t size,
                                        size_t arrayNum);
@@ -84,11 +224,14 @@ protected:
     ZEROBUF_API virtual void _createJSON(Json::Value& json) const;
     ZEROBUF_API friend void fromJSON(const Json::Value&, Zerobuf&);
     ZEROBUF_API friend void toJSON(const Zerobuf&, Json::Value&);
+    friend class BinaryStreamReader;
+    friend class BinaryStreamWriter;
 
     ZEROBUF_API bool _fromBinary(const void* data, const size_t size) override;
 
 private:
-    AllocatorPtr _allocator;
+    LazyAllocator _storage;  // own storage, unused by views
+    AllocatorPtr _allocator; // &_storage or the allocator of a view
 
     Zerobuf() = delete;
     Zerobuf(const Zerobuf& zerobuf) = delete;
@@ -96,6 +239,12 @@ private:
     ZEROBUF_API Data _toBinary() const final;
     ZEROBUF_API bool _fromJSON(const std::string& json) final;
     ZEROBUF_API std::string _toJSON() const final;
+
+    void _useStorage();
+    void _copyFrom(const Zerobuf& rhs);
+    void _moveConstruct(Zerobuf& rhs);
+    void _moveFrom(Zerobuf& rhs);
+    void _appendCanonical(std::vector<uint8_t>& out) const;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Zerobuf& zerobuf)
@@ -0,0 +1,166 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEROBUF_ATOMIC_H
+#define ZEROBUF_ATOMIC_H
+
+#include <zerobuf/Allocator.h> // used inline
+#include <zerobuf/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+namespace zerobuf
+{
+/** @cond IGNORE atomic operations on zerobuf storage used by generated code */
+namespace detail
+{
+template <class T>
+inline T* checkAtomic(T* ptr)
+{
+    static_assert(sizeof(T) <= 8 && (sizeof(T) & (sizeof(T) - 1)) == 0,
+                  "Atomic access needs a 1, 2, 4 or 8 byte type");
+    if (reinterpret_cast<uintptr_t>(ptr) % sizeof(T) != 0)
+        throw std::runtime_error("Unaligned atomic zerobuf access");
+    return ptr;
+}
+
+inline std::memory_order failureOrder(const std::memory_order order)
+{
+    switch (order)
+    {
+    case std::memory_order_acq_rel:
+        return std::memory_order_acquire;
+    case std::memory_order_release:
+        return std::memory_order_relaxed;
+    default:
+        return order;
+    }
+}
+
+#ifdef __GNUC__
+inline int builtinOrder(const std::memory_order order)
+{
+    switch (order)
+    {
+    case std::memory_order_relaxed:
+        return __ATOMIC_RELAXED;
+    case std::memory_order_consume:
+        return __ATOMIC_CONSUME;
+    case std::memory_order_acquire:
+        return __ATOMIC_ACQUIRE;
+    case std::memory_order_release:
+        return __ATOMIC_RELEASE;
+    case std::memory_order_acq_rel:
+        return __ATOMIC_ACQ_REL;
+    default:
+        return __ATOMIC_SEQ_CST;
+    }
+}
+#else
+// std::atomic< T > has the size and representation of T for lock-free types
+template <class T>
+inline std::atomic<T>* asAtomic(T* ptr)
+{
+    static_assert(sizeof(std::atomic<T>) == sizeof(T),
+                  "std::atomic< T > is not layout-compatible with T");
+    return reinterpret_cast<std::atomic<T>*>(ptr);
+}
+#endif
+}
+
+/**
+ * @return the item at the given offset for an atomic modification.
+ *
+ * Unlike Allocator::getItemPtr(), the storage is never allocated or copied,
+ * which would race with the concurrent atomic modifications of other threads.
+ *
+ * @throw std::runtime_error if the storage is not allocated yet, e.g., after
+ *        a move, or if it is shared with a frozen snapshot.
+ */
+template <class T>
+inline T* getAtomicItemPtr(Allocator& allocator, const size_t offset)
+{
+    if (!allocator.isMutable() || !allocator.isMaterialized())
+        throw std::runtime_error(
+            "Atomic modification of an unallocated or frozen zerobuf");
+    return allocator.getItemPtr<T>(offset);
+}
+
+/** Atomically load the value at ptr, which needs natural alignment. */
+template <class T>
+inline T atomicLoad(const T* ptr, const std::memory_order order)
+{
+    detail::checkAtomic(ptr);
+#ifdef __GNUC__
+    T value;
+    __atomic_load(const_cast<T*>(ptr), &value, detail::builtinOrder(order));
+    return value;
+#else
+    return detail::asAtomic(const_cast<T*>(ptr))->load(order);
+#endif
+}
+
+/** Atomically store value at ptr, which needs natural alignment. */
+template <class T>
+inline void atomicStore(T* ptr, T value, const std::memory_order order)
+{
+    detail::checkAtomic(ptr);
+#ifdef __GNUC__
+    __atomic_store(ptr, &value, detail::builtinOrder(order));
+#else
+    detail::asAtomic(ptr)->store(value, order);
+#endif
+}
+
+/**
+ * Atomically replace the value at ptr with desired if it equals expected.
+ *
+ * @return true on success, false otherwise with expected set to the current
+ *         value.
+ */
+template <class T>
+inline bool atomicCompareExchange(T* ptr, T& expected, T desired,
+                                  const std::memory_order order)
+{
+    detail::checkAtomic(ptr);
+#ifdef __GNUC__
+    return __atomic_compare_exchange(
+        ptr, &expected, &desired, false /*strong*/, detail::builtinOrder(order),
+        detail::builtinOrder(detail::failureOrder(order)));
+#else
+    return detail::asAtomic(ptr)->compare_exchange_strong(
+        expected, desired, order, detail::failureOrder(order));
+#endif
+}
+
+/** Atomically add value to the integer at ptr. @return the previous value */
+template <class T>
+inline typename std::enable_if<std::is_integral<T>::value, T>::type
+    atomicFetchAdd(T* ptr, const T value, const std::memory_order order)
+{
+    detail::checkAtomic(ptr);
+#ifdef __GNUC__
+    return __atomic_fetch_add(ptr, value, detail::builtinOrder(order));
+#else
+    return detail::asAtomic(ptr)->fetch_add(value, order);
+#endif
+}
+
+/** Atomically add value to the float at ptr. @return the previous value */
+template <class T>
+inline typename std::enable_if<std::is_floating_point<T>::value, T>::type
+    atomicFetchAdd(T* ptr, const T value, const std::memory_order order)
+{
+    T expected = atomicLoad(ptr, std::memory_order_relaxed);
+    while (!atomicCompareExchange(ptr, expected, T(expected + value), order))
+        ;
+    return expected;
+}
+/** @endcond */
+}
+
+#endif
@@ -0,0 +1,223 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#include "columns.h"
+
+#include <cstring>
+#include <limits>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace zerobuf
+{
+namespace
+{
+// SIMD kernels use 32 bit byte offsets for up to 16 elements
+bool _hasSIMDStride(const size_t stride)
+{
+    return stride <= size_t(std::numeric_limits<int32_t>::max() / 16);
+}
+
+template <class T>
+void _gather(const uint8_t* src, const size_t stride, const size_t count,
+             T* column)
+{
+    for (size_t i = 0; i < count; ++i)
+        ::memcpy(column + i, src + i * stride, sizeof(T));
+}
+
+template <class T>
+void _scatter(const T* column, const size_t count, uint8_t* dst,
+              const size_t stride)
+{
+    for (size_t i = 0; i < count; ++i)
+        ::memcpy(dst + i * stride, column + i, sizeof(T));
+}
+
+size_t _gatherSIMD(const uint8_t* src, const size_t stride, const size_t count,
+                   uint32_t* column)
+{
+    size_t i = 0;
+#ifdef __AVX2__
+    const int s = int(stride);
+    const __m256i offsets = _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s,
+                                              6 * s, 7 * s);
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i values = _mm256_i32gather_epi32(
+            reinterpret_cast<const int*>(src + i * stride), offsets, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(column + i), values);
+    }
+#else
+    (void)src;
+    (void)stride;
+    (void)count;
+    (void)column;
+#endif
+    return i;
+}
+
+size_t _gatherSIMD(const uint8_t* src, const size_t stride, const size_t count,
+                   uint64_t* column)
+{
+    size_t i = 0;
+#ifdef __AVX2__
+    const int s = int(stride);
+    const __m128i offsets = _mm_setr_epi32(0, s, 2 * s, 3 * s);
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m256i values = _mm256_i32gather_epi64(
+            reinterpret_cast<const long long*>(src + i * stride), offsets, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(column + i), values);
+    }
+#else
+    (void)src;
+    (void)stride;
+    (void)count;
+    (void)column;
+#endif
+    return i;
+}
+
+size_t _scatterSIMD(const uint32_t* column, const size_t count, uint8_t* dst,
+                    const size_t stride)
+{
+    size_t i = 0;
+#ifdef __AVX512F__
+    const int s = int(stride);
+    const __m512i offsets =
+        _mm512_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s, 8 * s,
+                          9 * s, 10 * s, 11 * s, 12 * s, 13 * s, 14 * s,
+                          15 * s);
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m512i values = _mm512_loadu_si512(column + i);
+        _mm512_i32scatter_epi32(dst + i * stride, offsets, values, 1);
+    }
+#else
+    (void)column;
+    (void)count;
+    (void)dst;
+    (void)stride;
+#endif
+    return i;
+}
+
+size_t _scatterSIMD(const uint64_t* column, const size_t count, uint8_t* dst,
+                    const size_t stride)
+{
+    size_t i = 0;
+#ifdef __AVX512F__
+    const int s = int(stride);
+    const __m256i offsets = _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s,
+                                              6 * s, 7 * s);
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m512i values = _mm512_loadu_si512(column + i);
+        _mm512_i32scatter_epi64(dst + i * stride, offsets, values, 1);
+    }
+#else
+    (void)column;
+    (void)count;
+    (void)dst;
+    (void)stride;
+#endif
+    return i;
+}
+
+template <class T>
+void _gatherColumn(const uint8_t* src, const size_t stride, const size_t count,
+                   T* column)
+{
+    const size_t done =
+        _hasSIMDStride(stride) ? _gatherSIMD(src, stride, count, column) : 0;
+    _gather(src + done * stride, stride, count - done, column + done);
+}
+
+template <class T>
+void _scatterColumn(const T* column, const size_t count, uint8_t* dst,
+                    const size_t stride)
+{
+    const size_t done =
+        _hasSIMDStride(stride) ? _scatterSIMD(column, count, dst, stride) : 0;
+    _scatter(column + done, count - done, dst + done * stride, stride);
+}
+}
+
+void gatherColumn(const void* src, const size_t stride, const size_t fieldSize,
+                  const size_t count, void* column)
+{
+    if (count == 0)
+        return;
+
+    const uint8_t* from = reinterpret_cast<const uint8_t*>(src);
+    if (stride == fieldSize)
+    {
+        ::memcpy(column, from, count * fieldSize);
+        return;
+    }
+
+    switch (fieldSize)
+    {
+    case 1:
+        _gather(from, stride, count, reinterpret_cast<uint8_t*>(column));
+        return;
+    case 2:
+        _gather(from, stride, count, reinterpret_cast<uint16_t*>(column));
+        return;
+    case 4:
+        _gatherColumn(from, stride, count, reinterpret_cast<uint32_t*>(column));
+        return;
+    case 8:
+        _gatherColumn(from, stride, count, reinterpret_cast<uint64_t*>(column));
+        return;
+    default:
+    {
+        uint8_t* to = reinterpret_cast<uint8_t*>(column);
+        for (size_t i = 0; i < count; ++i)
+            ::memcpy(to + i * fieldSize, from + i * stride, fieldSize);
+    }
+    }
+}
+
+void scatterColumn(const void* column, const size_t fieldSize,
+                   const size_t count, void* dst, const size_t stride)
+{
+    if (count == 0)
+        return;
+
+    uint8_t* to = reinterpret_cast<uint8_t*>(dst);
+    if (stride == fieldSize)
+    {
+        ::memcpy(to, column, count * fieldSize);
+        return;
+    }
+
+    switch (fieldSize)
+    {
+    case 1:
+        _scatter(reinterpret_cast<const uint8_t*>(column), count, to, stride);
+        return;
+    case 2:
+        _scatter(reinterpret_cast<const uint16_t*>(column), count, to, stride);
+        return;
+    case 4:
+        _scatterColumn(reinterpret_cast<const uint32_t*>(column), count, to,
+                       stride);
+        return;
+    case 8:
+        _scatterColumn(reinterpret_cast<const uint64_t*>(column), count, to,
+                       stride);
+        return;
+    default:
+    {
+        const uint8_t* from = reinterpret_cast<const uint8_t*>(column);
+        for (size_t i = 0; i < count; ++i)
+            ::memcpy(to + i * stride, from + i * fieldSize, fieldSize);
+    }
+    }
+}
+}
@@ -0,0 +1,42 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEROBUF_COLUMNS_H
+#define ZEROBUF_COLUMNS_H
+
+#include <zerobuf/api.h>
+#include <zerobuf/types.h>
+
+namespace zerobuf
+{
+/**
+ * Copy a strided field into a contiguous column.
+ *
+ * Used to convert the array-of-structs layout of Vector elements into a
+ * structure-of-arrays column. Fields of 4 and 8 bytes use SIMD gather
+ * instructions when available.
+ *
+ * @param src pointer to the field of the first element
+ * @param stride distance in bytes between two consecutive fields
+ * @param fieldSize size of one field in bytes
+ * @param count number of fields to copy
+ * @param column output array of count * fieldSize bytes
+ */
+ZEROBUF_API void gatherColumn(const void* src, size_t stride, size_t fieldSize,
+                              size_t count, void* column);
+
+/**
+ * Copy a contiguous column into a strided field, the inverse of gatherColumn().
+ *
+ * @param column input array of count * fieldSize bytes
+ * @param fieldSize size of one field in bytes
+ * @param count number of fields to copy
+ * @param dst pointer to the field of the first element
+ * @param stride distance in bytes between two consecutive fields
+ */
+ZEROBUF_API void scatterColumn(const void* column, size_t fieldSize,
+                               size_t count, void* dst, size_t stride);
+}
+
+#endif
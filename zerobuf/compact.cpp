@@ -0,0 +1,250 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#include "compact.h"
+
+#include "Zerobuf.h"
+
+#include <cstring>
+#include <limits>
+
+namespace zerobuf
+{
+namespace
+{
+uint32_t _load32(const uint8_t* ptr)
+{
+    uint32_t value;
+    ::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+uint64_t _load64(const uint8_t* ptr)
+{
+    uint64_t value;
+    ::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+void _store32(std::vector<uint8_t>& out, const size_t pos, const size_t value)
+{
+    if (value > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("Zerobuf too large for compact format");
+    const uint32_t value32 = uint32_t(value);
+    ::memcpy(out.data() + pos, &value32, sizeof(value32));
+}
+
+size_t _getCompactStaticSize(const CompactLayout& layout)
+{
+    return layout.staticSize - 4 - layout.numDynamics * 16 -
+           layout.numVersions * 4;
+}
+
+const CompactLayout* _getDynamicLayout(const CompactLayout& layout,
+                                       const size_t index)
+{
+    return layout.dynamics ? layout.dynamics[index] : nullptr;
+}
+
+// static section without version, dynamic headers and nested versions
+void _stripStatic(const uint8_t* data, const CompactLayout& layout,
+                  std::vector<uint8_t>& out)
+{
+    size_t pos = 4 + layout.numDynamics * 16;
+    for (size_t i = 0; i < layout.numVersions; ++i)
+    {
+        const size_t version = layout.versionOffsets[i];
+        out.insert(out.end(), data + pos, data + version);
+        pos = version + 4;
+    }
+    out.insert(out.end(), data + pos, data + layout.staticSize);
+}
+
+// inverse of _stripStatic, with empty dynamic headers
+void _expandStatic(const uint8_t* data, const CompactLayout& layout,
+                   std::vector<uint8_t>& out)
+{
+    const uint32_t version = ZEROBUF_VERSION_ABI;
+    const uint8_t* versionBytes = reinterpret_cast<const uint8_t*>(&version);
+    out.insert(out.end(), versionBytes, versionBytes + 4);
+    out.resize(out.size() + layout.numDynamics * 16, 0);
+
+    size_t pos = 4 + layout.numDynamics * 16;
+    for (size_t i = 0; i < layout.numVersions; ++i)
+    {
+        const size_t num = layout.versionOffsets[i] - pos;
+        out.insert(out.end(), data, data + num);
+        out.insert(out.end(), versionBytes, versionBytes + 4);
+        data += num;
+        pos += num + 4;
+    }
+    out.insert(out.end(), data, data + layout.staticSize - pos);
+}
+
+void _compactTable(const uint8_t* data, size_t size,
+                   const CompactLayout& layout, std::vector<uint8_t>& out);
+void _expandTable(const uint8_t* data, size_t size,
+                  const CompactLayout& layout, std::vector<uint8_t>& out);
+
+void _compactMember(const uint8_t* data, const size_t size,
+                    const CompactLayout* layout, std::vector<uint8_t>& out)
+{
+    if (!layout || layout->staticSize == 0 || size == 0) // plain data
+    {
+        out.insert(out.end(), data, data + size);
+        return;
+    }
+    if (layout->numDynamics > 0) // nested table
+    {
+        _compactTable(data, size, *layout, out);
+        return;
+    }
+
+    // array of static tables
+    if (size % layout->staticSize != 0)
+        throw std::runtime_error("Invalid array of tables in zerobuf binary");
+    for (size_t i = 0; i < size; i += layout->staticSize)
+        _stripStatic(data + i, *layout, out);
+}
+
+void _expandMember(const uint8_t* data, const size_t size,
+                   const CompactLayout* layout, std::vector<uint8_t>& out)
+{
+    if (!layout || layout->staticSize == 0 || size == 0)
+    {
+        out.insert(out.end(), data, data + size);
+        return;
+    }
+    if (layout->numDynamics > 0)
+    {
+        _expandTable(data, size, *layout, out);
+        return;
+    }
+
+    const size_t elementSize = _getCompactStaticSize(*layout);
+    if (elementSize == 0 || size % elementSize != 0)
+        throw std::runtime_error("Invalid array of tables in compact binary");
+    for (size_t i = 0; i < size; i += elementSize)
+        _expandStatic(data + i, *layout, out);
+}
+
+void _compactTable(const uint8_t* data, const size_t size,
+                   const CompactLayout& layout, std::vector<uint8_t>& out)
+{
+    if (size < layout.staticSize)
+        throw std::runtime_error("Zerobuf binary too small for static section");
+
+    const size_t base = out.size();
+    out.resize(base + layout.numDynamics * 8);
+    _stripStatic(data, layout, out);
+
+    for (size_t i = 0; i < layout.numDynamics; ++i)
+    {
+        const uint64_t offset = _load64(data + 4 + i * 16);
+        const uint64_t dynamicSize = _load64(data + 4 + i * 16 + 8);
+        if (dynamicSize > 0 &&
+            (offset < layout.staticSize || offset + dynamicSize < offset ||
+             offset + dynamicSize > size))
+        {
+            throw std::runtime_error("Invalid dynamic #" + std::to_string(i) +
+                                     " in zerobuf binary");
+        }
+
+        const size_t begin = out.size();
+        _compactMember(data + offset, dynamicSize, _getDynamicLayout(layout, i),
+                       out);
+        const size_t compactSize = out.size() - begin;
+        _store32(out, base + i * 8, compactSize > 0 ? begin - base : 0);
+        _store32(out, base + i * 8 + 4, compactSize);
+    }
+}
+
+void _expandTable(const uint8_t* data, const size_t size,
+                  const CompactLayout& layout, std::vector<uint8_t>& out)
+{
+    const size_t headerSize = layout.numDynamics * 8;
+    const size_t staticEnd = headerSize + _getCompactStaticSize(layout);
+    if (size < staticEnd)
+        throw std::runtime_error("Compact binary too small for static section");
+
+    const size_t base = out.size();
+    _expandStatic(data + headerSize, layout, out);
+
+    for (size_t i = 0; i < layout.numDynamics; ++i)
+    {
+        const uint64_t offset = _load32(data + i * 8);
+        const uint64_t dynamicSize = _load32(data + i * 8 + 4);
+        if (dynamicSize == 0)
+            continue;
+        if (offset < staticEnd || offset + dynamicSize > size)
+            throw std::runtime_error("Invalid dynamic #" + std::to_string(i) +
+                                     " in compact binary");
+
+        const size_t alignment = layout.alignment;
+        const size_t begin =
+            base + (out.size() - base + alignment - 1) / alignment * alignment;
+        out.resize(begin, 0);
+        _expandMember(data + offset, dynamicSize, _getDynamicLayout(layout, i),
+                      out);
+
+        const uint64_t header[2] = {begin - base, out.size() - begin};
+        ::memcpy(out.data() + base + 4 + i * 16, header, sizeof(header));
+    }
+}
+}
+
+std::vector<uint8_t> toCompactBinary(const void* data, const size_t size,
+                                     const CompactLayout& layout)
+{
+    std::vector<uint8_t> out(sizeof(compactVersion));
+    ::memcpy(out.data(), &compactVersion, sizeof(compactVersion));
+    if (layout.staticSize == 0)
+        return out;
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    if (size < 4 || _load32(bytes) != ZEROBUF_VERSION_ABI)
+        throw std::runtime_error("Not a zerobuf v" +
+                                 std::to_string(ZEROBUF_VERSION_ABI) +
+                                 " binary");
+    out.reserve(size);
+    _compactTable(bytes, size, layout, out);
+    return out;
+}
+
+std::vector<uint8_t> fromCompactBinary(const void* data, const size_t size,
+                                       const CompactLayout& layout)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    const uint32_t version = size < 4 ? 0 : _load32(bytes);
+    if ((version & 0xffff0000u) != (compactVersion & 0xffff0000u))
+        throw std::runtime_error("Not a compact zerobuf binary");
+    if (version != compactVersion)
+        throw std::runtime_error("Version mismatch, got compact zerobuf v" +
+                                 std::to_string(version & 0xffffu) +
+                                 " running v" +
+                                 std::to_string(ZEROBUF_VERSION_ABI));
+
+    std::vector<uint8_t> out;
+    if (layout.staticSize == 0)
+        return out;
+
+    out.reserve(size + layout.numDynamics * 8 + layout.numVersions * 4);
+    _expandTable(bytes + 4, size - 4, layout, out);
+    return out;
+}
+
+std::vector<uint8_t> toCompactBinary(const Zerobuf& zerobuf,
+                                     const CompactLayout& layout)
+{
+    const Data& data = zerobuf.toBinary();
+    return toCompactBinary(data.ptr.get(), data.size, layout);
+}
+
+bool fromCompactBinary(Zerobuf& zerobuf, const CompactLayout& layout,
+                       const void* data, const size_t size)
+{
+    const std::vector<uint8_t> binary = fromCompactBinary(data, size, layout);
+    return zerobuf.fromBinary(binary.data(), binary.size());
+}
+}
@@ -0,0 +1,85 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEROBUF_COMPACT_H
+#define ZEROBUF_COMPACT_H
+
+#include <zerobuf/api.h>
+#include <zerobuf/types.h>
+#include <zerobuf/version.h>
+
+#include <vector>
+
+namespace zerobuf
+{
+/**
+ * Version tag of the compact wire format, distinct from ZEROBUF_VERSION_ABI of
+ * the standard layout.
+ */
+const uint32_t compactVersion = 0x435a0000u | ZEROBUF_VERSION_ABI; // 'ZC'
+
+/**
+ * Describes the standard binary layout of a zerobuf type for the conversion
+ * to and from the compact wire format.
+ *
+ * The compact format replaces the 64-bit offset and size of each dynamic
+ * member by 32-bit values and omits the version of nested tables, which saves
+ * 8 bytes per dynamic member and 4 bytes per nested table. It is a transport
+ * format only; objects always use the standard layout in memory.
+ *
+ * Layouts are generated for tables declared with the (compact) attribute.
+ */
+struct CompactLayout
+{
+    size_t staticSize;  //!< including the version and the dynamic headers
+    size_t numDynamics; //!< number of dynamic members
+    size_t alignment;   //!< of the dynamic members in the standard layout
+
+    /** Offsets of the versions of nested static tables in ascending order. */
+    const size_t* versionOffsets;
+    size_t numVersions;
+
+    /**
+     * Layout per dynamic member: nullptr for plain data, a table with dynamic
+     * members for a nested table, or a static table for an array of it.
+     */
+    const CompactLayout* const* dynamics;
+};
+
+/**
+ * Convert a binary in the standard layout to the compact format.
+ *
+ * @return the compact binary.
+ * @throw std::runtime_error if the binary is invalid or a dynamic member does
+ *        not fit into the 32-bit headers.
+ */
+ZEROBUF_API std::vector<uint8_t> toCompactBinary(const void* data, size_t size,
+                                                 const CompactLayout& layout);
+
+/**
+ * Convert a binary in the compact format to the standard layout.
+ *
+ * @return the standard binary, readable by Zerobuf::fromBinary().
+ * @throw std::runtime_error on a version mismatch or an invalid binary.
+ */
+ZEROBUF_API std::vector<uint8_t> fromCompactBinary(const void* data,
+                                                   size_t size,
+                                                   const CompactLayout& layout);
+
+/** @return the compact binary of the given zerobuf. @sa toCompactBinary() */
+ZEROBUF_API std::vector<uint8_t> toCompactBinary(const Zerobuf& zerobuf,
+                                                 const CompactLayout& layout);
+
+/**
+ * Set a zerobuf from a compact binary.
+ *
+ * @return the result of Zerobuf::fromBinary() on the converted binary.
+ * @throw std::runtime_error on a version mismatch or an invalid binary.
+ */
+ZEROBUF_API bool fromCompactBinary(Zerobuf& zerobuf,
+                                   const CompactLayout& layout,
+                                   const void* data, size_t size);
+}
+
+#endif
@@ -0,0 +1,361 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#include "compression.h"
+
+#include "Zerobuf.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace zerobuf
+{
+namespace
+{
+const uint32_t frameMagic = 0x5a425a43; // 'ZBZC'
+const size_t minZeroRun = 4;
+const size_t minMatch = 4;
+const unsigned maxHashBits = 14;
+const size_t maxDistance = 1 << 20;
+
+// Zero runs and matches are split into tokens of at most maxTokenLength
+// bytes, which take at least three bytes to encode. This bounds the size of
+// the uncompressed data announced by untrusted frames before allocating it.
+const size_t maxTokenLength = 1 << 16;
+const uint64_t maxRatio = maxTokenLength / 3 + 1;
+
+enum Token
+{
+    TOKEN_LITERAL = 0,
+    TOKEN_ZEROS = 1,
+    TOKEN_MATCH = 2
+};
+
+std::mutex _codecsMutex;
+std::map<uint128_t, Codec> _codecs;
+
+void _putVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(uint8_t(value));
+}
+
+uint64_t _getVarint(const uint8_t*& in, const uint8_t* end)
+{
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        if (in == end)
+            throw std::runtime_error("Truncated compressed zerobuf");
+        const uint8_t byte = *in++;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+    throw std::runtime_error("Invalid varint in compressed zerobuf");
+}
+
+uint32_t _load32(const uint8_t* ptr)
+{
+    uint32_t value;
+    ::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+uint32_t _hash(const uint32_t value, const unsigned bits)
+{
+    return (value * 2654435761u) >> (32 - bits);
+}
+
+void _putLiteral(std::vector<uint8_t>& out, const uint8_t* data,
+                 const size_t size)
+{
+    if (size == 0)
+        return;
+    _putVarint(out, (uint64_t(size) << 2) | TOKEN_LITERAL);
+    out.insert(out.end(), data, data + size);
+}
+
+void _encode(const uint8_t* in, const size_t size, const bool useMatches,
+             std::vector<uint8_t>& out)
+{
+    // small inputs use a small table to bound the setup cost
+    unsigned hashBits = 8;
+    while (hashBits < maxHashBits && (size_t(1) << hashBits) < size)
+        ++hashBits;
+    std::vector<size_t> table(useMatches ? size_t(1) << hashBits : 0);
+    size_t literal = 0;
+    size_t i = 0;
+
+    while (i < size)
+    {
+        if (in[i] == 0)
+        {
+            size_t end = i + 1;
+            while (end < size && end - i < maxTokenLength && in[end] == 0)
+                ++end;
+            if (end - i >= minZeroRun)
+            {
+                _putLiteral(out, in + literal, i - literal);
+                _putVarint(out, (uint64_t(end - i) << 2) | TOKEN_ZEROS);
+                i = literal = end;
+                continue;
+            }
+        }
+
+        if (useMatches && i + minMatch <= size)
+        {
+            const uint32_t value = _load32(in + i);
+            size_t& entry = table[_hash(value, hashBits)];
+            const size_t candidate = entry; // position + 1, 0 if unused
+            entry = i + 1;
+
+            if (candidate > 0 && i + 1 - candidate <= maxDistance &&
+                _load32(in + candidate - 1) == value)
+            {
+                const size_t from = candidate - 1;
+                size_t length = minMatch;
+                while (i + length < size && length < maxTokenLength &&
+                       in[from + length] == in[i + length])
+                {
+                    ++length;
+                }
+
+                _putLiteral(out, in + literal, i - literal);
+                _putVarint(out, (uint64_t(length) << 2) | TOKEN_MATCH);
+                _putVarint(out, i - from);
+                i = literal = i + length;
+                continue;
+            }
+        }
+        ++i;
+    }
+    _putLiteral(out, in + literal, size - literal);
+}
+
+void _decode(const uint8_t* in, const uint8_t* end, uint8_t* out,
+             const size_t size)
+{
+    size_t pos = 0;
+    while (in < end)
+    {
+        const uint64_t token = _getVarint(in, end);
+        const uint64_t length = token >> 2;
+        if (length > size - pos)
+            throw std::runtime_error("Compressed zerobuf exceeds its size");
+        if ((token & 3) != TOKEN_LITERAL && length > maxTokenLength)
+            throw std::runtime_error("Invalid token in compressed zerobuf");
+
+        switch (token & 3)
+        {
+        case TOKEN_LITERAL:
+            if (length > uint64_t(end - in))
+                throw std::runtime_error("Truncated compressed zerobuf");
+            ::memcpy(out + pos, in, length);
+            in += length;
+            break;
+        case TOKEN_ZEROS:
+            ::memset(out + pos, 0, length);
+            break;
+        case TOKEN_MATCH:
+        {
+            const uint64_t distance = _getVarint(in, end);
+            if (distance == 0 || distance > pos)
+                throw std::runtime_error("Invalid match in compressed zerobuf");
+            const uint8_t* from = out + pos - distance;
+            uint8_t* to = out + pos;
+            if (distance >= length)
+                ::memcpy(to, from, length);
+            else // overlapping, repeats the last distance bytes
+                for (uint64_t i = 0; i < length; ++i)
+                    to[i] = from[i];
+            break;
+        }
+        default:
+            throw std::runtime_error("Invalid token in compressed zerobuf");
+        }
+        pos += length;
+    }
+    if (pos != size)
+        throw std::runtime_error("Truncated compressed zerobuf");
+}
+
+/**
+ * Parse the header of a compressed frame and advance in to its payload.
+ *
+ * @return the size of the uncompressed data
+ */
+uint64_t _readFrameHeader(const uint8_t*& in, const uint8_t* end,
+                          Codec& codec)
+{
+    if (size_t(end - in) < sizeof(frameMagic) + 2 ||
+        _load32(in) != frameMagic)
+    {
+        throw std::runtime_error("Not a compressed zerobuf");
+    }
+    in += sizeof(frameMagic);
+
+    codec = Codec(*in++);
+    const uint64_t rawSize = _getVarint(in, end);
+    if (codec == Codec::none)
+    {
+        if (rawSize != uint64_t(end - in))
+            throw std::runtime_error("Truncated compressed zerobuf");
+    }
+    else if (codec != Codec::zeroRun && codec != Codec::lz)
+        throw std::runtime_error("Unknown zerobuf compression codec");
+    else if (rawSize > uint64_t(end - in) * maxRatio)
+        throw std::runtime_error("Invalid size of compressed zerobuf");
+    return rawSize;
+}
+
+/**
+ * @return a copy of the binary zerobuf data with the holes between its
+ *         dynamic allocations zeroed, or an empty vector if there are none.
+ */
+std::vector<uint8_t> _zeroHoles(const Zerobuf& zerobuf, const uint8_t* data,
+                                const size_t size)
+{
+    const size_t staticSize = zerobuf.getZerobufStaticSize();
+    const size_t numDynamics = zerobuf.getZerobufNumDynamics();
+    if (numDynamics == 0 || size <= staticSize)
+        return std::vector<uint8_t>();
+
+    std::vector<std::pair<uint64_t, uint64_t>> ranges; // offset, end
+    ranges.reserve(numDynamics);
+    for (size_t i = 0; i < numDynamics; ++i)
+    {
+        uint64_t header[2]; // offset, size
+        ::memcpy(header, data + 4 + i * 16, sizeof(header));
+        if (header[1] > 0)
+            ranges.emplace_back(header[0], header[0] + header[1]);
+    }
+    std::sort(ranges.begin(), ranges.end());
+
+    std::vector<std::pair<uint64_t, uint64_t>> holes;
+    uint64_t used = staticSize;
+    for (const auto& range : ranges)
+    {
+        if (range.first > used && used < size)
+            holes.emplace_back(used, std::min(range.first, uint64_t(size)));
+        used = std::max(used, range.second);
+    }
+    if (used < size)
+        holes.emplace_back(used, size);
+    if (holes.empty())
+        return std::vector<uint8_t>();
+
+    std::vector<uint8_t> copy(data, data + size);
+    for (const auto& hole : holes)
+        ::memset(copy.data() + hole.first, 0, hole.second - hole.first);
+    return copy;
+}
+}
+
+void setCodec(const uint128_t& typeIdentifier, const Codec codec)
+{
+    std::lock_guard<std::mutex> lock(_codecsMutex);
+    if (codec == Codec::none)
+        _codecs.erase(typeIdentifier);
+    else
+        _codecs[typeIdentifier] = codec;
+}
+
+Codec getCodec(const uint128_t& typeIdentifier)
+{
+    std::lock_guard<std::mutex> lock(_codecsMutex);
+    const auto i = _codecs.find(typeIdentifier);
+    return i == _codecs.end() ? Codec::none : i->second;
+}
+
+std::vector<uint8_t> compress(const Zerobuf& zerobuf)
+{
+    return compress(zerobuf, getCodec(zerobuf.getTypeIdentifier()));
+}
+
+std::vector<uint8_t> compress(const Zerobuf& zerobuf, const Codec codec)
+{
+    const Data& data = zerobuf.toBinary();
+    const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data.ptr.get());
+    if (codec == Codec::none)
+        return compress(ptr, data.size, codec);
+
+    const std::vector<uint8_t>& zeroed = _zeroHoles(zerobuf, ptr, data.size);
+    if (zeroed.empty())
+        return compress(ptr, data.size, codec);
+    return compress(zeroed.data(), zeroed.size(), codec);
+}
+
+std::vector<uint8_t> compress(const void* data, const size_t size,
+                              const Codec codec)
+{
+    const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data);
+    std::vector<uint8_t> out;
+    out.reserve(codec == Codec::none ? size + 16 : size / 2 + 16);
+
+    const uint8_t* magic = reinterpret_cast<const uint8_t*>(&frameMagic);
+    out.insert(out.end(), magic, magic + sizeof(frameMagic));
+    out.push_back(uint8_t(codec));
+    _putVarint(out, size);
+
+    switch (codec)
+    {
+    case Codec::none:
+        out.insert(out.end(), ptr, ptr + size);
+        break;
+    case Codec::zeroRun:
+        _encode(ptr, size, false, out);
+        break;
+    case Codec::lz:
+        _encode(ptr, size, true, out);
+        break;
+    default:
+        throw std::runtime_error("Unknown zerobuf compression codec");
+    }
+    return out;
+}
+
+std::vector<uint8_t> decompress(const void* data, const size_t size)
+{
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* end = in + size;
+    Codec codec;
+    const uint64_t rawSize = _readFrameHeader(in, end, codec);
+    if (codec == Codec::none)
+        return std::vector<uint8_t>(in, end);
+
+    std::vector<uint8_t> out(rawSize);
+    _decode(in, end, out.data(), out.size());
+    return out;
+}
+
+bool decompress(const void* data, const size_t size, Zerobuf& zerobuf)
+{
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* end = in + size;
+    Codec codec;
+    const uint64_t rawSize = _readFrameHeader(in, end, codec);
+    if (codec == Codec::none)
+        return zerobuf.fromBinary(in, rawSize);
+
+    // decode into a buffer adopted by the zerobuf, avoiding another copy
+    std::unique_ptr<uint8_t, void (*)(void*)> out(
+        (uint8_t*)::malloc(rawSize ? rawSize : 1), ::free);
+    if (!out)
+        throw std::bad_alloc();
+    _decode(in, end, out.get(), rawSize);
+    if (!zerobuf.adoptBinary(out.get(), rawSize))
+        return false;
+    out.release();
+    return true;
+}
+}
@@ -0,0 +1,73 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEROBUF_COMPRESSION_H
+#define ZEROBUF_COMPRESSION_H
+
+#include <zerobuf/api.h>
+#include <zerobuf/types.h>
+
+#include <vector>
+
+namespace zerobuf
+{
+/**
+ * Compression codecs for binary zerobufs.
+ *
+ * All codecs are implemented in ZeroBuf and produce a self-describing frame,
+ * so the receiver does not need to know the codec used by the sender.
+ */
+enum class Codec : uint8_t
+{
+    none,    //!< store the binary data verbatim
+    zeroRun, //!< eliminate runs of zero bytes
+    lz       //!< zero-run elimination and LZ77 back references
+};
+
+/** Set the codec used by compress() for the given zerobuf type. Thread safe. */
+ZEROBUF_API void setCodec(const uint128_t& typeIdentifier, Codec codec);
+
+/** @return the codec used for the given type, Codec::none by default. */
+ZEROBUF_API Codec getCodec(const uint128_t& typeIdentifier);
+
+/**
+ * Compress the binary representation of a zerobuf with the codec registered
+ * for its type.
+ *
+ * Unused holes in the dynamic storage are not transmitted.
+ *
+ * @return the compressed frame.
+ */
+ZEROBUF_API std::vector<uint8_t> compress(const Zerobuf& zerobuf);
+
+/** Compress a zerobuf with the given codec. @sa compress() */
+ZEROBUF_API std::vector<uint8_t> compress(const Zerobuf& zerobuf, Codec codec);
+
+/** @return a compressed frame of arbitrary binary data. */
+ZEROBUF_API std::vector<uint8_t> compress(const void* data, size_t size,
+                                          Codec codec);
+
+/**
+ * Decompress a frame created by compress().
+ *
+ * Frames announcing more uncompressed data than their codec can produce from
+ * their size are rejected before any allocation.
+ *
+ * @return the original binary data.
+ * @throw std::runtime_error if the frame is corrupt.
+ */
+ZEROBUF_API std::vector<uint8_t> decompress(const void* data, size_t size);
+
+/**
+ * Decompress a frame created by compress() into a zerobuf.
+ *
+ * The zerobuf adopts the decompressed data without copying it.
+ *
+ * @return the result of Zerobuf::adoptBinary() on the decompressed data.
+ * @throw std::runtime_error if the frame is corrupt.
+ */
+ZEROBUF_API bool decompress(const void* data, size_t size, Zerobuf& zerobuf);
+}
+
+#endif
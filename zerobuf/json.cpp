@@ -8,6 +8,8 @@
 #include "detail/base64.h"
 #include "jsoncpp/json/json.h"
 
+#include <stdexcept>
+
 namespace zerobuf
 {
 template <>
@@ -171,4 +173,33 @@ size_t getJSONSize(const Json::Value& json)
 {
     return json.size();
 }
+
+void forEachJSONField(
+    const Json::Value& json,
+    const std::function<void(const char*, size_t, const Json::Value&)>& visitor)
+{
+    if (json.isNull())
+        return;
+    if (!json.isObject())
+        throw std::runtime_error("JSON value is not an object");
+
+    for (Json::Value::const_iterator i = json.begin(); i != json.end(); ++i)
+    {
+        const char* end = nullptr;
+        const char* name = i.memberName(&end);
+        visitor(name, end - name, *i);
+    }
+}
+
+void getJSONString(const Json::Value& json, const char*& data, size_t& size)
+{
+    const char* end = nullptr;
+    if (json.getString(&data, &end))
+        size = end - data;
+    else
+    {
+        data = nullptr;
+        size = 0;
+    }
+}
 }
@@ -24,6 +24,56 @@ ZEROBUF_API const Json::Value& getJSONField(const Json::Value& json,
 ZEROBUF_API Json::Value& getJSONField(Json::Value& json, size_t index);
 ZEROBUF_API size_t getJSONSize(const Json::Value& json);
 
+/**
+ * Call the visitor with the name and the value of each field of a JSON object,
+ * without copying the names. Does nothing for null values.
+ * @throw std::runtime_error if json is not an object.
+ */
+ZEROBUF_API void forEachJSONField(
+    const Json::Value& json,
+    const std::function<void(const char*, size_t, const Json::Value&)>&
+        visitor);
+
+/** Get the characters of a JSON string, or nullptr and 0 for other values. */
+ZEROBUF_API void getJSONString(const Json::Value& json, const char*& data,
+                               size_t& size);
+
+/** @return the enum value named by a JSON string, without copying it. */
+template <class T>
+T enumFromJSON(const Json::Value& json)
+{
+    const char* data = nullptr;
+    size_t size = 0;
+    getJSONString(json, data, size);
+    return string_to_enum<T>(data, size);
+}
+
+/**
+ * @return the slot of a name in a perfect hash table generated by
+ *         zerobufCxx.py, using the displacement seeds of its buckets.
+ */
+inline size_t getJSONNameSlot(const char* name, const size_t size,
+                              const uint16_t* seeds, const size_t numSeeds,
+                              const size_t numSlots)
+{
+    // FNV-1a, finalized with the murmur3 mix for each seed
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= uint8_t(name[i]);
+        hash *= 16777619u;
+    }
+    const auto mix = [](uint32_t value) {
+        value ^= value >> 16;
+        value *= 0x85ebca6bu;
+        value ^= value >> 13;
+        value *= 0xc2b2ae35u;
+        return value ^ (value >> 16);
+    };
+    const uint32_t bucket = mix(hash) & uint32_t(numSeeds - 1);
+    return mix(hash ^ (seeds[bucket] * 0x9e3779b9u)) & (numSlots - 1);
+}
+
 template <class T>
 T fromJSON(const Json::Value& json);
 template <class T>
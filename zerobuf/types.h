@@ -6,6 +6,7 @@
 #ifndef ZEROBUF_TYPES_H
 #define ZEROBUF_TYPES_H
 
+#include <functional>
 #include <memory>
 #include <servus/serializable.h> // nested Data class
 #include <servus/types.h>
@@ -28,9 +29,79 @@ class Zerobuf;
 template <class T>
 class Vector;
 
-typedef std::unique_ptr<Allocator> AllocatorPtr;
+/**
+ * Deleter of AllocatorPtr.
+ *
+ * Generated classes embed the allocators of their nested members and hand out
+ * non-owning pointers to them, which are not deleted.
+ */
+struct AllocatorDeleter
+{
+    AllocatorDeleter()
+        : owner(true)
+    {
+    }
+    explicit AllocatorDeleter(const bool owner_)
+        : owner(owner_)
+    {
+    }
+    void operator()(Allocator* allocator) const; // defined in Allocator.h
+
+    bool owner; //!< delete the allocator
+};
+
+typedef std::unique_ptr<Allocator, AllocatorDeleter> AllocatorPtr;
 typedef std::unique_ptr<const Allocator> ConstAllocatorPtr;
 
+/** Releases a buffer adopted by a zerobuf. */
+typedef std::function<void(uint8_t*)> BufferDeleter;
+
+/** The source data of a dynamic member, used by generated builders. */
+struct DynamicRange
+{
+    const void* data; //!< the data to copy, zero-filled if nullptr
+    size_t size;      //!< the size in bytes
+};
+
+/**
+ * Policy for the automatic compaction of a zerobuf, see
+ * Zerobuf::setCompactionPolicy().
+ *
+ * The allocator tracks the used memory incrementally on each allocation. Once
+ * the unused memory exceeds highWatermark relative to the used memory, the
+ * dynamic members are moved to the front of the buffer and the allocation is
+ * shrunk, keeping lowWatermark relative free memory at its end for further
+ * growth. The gap between both watermarks avoids repeated compactions of
+ * objects with members growing and shrinking around the threshold.
+ */
+struct CompactionPolicy
+{
+    explicit CompactionPolicy(const float highWatermark_ = 0.f,
+                              const float lowWatermark_ = 0.f,
+                              const size_t budget_ = 0,
+                              const bool deferred_ = false)
+        : highWatermark(highWatermark_)
+        , lowWatermark(lowWatermark_)
+        , budget(budget_)
+        , deferred(deferred_)
+    {
+    }
+
+    float highWatermark; //!< unused/used ratio triggering, 0 disables
+    float lowWatermark;  //!< free/used ratio kept after compaction
+
+    /**
+     * Bytes moved at most by a compaction step during a modification, 0 for
+     * unlimited. A member larger than the budget is moved in a step of its
+     * own. Compaction continues on the next modifications until all members
+     * are compacted.
+     */
+    size_t budget;
+
+    /** Compact in toBinary() instead of during modifications. */
+    bool deferred;
+};
+
 using servus::uint128_t;
 typedef uint8_t byte_t; //!< alias type for base64 encoded fields
 
@@ -40,6 +111,8 @@ template <typename T>
 std::string enum_to_string(const T&);
 template <typename T>
 T string_to_enum(const std::string&);
+template <typename T>
+T string_to_enum(const char* data, size_t size);
 }
 
 namespace Json